@@ -0,0 +1,951 @@
+/**
+ * bench.c - Headless routing benchmark
+ *
+ * Builds synthetic graphs of a few shapes and sizes, runs one seeded query
+ * set per graph through every search engine and prints a CSV row per
+ * graph and engine on stdout (progress goes to stderr):
+ *
+ *   graph,nodes,edges,engine,queries,found,prep_ms,p50_us,p99_us,mean_explored,qps,cost_sum
+ *
+ * prep_ms is the preprocessing the engine needs on top of the Graph
+ * (freeze, landmarks, contraction), p50/p99 are per-query latencies,
+ * mean_explored averages AStarStats.nodesExplored and cost_sum adds up the
+ * costs of the routes found, so engines that disagree stand out. Matrix
+ * rows time one MATRIX_SIDE x MATRIX_SIDE table per sample. The last rows
+ * time the infrastructure around the engines: route cache hits, snapshot
+ * publish plus acquire after a one-edge change (with the route found on
+ * the snapshot), and FILE_RUNS whole-graph CSV imports and RCGRAPH2 loads
+ * (explored is then the edge count).
+ *
+ * Everything is seeded: the same flags give the same graphs and queries,
+ * so two commits can be compared row by row.
+ *
+ * Every route engine must find the same routes as Dijkstra (query by
+ * query, costs within COST_TOLERANCE), matrix-ch the same tables as
+ * matrix-dijkstra, and the file engines the graph's total edge weight.
+ * Disagreements are reported on stderr and make the exit status 1, so a
+ * wrong result fails the run without anyone reading the CSV.
+ *
+ * Usage: routecraft-bench [-q] [-n queries] [-s seed] [-o file] [-m file]
+ *   -q  quick run (smallest size of each shape only)
+ *   -o  also write the CSV to file
+ *   -m  write the process-wide counters (metrics.h) to file at the end;
+ *       they are only filled in builds with ASTAR_COUNTERS
+ */
+
+#include "graph.h"
+#include "astar.h"
+#include "landmarks.h"
+#include "ch.h"
+#include "crp.h"
+#include "dstar.h"
+#include "spt.h"
+#include "matrix.h"
+#include "batch.h"
+#include "metrics.h"
+#include "routecache.h"
+#include "snapshot.h"
+#include "import.h"
+#include "graphfile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DEFAULT_QUERIES 200
+#define DEFAULT_SEED    1
+#define LANDMARK_COUNT  16
+#define MATRIX_SIDE     16
+#define CELL_SIZE       20.0f
+#define FILE_RUNS       5     // Samples of the engines that read a whole file
+#define COST_TOLERANCE  1e-4f // Relative difference allowed between two engines' costs
+
+// Scratch files of the file engines, in the working directory and removed
+// after each run
+#define BENCH_NODES_CSV "routecraft-bench-nodes.csv"
+#define BENCH_EDGES_CSV "routecraft-bench-edges.csv"
+#define BENCH_RCG2      "routecraft-bench.rcg2"
+
+// ============================================================================
+// Seeded generators
+// ============================================================================
+
+static unsigned long long benchRng;
+static FILE* benchOut;       // Copy of the CSV (-o), or NULL
+
+static unsigned int bench_rand(void) {
+    benchRng = benchRng * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned int)(benchRng >> 33);
+}
+
+// Uniform in [0, 1)
+static float bench_randf(void) {
+    return (float)(bench_rand() & 0xFFFFFF) / 16777216.0f;
+}
+
+static int bench_add_node(Graph* graph, float x, float y) {
+    char name[32];
+    snprintf(name, sizeof(name), "N%d", graph->nodeCount);
+    return graph_add_node(graph, name, x, y);
+}
+
+static float bench_distance(const Graph* graph, int a, int b) {
+    return graph_calculate_distance(&graph->nodes[a], &graph->nodes[b]);
+}
+
+// Square grid with 4-neighbour two-way streets, weights 1-2x the length
+static bool gen_grid(Graph* graph, int nodeCount) {
+    int side = (int)sqrtf((float)nodeCount);
+    if (!graph_reserve(graph, side * side)) return false;
+    
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            if (bench_add_node(graph, x * CELL_SIZE, y * CELL_SIZE) < 0) return false;
+        }
+    }
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            int id = y * side + x;
+            if (x + 1 < side) {
+                graph_add_edge_bidirectional(graph, id, id + 1, CELL_SIZE * (1.0f + bench_randf()));
+            }
+            if (y + 1 < side) {
+                graph_add_edge_bidirectional(graph, id, id + side, CELL_SIZE * (1.0f + bench_randf()));
+            }
+        }
+    }
+    return true;
+}
+
+// Uniform random points joined to every neighbour within a radius that
+// gives an average degree of about 6
+static bool gen_geometric(Graph* graph, int nodeCount) {
+    float extent = sqrtf((float)nodeCount) * CELL_SIZE;
+    float radius = sqrtf(6.0f * extent * extent / (3.14159265f * nodeCount));
+    if (!graph_reserve(graph, nodeCount)) return false;
+    
+    for (int i = 0; i < nodeCount; i++) {
+        if (bench_add_node(graph, bench_randf() * extent, bench_randf() * extent) < 0) return false;
+    }
+    
+    int capacity = 64;
+    int* nearby = (int*)malloc(capacity * sizeof(int));
+    if (!nearby) return false;
+    for (int i = 0; i < nodeCount; i++) {
+        int found = graph_find_nodes_in_radius(graph, graph->nodeX[i], graph->nodeY[i],
+                                               radius, nearby, capacity);
+        if (found > capacity) found = capacity;
+        for (int k = 0; k < found; k++) {
+            int j = nearby[k];
+            if (j > i) graph_add_edge_bidirectional(graph, i, j, bench_distance(graph, i, j));
+        }
+    }
+    free(nearby);
+    return true;
+}
+
+// Jittered street grid with missing blocks and one-way streets, plus an
+// arterial every 8th row and column. Weights are travel times scaled so
+// that arterials cost their length, keeping the coordinate heuristics
+// admissible; side streets are 2-3x slower.
+static bool gen_road(Graph* graph, int nodeCount) {
+    int side = (int)sqrtf((float)nodeCount);
+    if (!graph_reserve(graph, side * side)) return false;
+    
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            float jx = (bench_randf() - 0.5f) * CELL_SIZE * 0.6f;
+            float jy = (bench_randf() - 0.5f) * CELL_SIZE * 0.6f;
+            if (bench_add_node(graph, x * CELL_SIZE + jx, y * CELL_SIZE + jy) < 0) return false;
+        }
+    }
+    for (int y = 0; y < side; y++) {
+        for (int x = 0; x < side; x++) {
+            int id = y * side + x;
+            int next[2] = { x + 1 < side ? id + 1 : -1, y + 1 < side ? id + side : -1 };
+            bool arterial[2] = { y % 8 == 0, x % 8 == 0 };
+            for (int k = 0; k < 2; k++) {
+                if (next[k] < 0) continue;
+                float length = bench_distance(graph, id, next[k]);
+                if (arterial[k]) {
+                    graph_add_edge_bidirectional(graph, id, next[k], length);
+                    continue;
+                }
+    
+                unsigned int r = bench_rand() % 20;
+                float weight = length * (2.0f + bench_randf());
+                if (r == 0) continue;  // Missing street
+                if (r == 1) graph_add_edge(graph, id, next[k], weight);
+                else if (r == 2) graph_add_edge(graph, next[k], id, weight);
+                else graph_add_edge_bidirectional(graph, id, next[k], weight);
+            }
+        }
+    }
+    return true;
+}
+
+typedef bool (*GraphGenerator)(Graph* graph, int nodeCount);
+
+typedef struct {
+    const char* name;
+    GraphGenerator generate;
+    int sizes[2];            // Node counts (the first one only with -q)
+} GraphShape;
+
+static const GraphShape SHAPES[] = {
+    { "grid",      gen_grid,      { 10000, 40000 } },
+    { "geometric", gen_geometric, { 10000, 40000 } },
+    { "road",      gen_road,      { 10000, 40000 } },
+};
+
+// ============================================================================
+// Engines
+// ============================================================================
+
+// Graph under test with everything the engines precompute
+typedef struct {
+    Graph* graph;
+    GraphCSR csr;
+    LandmarkTable landmarks;
+    ContractionHierarchy ch;
+    CrpOverlay crp;
+    double freezeMs;
+    double landmarksMs;
+    double chMs;
+    double crpMs;            // crp_build plus crp_customize
+    AStarContext* ctx;
+    
+    const BatchQuery* queries;
+    int queryCount;
+} BenchEnv;
+
+// One timed sample
+typedef struct {
+    double us;
+    int explored;
+    bool found;
+    float cost;
+} BenchSample;
+
+// Points a run function fills; samples has room for queryCount entries
+typedef struct {
+    BenchSample* samples;
+    int sampleCount;
+    double wallMs;           // Time the engine took for all of its samples
+} BenchRun;
+
+typedef enum {
+    PREP_NONE,
+    PREP_FREEZE,
+    PREP_LANDMARKS,
+    PREP_CH,
+    PREP_CRP
+} BenchPrep;
+
+// What an engine's samples must agree with (see check_run)
+typedef enum {
+    CHECK_NONE,
+    CHECK_ROUTES,            // Sample i is query i; the first such engine is the baseline
+    CHECK_MATRIX,            // Sample k is table k; the first such engine is the baseline
+    CHECK_GRAPH,             // Cost is the total edge weight of a copy of the graph
+    CHECK_COUNT
+} BenchCheck;
+
+typedef bool (*BenchRunFunc)(BenchEnv* env, BenchRun* run);
+typedef PathResult (*BenchQueryFunc)(BenchEnv* env, int startId, int goalId, AStarStats* stats);
+
+typedef struct {
+    const char* name;
+    BenchPrep prep;
+    BenchCheck check;
+    BenchRunFunc run;        // NULL: time query once per query
+    BenchQueryFunc query;
+} BenchEngine;
+
+static void sample_from_result(BenchSample* sample, double us, const PathResult* result,
+                               const AStarStats* stats) {
+    sample->us = us;
+    sample->explored = stats->nodesExplored;
+    sample->found = result->found;
+    sample->cost = result->found ? result->totalCost : 0.0f;
+}
+
+static PathResult query_dijkstra(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    config.heuristic = HEURISTIC_ZERO;
+    return astar_find_path_ctx(env->ctx, env->graph, startId, goalId, &config, stats);
+}
+
+static PathResult query_astar(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    return astar_find_path_ctx(env->ctx, env->graph, startId, goalId, &config, stats);
+}
+
+static PathResult query_astar_lazy(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    config.openSet = PQ_LAZY_HEAP;
+    return astar_find_path_ctx(env->ctx, env->graph, startId, goalId, &config, stats);
+}
+
+static PathResult query_astar_bucket(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    config.openSet = PQ_BUCKET_QUEUE;
+    return astar_find_path_ctx(env->ctx, env->graph, startId, goalId, &config, stats);
+}
+
+static PathResult query_bidirectional(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    config.bidirectional = true;
+    return astar_find_path_ctx(env->ctx, env->graph, startId, goalId, &config, stats);
+}
+
+static PathResult query_astar_csr(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    return astar_find_path_csr_ctx(env->ctx, &env->csr, startId, goalId, &config, stats);
+}
+
+static PathResult query_alt(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    AStarConfig config = astar_default_config();
+    config.heuristic = HEURISTIC_LANDMARKS;
+    config.landmarks = &env->landmarks;
+    return astar_find_path_csr_ctx(env->ctx, &env->csr, startId, goalId, &config, stats);
+}
+
+static PathResult query_ch(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    return ch_find_path_ctx(env->ctx, &env->ch, startId, goalId, stats);
+}
+
+static PathResult query_crp(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    return crp_find_path_ctx(env->ctx, &env->crp, env->graph, startId, goalId, stats);
+}
+
+// Initial D* Lite plan, including the planner setup
+static PathResult query_dstar(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    PathResult result = path_result_create();
+    DStarPlanner* planner = dstar_create(env->graph, startId, goalId, NULL);
+    if (!planner) return result;
+    result = dstar_find_path(planner, stats);
+    dstar_free(planner);
+    return result;
+}
+
+// Full one-to-all tree from the start, with the goal's route read off it
+static PathResult query_spt(BenchEnv* env, int startId, int goalId, AStarStats* stats) {
+    PathResult result = path_result_create();
+    ShortestPathTree tree;
+    if (!graph_shortest_path_tree(env->ctx, env->graph, startId, SPT_UNBOUNDED, false, &tree)) {
+        return result;
+    }
+    
+    for (int i = 0; i < tree.count; i++) {
+        if (tree.nodes[i] == goalId) {
+            result = spt_path(&tree, i);
+            break;
+        }
+    }
+    stats->nodesExplored = tree.count;
+    spt_free(&tree);
+    return result;
+}
+
+// Time query once per query
+static bool run_point_queries(BenchEnv* env, BenchQueryFunc query, BenchRun* run) {
+    for (int i = 0; i < env->queryCount; i++) {
+        AStarStats stats = {0};
+        double start = astar_time_ms();
+        PathResult result = query(env, env->queries[i].startId, env->queries[i].goalId, &stats);
+        double elapsed = astar_time_ms() - start;
+    
+        sample_from_result(&run->samples[i], elapsed * 1000.0, &result, &stats);
+        run->wallMs += elapsed;
+        path_result_free(&result);
+    }
+    run->sampleCount = env->queryCount;
+    return true;
+}
+
+// D* Lite repair: plan, raise the weight of the middle edge of the route,
+// time the replan, then restore the weight
+static bool run_dstar_replan(BenchEnv* env, BenchRun* run) {
+    for (int i = 0; i < env->queryCount; i++) {
+        int startId = env->queries[i].startId;
+        int goalId = env->queries[i].goalId;
+        BenchSample* sample = &run->samples[run->sampleCount];
+    
+        DStarPlanner* planner = dstar_create(env->graph, startId, goalId, NULL);
+        if (!planner) return false;
+        PathResult plan = dstar_find_path(planner, NULL);
+        if (!plan.found || plan.length < 2) {
+            path_result_free(&plan);
+            dstar_free(planner);
+            continue;
+        }
+    
+        int from = plan.nodes[plan.length / 2 - 1];
+        int to = plan.nodes[plan.length / 2];
+        path_result_free(&plan);
+        int edgeId = graph_find_edge(env->graph, from, to);
+        float weight = graph_get_edge_weight(env->graph, from, to);
+        graph_set_edge_weight(env->graph, edgeId, weight * 4.0f);
+    
+        AStarStats stats = {0};
+        double start = astar_time_ms();
+        dstar_update_edge(planner, from, to);
+        PathResult result = dstar_find_path(planner, &stats);
+        double elapsed = astar_time_ms() - start;
+    
+        sample_from_result(sample, elapsed * 1000.0, &result, &stats);
+        run->wallMs += elapsed;
+        run->sampleCount++;
+        path_result_free(&result);
+        graph_set_edge_weight(env->graph, edgeId, weight);
+        dstar_free(planner);
+    }
+    return true;
+}
+
+// Whole query set through the work-stealing executor; latencies are the
+// per-query search times it reports
+static bool run_batch(BenchEnv* env, BenchRun* run) {
+    int count = env->queryCount;
+    PathResult* results = (PathResult*)malloc(count * sizeof(PathResult));
+    AStarStats* stats = (AStarStats*)malloc(count * sizeof(AStarStats));
+    if (!results || !stats) {
+        free(results);
+        free(stats);
+        return false;
+    }
+    
+    double start = astar_time_ms();
+    bool ok = astar_find_paths_batch_csr(&env->csr, env->queries, count, NULL,
+                                         results, stats, BATCH_AUTO_THREADS);
+    run->wallMs = astar_time_ms() - start;
+    
+    for (int i = 0; i < count; i++) {
+        sample_from_result(&run->samples[i], stats[i].searchTimeMs * 1000.0, &results[i], &stats[i]);
+        path_result_free(&results[i]);
+    }
+    run->sampleCount = count;
+    free(results);
+    free(stats);
+    return ok;
+}
+
+// One MATRIX_SIDE x MATRIX_SIDE table per sample, sources and targets
+// taken from consecutive queries
+static bool run_matrix(BenchEnv* env, BenchRun* run, bool useCh) {
+    int sources[MATRIX_SIDE];
+    int targets[MATRIX_SIDE];
+    float out[MATRIX_SIDE * MATRIX_SIDE];
+    
+    for (int base = 0; base + MATRIX_SIDE <= env->queryCount; base += MATRIX_SIDE) {
+        for (int k = 0; k < MATRIX_SIDE; k++) {
+            sources[k] = env->queries[base + k].startId;
+            targets[k] = env->queries[base + k].goalId;
+        }
+    
+        double start = astar_time_ms();
+        bool ok = useCh
+            ? ch_distance_matrix(&env->ch, sources, MATRIX_SIDE, targets, MATRIX_SIDE, out, 1)
+            : graph_distance_matrix_threads(env->graph, sources, MATRIX_SIDE, targets, MATRIX_SIDE, out, 1);
+        double elapsed = astar_time_ms() - start;
+        if (!ok) return false;
+    
+        BenchSample* sample = &run->samples[run->sampleCount++];
+        sample->us = elapsed * 1000.0;
+        sample->explored = 0;
+        sample->found = true;
+        sample->cost = 0.0f;
+        for (int k = 0; k < MATRIX_SIDE * MATRIX_SIDE; k++) {
+            if (out[k] < INFINITY) sample->cost += out[k];
+        }
+        run->wallMs += elapsed;
+    }
+    return true;
+}
+
+static bool run_matrix_dijkstra(BenchEnv* env, BenchRun* run) {
+    return run_matrix(env, run, false);
+}
+
+static bool run_matrix_ch(BenchEnv* env, BenchRun* run) {
+    return run_matrix(env, run, true);
+}
+
+// Every query twice through a route cache with room for all of them;
+// only the second pass (all hits) is timed, and explored stays 0 since a
+// hit runs no search
+static bool run_route_cache(BenchEnv* env, BenchRun* run) {
+    RouteCache cache;
+    if (!route_cache_init(&cache, env->queryCount)) return false;
+    AStarConfig config = astar_default_config();
+    
+    for (int i = 0; i < env->queryCount; i++) {
+        PathResult result = route_cache_find_path(&cache, env->ctx, env->graph, env->queries[i].startId,
+                                                  env->queries[i].goalId, &config, NULL);
+        path_result_free(&result);
+    }
+    
+    for (int i = 0; i < env->queryCount; i++) {
+        AStarStats stats = {0};
+        double start = astar_time_ms();
+        PathResult result = route_cache_find_path(&cache, env->ctx, env->graph, env->queries[i].startId,
+                                                  env->queries[i].goalId, &config, &stats);
+        double elapsed = astar_time_ms() - start;
+    
+        sample_from_result(&run->samples[i], elapsed * 1000.0, &result, &stats);
+        run->samples[i].explored = 0;
+        run->wallMs += elapsed;
+        path_result_free(&result);
+    }
+    run->sampleCount = env->queryCount;
+    
+    bool ok = cache.stats.hits == env->queryCount;
+    route_cache_free(&cache);
+    return ok;
+}
+
+// Snapshot publish after a one-edge change: each sample rewrites the
+// weight of an edge leaving the query's start node (to the same value, so
+// the graph ends as it began), then times graph_store_publish, which
+// rebuilds one block, plus graph_store_acquire. The query is then routed
+// with A* on the acquired snapshot (untimed), so found, explored and cost
+// show whether the snapshot still matches the graph. The first, full
+// publish is not timed.
+static bool run_snapshot(BenchEnv* env, BenchRun* run) {
+    GraphStore* store = graph_store_create();
+    if (!store) return false;
+    bool ok = graph_store_publish(store, env->graph);
+    AStarConfig config = astar_default_config();
+    
+    for (int i = 0; ok && i < env->queryCount; i++) {
+        int startId = env->queries[i].startId;
+        for (int k = 0; k < env->graph->edgeCounts[startId]; k++) {
+            const Edge* edge = &env->graph->edges[startId][k];
+            if (edge->active) {
+                graph_set_edge_weight(env->graph, edge->id, edge->weight);
+                break;
+            }
+        }
+    
+        double start = astar_time_ms();
+        GraphSnapshot* snapshot = graph_store_publish(store, env->graph) ? graph_store_acquire(store) : NULL;
+        double elapsed = astar_time_ms() - start;
+        ok = snapshot != NULL;
+        if (!ok) break;
+    
+        AStarStats stats = {0};
+        PathResult result = astar_find_path_ctx(env->ctx, graph_snapshot_graph(snapshot), startId,
+                                                env->queries[i].goalId, &config, &stats);
+        sample_from_result(&run->samples[run->sampleCount++], elapsed * 1000.0, &result, &stats);
+        run->wallMs += elapsed;
+        path_result_free(&result);
+        graph_snapshot_release(snapshot);
+    }
+    graph_store_free(store);
+    return ok;
+}
+
+// Write the graph as the CSV node and edge lists import_csv reads, one
+// one-way line per active edge
+static bool write_csv(const Graph* graph, const char* nodesPath, const char* edgesPath) {
+    FILE* nodes = fopen(nodesPath, "w");
+    FILE* edges = fopen(edgesPath, "w");
+    bool ok = nodes && edges;
+    
+    for (int i = 0; ok && i < graph->nodeCount; i++) {
+        if (!GRAPH_NODE_ACTIVE(graph, i)) continue;
+        fprintf(nodes, "%d,%.9g,%.9g,%s\n", i, graph->nodeX[i], graph->nodeY[i], graph->nodes[i].name);
+        for (int k = 0; k < graph->edgeCounts[i]; k++) {
+            const Edge* edge = &graph->edges[i][k];
+            if (edge->active) fprintf(edges, "%d,%d,%.9g,1\n", edge->from, edge->to, edge->weight);
+        }
+    }
+    
+    if (nodes && fclose(nodes) != 0) ok = false;
+    if (edges && fclose(edges) != 0) ok = false;
+    return ok;
+}
+
+// Sum of the active edge weights, to check a graph read back from a file
+static float total_weight(const Graph* graph) {
+    float total = 0.0f;
+    for (int i = 0; i < graph->nodeCount; i++) {
+        for (int k = 0; k < graph->edgeCounts[i]; k++) {
+            if (graph->edges[i][k].active) total += graph->edges[i][k].weight;
+        }
+    }
+    return total;
+}
+
+// Whole-graph CSV import, FILE_RUNS times; explored is the number of
+// edges imported and cost the sum of their weights
+static bool run_import_csv(BenchEnv* env, BenchRun* run) {
+    bool ok = write_csv(env->graph, BENCH_NODES_CSV, BENCH_EDGES_CSV);
+    
+    for (int i = 0; ok && i < FILE_RUNS && i < env->queryCount; i++) {
+        Graph graph;
+        graph_init(&graph);
+        ImportStats stats;
+        double start = astar_time_ms();
+        ok = import_csv(&graph, BENCH_NODES_CSV, BENCH_EDGES_CSV, NULL, &stats);
+        double elapsed = astar_time_ms() - start;
+    
+        BenchSample* sample = &run->samples[run->sampleCount++];
+        sample->us = elapsed * 1000.0;
+        sample->explored = ok ? stats.edges : 0;
+        sample->found = ok;
+        sample->cost = ok ? total_weight(&graph) : 0.0f;
+        run->wallMs += elapsed;
+        graph_free(&graph);
+    }
+    
+    remove(BENCH_NODES_CSV);
+    remove(BENCH_EDGES_CSV);
+    return ok;
+}
+
+// RCGRAPH2 load, FILE_RUNS times: graphfile_open with verification plus
+// graphfile_to_graph, from a file saved once up front
+static bool run_graphfile_load(BenchEnv* env, BenchRun* run) {
+    bool ok = graphfile_save(env->graph, BENCH_RCG2);
+    
+    for (int i = 0; ok && i < FILE_RUNS && i < env->queryCount; i++) {
+        Graph graph;
+        graph_init(&graph);
+        GraphFile file;
+        int edgeCount = 0;
+        double start = astar_time_ms();
+        ok = graphfile_open(&file, BENCH_RCG2, true);
+        if (ok) {
+            ok = graphfile_to_graph(&file, &graph);
+            edgeCount = file.csr.edgeCount;
+            graphfile_close(&file);
+        }
+        double elapsed = astar_time_ms() - start;
+    
+        BenchSample* sample = &run->samples[run->sampleCount++];
+        sample->us = elapsed * 1000.0;
+        sample->explored = ok ? edgeCount : 0;
+        sample->found = ok;
+        sample->cost = ok ? total_weight(&graph) : 0.0f;
+        run->wallMs += elapsed;
+        graph_free(&graph);
+    }
+    
+    remove(BENCH_RCG2);
+    return ok;
+}
+
+static const BenchEngine ENGINES[] = {
+    { "dijkstra",        PREP_NONE,      CHECK_ROUTES, NULL,                query_dijkstra },
+    { "astar",           PREP_NONE,      CHECK_ROUTES, NULL,                query_astar },
+    { "astar-lazy",      PREP_NONE,      CHECK_ROUTES, NULL,                query_astar_lazy },
+    { "astar-bucket",    PREP_NONE,      CHECK_ROUTES, NULL,                query_astar_bucket },
+    { "bidirectional",   PREP_NONE,      CHECK_ROUTES, NULL,                query_bidirectional },
+    { "astar-csr",       PREP_FREEZE,    CHECK_ROUTES, NULL,                query_astar_csr },
+    { "alt",             PREP_LANDMARKS, CHECK_ROUTES, NULL,                query_alt },
+    { "ch",              PREP_CH,        CHECK_ROUTES, NULL,                query_ch },
+    { "crp",             PREP_CRP,       CHECK_ROUTES, NULL,                query_crp },
+    { "dstar",           PREP_NONE,      CHECK_ROUTES, NULL,                query_dstar },
+    { "dstar-replan",    PREP_NONE,      CHECK_NONE,   run_dstar_replan,    NULL },
+    { "spt",             PREP_NONE,      CHECK_ROUTES, NULL,                query_spt },
+    { "batch-csr",       PREP_FREEZE,    CHECK_ROUTES, run_batch,           NULL },
+    { "matrix-dijkstra", PREP_NONE,      CHECK_MATRIX, run_matrix_dijkstra, NULL },
+    { "matrix-ch",       PREP_CH,        CHECK_MATRIX, run_matrix_ch,       NULL },
+    { "route-cache",     PREP_NONE,      CHECK_ROUTES, run_route_cache,     NULL },
+    { "snapshot",        PREP_NONE,      CHECK_ROUTES, run_snapshot,        NULL },
+    { "import-csv",      PREP_NONE,      CHECK_GRAPH,  run_import_csv,      NULL },
+    { "graphfile-load",  PREP_NONE,      CHECK_GRAPH,  run_graphfile_load,  NULL },
+};
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+// First run of each check, which the later ones must agree with
+typedef struct {
+    BenchSample* samples[CHECK_COUNT];   // NULL until that run
+    int counts[CHECK_COUNT];
+    const char* engines[CHECK_COUNT];
+} BenchBaselines;
+
+static void baselines_free(BenchBaselines* baselines) {
+    for (int c = 0; c < CHECK_COUNT; c++) free(baselines->samples[c]);
+    memset(baselines, 0, sizeof(*baselines));
+}
+
+// Route costs are float sums taken in different orders (shortcuts, clique
+// hops), so they only have to agree to a relative COST_TOLERANCE
+static bool costs_match(float a, float b) {
+    float scale = fmaxf(1.0f, fmaxf(fabsf(a), fabsf(b)));
+    return fabsf(a - b) <= COST_TOLERANCE * scale;
+}
+
+/**
+ * Compare a run with the baseline of its engine's check (before report
+ * sorts the samples); the first run of a check becomes its baseline
+ *
+ * @return  Number of samples that disagree (found flag or cost), or -1
+ *          if the baseline cannot be stored
+ */
+static int check_run(BenchBaselines* baselines, const BenchEnv* env, const BenchEngine* engine,
+                     const BenchRun* run) {
+    BenchCheck check = engine->check;
+    if (check == CHECK_NONE) return 0;
+    
+    if (check == CHECK_GRAPH) {
+        float total = total_weight(env->graph);
+        int mismatches = 0;
+        for (int i = 0; i < run->sampleCount; i++) {
+            if (!run->samples[i].found || !costs_match(run->samples[i].cost, total)) mismatches++;
+        }
+        return mismatches;
+    }
+    
+    const BenchSample* baseline = baselines->samples[check];
+    if (!baseline) {
+        BenchSample* copy = (BenchSample*)malloc((run->sampleCount > 0 ? run->sampleCount : 1) * sizeof(BenchSample));
+        if (!copy) return -1;
+        memcpy(copy, run->samples, run->sampleCount * sizeof(BenchSample));
+        baselines->samples[check] = copy;
+        baselines->counts[check] = run->sampleCount;
+        baselines->engines[check] = engine->name;
+        return 0;
+    }
+    
+    int count = baselines->counts[check];
+    int mismatches = run->sampleCount != count ? 1 : 0;
+    for (int i = 0; i < count && i < run->sampleCount; i++) {
+        const BenchSample* a = &run->samples[i];
+        const BenchSample* b = &baseline[i];
+        if (a->found != b->found || (a->found && !costs_match(a->cost, b->cost))) mismatches++;
+    }
+    return mismatches;
+}
+
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+static int compare_samples(const void* a, const void* b) {
+    double x = ((const BenchSample*)a)->us;
+    double y = ((const BenchSample*)b)->us;
+    return (x > y) - (x < y);
+}
+
+static double prep_time(const BenchEnv* env, BenchPrep prep) {
+    switch (prep) {
+        case PREP_FREEZE:    return env->freezeMs;
+        case PREP_LANDMARKS: return env->freezeMs + env->landmarksMs;
+        case PREP_CH:        return env->freezeMs + env->chMs;
+        case PREP_CRP:       return env->crpMs;
+        default:             return 0.0;
+    }
+}
+
+static void report(const char* shape, const BenchEnv* env, const BenchEngine* engine,
+                   BenchRun* run) {
+    int n = run->sampleCount;
+    int found = 0;
+    double explored = 0.0;
+    double costSum = 0.0;
+    for (int i = 0; i < n; i++) {
+        found += run->samples[i].found;
+        explored += run->samples[i].explored;
+        costSum += run->samples[i].cost;
+    }
+    
+    qsort(run->samples, n, sizeof(BenchSample), compare_samples);
+    double p50 = n > 0 ? run->samples[(n - 1) * 50 / 100].us : 0.0;
+    double p99 = n > 0 ? run->samples[(n - 1) * 99 / 100].us : 0.0;
+    double qps = run->wallMs > 0.0 ? n * 1000.0 / run->wallMs : 0.0;
+    
+    char row[256];
+    snprintf(row, sizeof(row), "%s,%d,%d,%s,%d,%d,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+             shape, env->csr.nodeCount, env->csr.edgeCount, engine->name,
+             n, found, prep_time(env, engine->prep), p50, p99,
+             n > 0 ? explored / n : 0.0, qps, costSum);
+    fputs(row, stdout);
+    fflush(stdout);
+    if (benchOut) fputs(row, benchOut);
+}
+
+// ============================================================================
+// Driver
+// ============================================================================
+
+// Seeded pairs of distinct active nodes
+static BatchQuery* make_queries(const Graph* graph, int count) {
+    BatchQuery* queries = (BatchQuery*)malloc(count * sizeof(BatchQuery));
+    if (!queries) return NULL;
+    for (int i = 0; i < count; i++) {
+        int startId, goalId;
+        do {
+            startId = (int)(bench_rand() % (unsigned int)graph->nodeCount);
+            goalId = (int)(bench_rand() % (unsigned int)graph->nodeCount);
+        } while (startId == goalId || !GRAPH_NODE_ACTIVE(graph, startId) ||
+                 !GRAPH_NODE_ACTIVE(graph, goalId));
+        queries[i].startId = startId;
+        queries[i].goalId = goalId;
+    }
+    return queries;
+}
+
+static bool prepare(BenchEnv* env) {
+    double start = astar_time_ms();
+    if (!graph_freeze(env->graph, &env->csr)) return false;
+    env->freezeMs = astar_time_ms() - start;
+    
+    start = astar_time_ms();
+    if (!landmarks_build(&env->csr, LANDMARK_COUNT, &env->landmarks)) return false;
+    env->landmarksMs = astar_time_ms() - start;
+    
+    start = astar_time_ms();
+    if (!ch_build(&env->csr, &env->ch)) return false;
+    env->chMs = astar_time_ms() - start;
+    
+    start = astar_time_ms();
+    if (!crp_build(env->graph, NULL, &env->crp)) return false;
+    if (!crp_customize(&env->crp, env->graph, CRP_AUTO_THREADS)) return false;
+    env->crpMs = astar_time_ms() - start;
+    
+    env->ctx = astar_context_create(env->graph->nodeCount);
+    return env->ctx != NULL;
+}
+
+// Run every engine on one graph; false if memory runs out or an engine
+// disagrees with its baseline
+static bool bench_graph(const GraphShape* shape, int nodeCount, int queryCount,
+                        BenchSample* samples) {
+    Graph graph;
+    graph_init(&graph);
+    BenchEnv env;
+    memset(&env, 0, sizeof(env));
+    env.graph = &graph;
+    
+    fprintf(stderr, "%s %d: generating\n", shape->name, nodeCount);
+    bool ok = shape->generate(&graph, nodeCount) && graph.nodeCount >= 2;
+    BatchQuery* queries = ok ? make_queries(&graph, queryCount) : NULL;
+    env.queries = queries;
+    env.queryCount = queryCount;
+    
+    if (ok) fprintf(stderr, "%s %d: preprocessing\n", shape->name, nodeCount);
+    ok = queries && prepare(&env);
+    
+    BenchBaselines baselines;
+    memset(&baselines, 0, sizeof(baselines));
+    int disagreeing = 0;
+    int engineCount = (int)(sizeof(ENGINES) / sizeof(ENGINES[0]));
+    for (int e = 0; ok && e < engineCount; e++) {
+        const BenchEngine* engine = &ENGINES[e];
+        fprintf(stderr, "%s %d: %s\n", shape->name, nodeCount, engine->name);
+    
+        BenchRun run = { samples, 0, 0.0 };
+        ok = engine->run ? engine->run(&env, &run) : run_point_queries(&env, engine->query, &run);
+        int mismatches = ok ? check_run(&baselines, &env, engine, &run) : 0;
+        ok = ok && mismatches >= 0;
+        if (mismatches > 0) {
+            const char* against = engine->check == CHECK_GRAPH ? "the graph" : baselines.engines[engine->check];
+            fprintf(stderr, "%s %d: %s disagrees with %s on %d of %d samples\n",
+                    shape->name, nodeCount, engine->name, against, mismatches, run.sampleCount);
+            disagreeing++;
+        }
+        if (ok) report(shape->name, &env, engine, &run);
+    }
+    
+    if (!ok) fprintf(stderr, "%s %d: out of memory\n", shape->name, nodeCount);
+    baselines_free(&baselines);
+    astar_context_free(env.ctx);
+    ch_free(&env.ch);
+    crp_free(&env.crp);
+    landmarks_free(&env.landmarks);
+    graph_csr_free(&env.csr);
+    free(queries);
+    graph_free(&graph);
+    return ok && disagreeing == 0;
+}
+
+// Process-wide counters in the Prometheus text format
+static bool write_metrics(const char* path) {
+    int length = metrics_format_global(NULL, 0);
+    char* text = (char*)malloc(length + 1);
+    FILE* file = text ? fopen(path, "w") : NULL;
+    if (file) {
+        metrics_format_global(text, length + 1);
+        fputs(text, file);
+        fclose(file);
+    }
+    free(text);
+    if (!file) fprintf(stderr, "Cannot write %s\n", path);
+    return file != NULL;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-q] [-n queries] [-s seed] [-o file] [-m file]\n", program);
+    fprintf(stderr, "  -q          quick run (smallest graph of each shape)\n");
+    fprintf(stderr, "  -n queries  queries per graph (default %d)\n", DEFAULT_QUERIES);
+    fprintf(stderr, "  -s seed     generator seed (default %d)\n", DEFAULT_SEED);
+    fprintf(stderr, "  -o file     also write the CSV to file\n");
+    fprintf(stderr, "  -m file     write the search counters to file (ASTAR_COUNTERS builds)\n");
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    int queryCount = DEFAULT_QUERIES;
+    unsigned long long seed = DEFAULT_SEED;
+    const char* outPath = NULL;
+    const char* metricsPath = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-q") == 0) {
+            quick = true;
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            queryCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            metricsPath = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (queryCount < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    
+    if (outPath) {
+        benchOut = fopen(outPath, "w");
+        if (!benchOut) {
+            fprintf(stderr, "Cannot write %s\n", outPath);
+            return 1;
+        }
+    }
+    BenchSample* samples = (BenchSample*)malloc(queryCount * sizeof(BenchSample));
+    if (!samples) return 1;
+    
+    const char* header = "graph,nodes,edges,engine,queries,found,prep_ms,p50_us,p99_us,mean_explored,qps,cost_sum\n";
+    fputs(header, stdout);
+    if (benchOut) fputs(header, benchOut);
+    int shapeCount = (int)(sizeof(SHAPES) / sizeof(SHAPES[0]));
+    int failures = 0;
+    for (int s = 0; s < shapeCount; s++) {
+        int sizeCount = quick ? 1 : 2;
+        for (int k = 0; k < sizeCount; k++) {
+            // Reseed per graph so each one is the same with or without -q
+            benchRng = seed * 1000003ull + (unsigned long long)(s * 2 + k);
+            if (!bench_graph(&SHAPES[s], SHAPES[s].sizes[k], queryCount, samples)) failures++;
+        }
+    }
+    
+    free(samples);
+    if (benchOut) fclose(benchOut);
+    if (metricsPath && !write_metrics(metricsPath)) failures++;
+    return failures > 0 ? 1 : 0;
+}
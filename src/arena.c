@@ -0,0 +1,77 @@
+/**
+ * arena.c - Bump allocator for path node arrays
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+
+static PathArenaBlock* path_arena_block_create(PathArena* arena, size_t capacity) {
+    size_t bytes = sizeof(PathArenaBlock) + capacity * sizeof(int);
+    PathArenaBlock* block = (PathArenaBlock*)malloc(bytes);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->bytesAllocated += bytes;
+    return block;
+}
+
+static void path_arena_free_blocks(PathArenaBlock* block) {
+    while (block) {
+        PathArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+void path_arena_init(PathArena* arena, int blockCapacity) {
+    if (!arena) return;
+    arena->head = NULL;
+    arena->blockCapacity = blockCapacity > 0 ? (size_t)blockCapacity : PATH_ARENA_DEFAULT_BLOCK;
+    arena->used = 0;
+    arena->bytesAllocated = 0;
+}
+
+int* path_arena_alloc(PathArena* arena, int count) {
+    if (!arena || count < 1) return NULL;
+    
+    PathArenaBlock* head = arena->head;
+    if (!head || head->capacity - head->used < (size_t)count) {
+        // Double on every new block, so a round needs O(log n) of them
+        size_t capacity = head ? head->capacity * 2 : arena->blockCapacity;
+        if (capacity < (size_t)count) capacity = (size_t)count;
+    
+        PathArenaBlock* block = path_arena_block_create(arena, capacity);
+        if (!block) return NULL;
+        block->next = head;
+        arena->head = block;
+        head = block;
+    }
+    
+    int* data = head->data + head->used;
+    head->used += (size_t)count;
+    arena->used += (size_t)count;
+    return data;
+}
+
+void path_arena_reset(PathArena* arena) {
+    if (!arena || !arena->head) return;
+    
+    // Merge a chain into one block that would have held the whole round
+    // (if that fails the arena simply starts over empty)
+    if (arena->head->next) {
+        size_t total = 0;
+        for (PathArenaBlock* b = arena->head; b; b = b->next) total += b->capacity;
+        path_arena_free_blocks(arena->head);
+        arena->head = path_arena_block_create(arena, total);
+    }
+    if (arena->head) arena->head->used = 0;
+    arena->used = 0;
+}
+
+void path_arena_free(PathArena* arena) {
+    if (!arena) return;
+    path_arena_free_blocks(arena->head);
+    arena->head = NULL;
+    arena->used = 0;
+}
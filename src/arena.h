@@ -0,0 +1,69 @@
+/**
+ * arena.h - Bump allocator for path node arrays
+ *
+ * A PathArena hands out int arrays from large blocks, so the paths of a
+ * whole batch sit next to each other and are released together with one
+ * reset instead of one free per result. Pass it through AStarConfig.arena;
+ * results allocated from it are flagged and path_result_free leaves them
+ * alone.
+ *
+ * Blocks are chained rather than reallocated, so arrays never move while
+ * the arena is live. When a round spills into several blocks, the reset
+ * merges them into one block of their combined size: a caller repeating
+ * similar batches settles on a single block after the first round.
+ *
+ * An arena is not thread-safe; use one per thread.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PATH_ARENA_DEFAULT_BLOCK 4096   // Ints in the first block
+
+typedef struct PathArenaBlock {
+    struct PathArenaBlock* next;        // Older, smaller block
+    size_t capacity;                    // Ints in data
+    size_t used;
+    int data[];
+} PathArenaBlock;
+
+typedef struct {
+    PathArenaBlock* head;               // Block being filled (the newest)
+    size_t blockCapacity;               // Ints in the first block
+    size_t used;                        // Ints handed out since the last reset
+    unsigned long long bytesAllocated;  // Running total of block memory
+} PathArena;
+
+/**
+ * Prepare an empty arena (nothing is allocated until the first array)
+ *
+ * @param blockCapacity  Ints in the first block (0 for PATH_ARENA_DEFAULT_BLOCK)
+ */
+void path_arena_init(PathArena* arena, int blockCapacity);
+
+/**
+ * Allocate count ints, contiguous and uninitialized
+ *
+ * @return  The array (valid until the next reset), or NULL if count < 1 or
+ *          memory runs out
+ */
+int* path_arena_alloc(PathArena* arena, int count);
+
+// Release every array at once, keeping the memory for the next round
+void path_arena_reset(PathArena* arena);
+
+// Release every array and the blocks
+void path_arena_free(PathArena* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ARENA_H
@@ -1,12 +1,19 @@
 /**
  * astar.c - A* Pathfinding Algorithm Implementation
  * 
- * This is an efficient implementation using a binary min-heap as the priority queue.
+ * This is an efficient implementation using a binary min-heap as the priority queue
+ * (see pqueue.h for the indexed and lazy decrease-key variants).
  * The heuristic function guides the search, making A* optimal and complete when
  * the heuristic is admissible (never overestimates the true cost).
  */
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#endif
+
 #include "astar.h"
+#include "relax.h"
+#include "metrics.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
@@ -18,19 +25,6 @@
 #include <time.h>
 #endif
 
-// Priority queue node for A*
-typedef struct {
-    int nodeId;
-    float fScore;  // f = g + h
-} PQNode;
-
-// Min-heap priority queue
-typedef struct {
-    PQNode* nodes;
-    int size;
-    int capacity;
-} PriorityQueue;
-
 // Timer for performance measurement
 static double get_time_ms(void) {
 #ifdef _WIN32
@@ -45,119 +39,14 @@ static double get_time_ms(void) {
 #endif
 }
 
-// Priority Queue operations
-static PriorityQueue* pq_create(int capacity) {
-    PriorityQueue* pq = (PriorityQueue*)malloc(sizeof(PriorityQueue));
-    if (!pq) return NULL;
-    
-    pq->nodes = (PQNode*)malloc(capacity * sizeof(PQNode));
-    if (!pq->nodes) {
-        free(pq);
-        return NULL;
-    }
-    
-    pq->size = 0;
-    pq->capacity = capacity;
-    return pq;
-}
-
-static void pq_free(PriorityQueue* pq) {
-    if (pq) {
-        free(pq->nodes);
-        free(pq);
-    }
-}
-
-static void pq_swap(PQNode* a, PQNode* b) {
-    PQNode temp = *a;
-    *a = *b;
-    *b = temp;
-}
-
-static void pq_heapify_up(PriorityQueue* pq, int idx) {
-    while (idx > 0) {
-        int parent = (idx - 1) / 2;
-        if (pq->nodes[idx].fScore < pq->nodes[parent].fScore) {
-            pq_swap(&pq->nodes[idx], &pq->nodes[parent]);
-            idx = parent;
-        } else {
-            break;
-        }
-    }
+double astar_time_ms(void) {
+    return get_time_ms();
 }
 
-static void pq_heapify_down(PriorityQueue* pq, int idx) {
-    while (true) {
-        int smallest = idx;
-        int left = 2 * idx + 1;
-        int right = 2 * idx + 2;
-        
-        if (left < pq->size && pq->nodes[left].fScore < pq->nodes[smallest].fScore) {
-            smallest = left;
-        }
-        if (right < pq->size && pq->nodes[right].fScore < pq->nodes[smallest].fScore) {
-            smallest = right;
-        }
-        
-        if (smallest != idx) {
-            pq_swap(&pq->nodes[idx], &pq->nodes[smallest]);
-            idx = smallest;
-        } else {
-            break;
-        }
-    }
-}
-
-static bool pq_push(PriorityQueue* pq, int nodeId, float fScore) {
-    if (pq->size >= pq->capacity) return false;
-    
-    pq->nodes[pq->size].nodeId = nodeId;
-    pq->nodes[pq->size].fScore = fScore;
-    pq_heapify_up(pq, pq->size);
-    pq->size++;
-    return true;
-}
-
-static bool pq_pop(PriorityQueue* pq, int* nodeId, float* fScore) {
-    if (pq->size == 0) return false;
-    
-    *nodeId = pq->nodes[0].nodeId;
-    *fScore = pq->nodes[0].fScore;
-    
-    pq->size--;
-    if (pq->size > 0) {
-        pq->nodes[0] = pq->nodes[pq->size];
-        pq_heapify_down(pq, 0);
-    }
-    return true;
-}
-
-static bool pq_empty(const PriorityQueue* pq) {
-    return pq->size == 0;
-}
-
-// Update priority of existing node or add if not present
-static void pq_decrease_priority(PriorityQueue* pq, int nodeId, float newFScore) {
-    // Find the node
-    for (int i = 0; i < pq->size; i++) {
-        if (pq->nodes[i].nodeId == nodeId) {
-            if (newFScore < pq->nodes[i].fScore) {
-                pq->nodes[i].fScore = newFScore;
-                pq_heapify_up(pq, i);
-            }
-            return;
-        }
-    }
-    // Node not found, add it
-    pq_push(pq, nodeId, newFScore);
-}
-
-// Heuristic functions
-float astar_heuristic(const Node* a, const Node* b, HeuristicType type) {
-    if (!a || !b) return 0.0f;
-    
-    float dx = fabsf(b->x - a->x);
-    float dy = fabsf(b->y - a->y);
+// Heuristic on raw coordinates (shared by the Graph and CSR searches)
+static float heuristic_xy(float ax, float ay, float bx, float by, HeuristicType type) {
+    float dx = fabsf(bx - ax);
+    float dy = fabsf(by - ay);
     
     switch (type) {
         case HEURISTIC_EUCLIDEAN:
@@ -175,53 +64,512 @@ float astar_heuristic(const Node* a, const Node* b, HeuristicType type) {
     }
 }
 
+// Heuristic between two nodes of a search; landmark bounds need the IDs,
+// the coordinate heuristics only the positions
+static float typed_heuristic(HeuristicType type, const LandmarkTable* landmarks,
+                             int from, float fx, float fy, int to, float tx, float ty) {
+    if (type == HEURISTIC_LANDMARKS) {
+        return landmarks_lower_bound(landmarks, from, to);
+    }
+    return heuristic_xy(fx, fy, tx, ty, type);
+}
+
+static float node_heuristic(const AStarConfig* cfg, int from, float fx, float fy,
+                            int to, float tx, float ty) {
+    return typed_heuristic(cfg->heuristic, cfg->landmarks, from, fx, fy, to, tx, ty);
+}
+
+// Heuristic functions
+float astar_heuristic(const Node* a, const Node* b, HeuristicType type) {
+    if (!a || !b) return 0.0f;
+    return heuristic_xy(a->x, a->y, b->x, b->y, type);
+}
+
+float astar_heuristic_xy(float ax, float ay, float bx, float by, HeuristicType type) {
+    return heuristic_xy(ax, ay, bx, by, type);
+}
+
 // Default configuration
 AStarConfig astar_default_config(void) {
     AStarConfig config;
     config.heuristic = HEURISTIC_EUCLIDEAN;
     config.heuristicWeight = 1.0f;
     config.allowDiagonal = true;
+    config.openSet = PQ_INDEXED_HEAP;
+    config.bucketWidth = 0.0f;
+    config.bidirectional = false;
+    config.landmarks = NULL;
+    config.trace = NULL;
+    config.arena = NULL;
     return config;
 }
 
-// Reconstruct path from came_from array
+// Tracing: every call site tests the sink pointer first, so a search
+// without a trace pays one predictable branch per event
+#define TRACE(trace, kind, node, from, value, backward) \
+    do { if (trace) trace_record((trace), (kind), (node), (from), (value), (backward)); } while (0)
+
+static void trace_record(AStarTrace* trace, AStarTraceKind kind, int node, int from,
+                         float value, int backward) {
+    if (!(trace->kinds & ASTAR_TRACE_MASK(kind))) return;
+    if (trace->count < trace->capacity) {
+        AStarTraceEvent* event = &trace->events[trace->count++];
+        event->node = node;
+        event->from = from;
+        event->value = value;
+        event->kind = (unsigned char)kind;
+        event->backward = (unsigned char)backward;
+        if (trace->onRecord) trace->onRecord(trace->user, trace->count);
+    }
+    trace->total++;
+}
+
+static void trace_begin(AStarTrace* trace) {
+    if (!trace) return;
+    trace->count = 0;
+    trace->total = 0;
+    if (!trace->events) trace->capacity = 0;
+}
+
+// Grow the path scratch of a context to hold length nodes
+static bool context_reserve_path(AStarContext* ctx, int length) {
+    if (length <= ctx->pathCapacity) return true;
+    
+    int capacity = ctx->pathCapacity > 0 ? ctx->pathCapacity : 64;
+    while (capacity < length) capacity *= 2;
+    
+    int* path = (int*)realloc(ctx->path, capacity * sizeof(int));
+    if (!path) return false;
+    ASTAR_COUNT(ctx->forward.bytesAllocated += (unsigned long long)(capacity - ctx->pathCapacity) * sizeof(int));
+    ctx->path = path;
+    ctx->pathCapacity = capacity;
+    return true;
+}
+
+// Copy the scratch nodes (head then tail) into the result in one
+// allocation, from the arena if there is one
+static bool path_result_take(PathResult* result, PathArena* arena,
+                             const int* head, int headLength, const int* tail, int tailLength) {
+    int length = headLength + tailLength;
+    int* copy = arena ? path_arena_alloc(arena, length) : (int*)malloc(length * sizeof(int));
+    if (!copy) return false;
+    memcpy(copy, head, headLength * sizeof(int));
+    if (tailLength > 0) memcpy(copy + headLength, tail, tailLength * sizeof(int));
+    result->nodes = copy;
+    result->length = length;
+    result->inArena = arena != NULL;
+    result->found = true;
+    return true;
+}
+
+// Reconstruct path from the forward cameFrom array
+// Walks the parents once, filling the scratch from its end so the nodes
+// land in travel order, then makes the one exact-size allocation.
 static PathResult reconstruct_path(
-    const int* cameFrom,
-    const float* gScore,
+    AStarContext* ctx,
+    const AStarConfig* cfg,
     int startId,
     int goalId,
     int nodeCount
 ) {
     PathResult result = path_result_create();
+    if (!context_reserve_path(ctx, nodeCount)) return result;
     
-    // Count path length
+    const int* cameFrom = ctx->forward.cameFrom;
+    int* path = ctx->path;
     int length = 0;
     int current = goalId;
-    while (current != startId && current != -1 && length < nodeCount) {
-        length++;
+    while (current != -1 && length < nodeCount) {
+        path[nodeCount - 1 - length++] = current;
+        if (current == startId) break;
         current = cameFrom[current];
     }
-    if (current == startId) length++;  // Include start node
-    
-    if (current != startId) {
+    if (length == 0 || path[nodeCount - length] != startId) {
         return result;  // No valid path
     }
     
-    // Allocate path array
-    result.nodes = (int*)malloc(length * sizeof(int));
-    if (!result.nodes) return result;
+    if (path_result_take(&result, cfg->arena, path + nodeCount - length, length, NULL, 0)) {
+        result.totalCost = ctx->forward.gScore[goalId];
+    }
+    return result;
+}
+
+// reconstruct_path, timed into stats->reconstructMs in counter builds
+static PathResult reconstruct_path_timed(
+    AStarContext* ctx,
+    const AStarConfig* cfg,
+    int startId,
+    int goalId,
+    int nodeCount,
+    AStarStats* stats
+) {
+#if ASTAR_COUNTERS_ENABLED
+    double start = get_time_ms();
+    PathResult result = reconstruct_path(ctx, cfg, startId, goalId, nodeCount);
+    stats->reconstructMs = (float)(get_time_ms() - start);
+    return result;
+#else
+    (void)stats;
+    return reconstruct_path(ctx, cfg, startId, goalId, nodeCount);
+#endif
+}
+
+// ============================================================================
+// Specialized Graph kernels
+// ============================================================================
+
+// One unidirectional search loop per heuristic x weighted x tombstones x
+// instrumented, stamped out from astar_kernel.h
+#define ASTAR_KERNEL_HEURISTIC HEURISTIC_EUCLIDEAN
+#define ASTAR_KERNEL_PREFIX search_euclidean
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_HEURISTIC HEURISTIC_MANHATTAN
+#define ASTAR_KERNEL_PREFIX search_manhattan
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_HEURISTIC HEURISTIC_CHEBYSHEV
+#define ASTAR_KERNEL_PREFIX search_chebyshev
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_HEURISTIC HEURISTIC_ZERO
+#define ASTAR_KERNEL_PREFIX search_zero
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_HEURISTIC HEURISTIC_LANDMARKS
+#define ASTAR_KERNEL_PREFIX search_landmarks
+#include "astar_kernel.h"
+
+typedef PathResult (*GraphKernel)(AStarContext* ctx, const Graph* graph, int startId, int goalId,
+                                  const AStarConfig* cfg, AStarStats* stats);
+
+#define GRAPH_KERNEL_ROW(prefix) { \
+    { { prefix##_w0_t0_i0, prefix##_w0_t0_i1 }, { prefix##_w0_t1_i0, prefix##_w0_t1_i1 } }, \
+    { { prefix##_w1_t0_i0, prefix##_w1_t0_i1 }, { prefix##_w1_t1_i0, prefix##_w1_t1_i1 } } }
+
+// Indexed [heuristic][weighted][tombstones][instrumented], in HeuristicType order
+static const GraphKernel graph_kernels[][2][2][2] = {
+    GRAPH_KERNEL_ROW(search_euclidean),
+    GRAPH_KERNEL_ROW(search_manhattan),
+    GRAPH_KERNEL_ROW(search_chebyshev),
+    GRAPH_KERNEL_ROW(search_zero),
+    GRAPH_KERNEL_ROW(search_landmarks),
+};
+
+#undef GRAPH_KERNEL_ROW
+
+// Pick the kernel for a query: the generic features are only compiled in
+// when the query needs them
+static GraphKernel select_graph_kernel(const Graph* graph, const AStarConfig* cfg,
+                                       const AStarStats* stats) {
+    int heuristic = (int)cfg->heuristic;
+    if (heuristic < 0 || heuristic > HEURISTIC_LANDMARKS) heuristic = HEURISTIC_ZERO;
+    
+    // h is 0 for Dijkstra, so its weight never matters
+    int weighted = heuristic != HEURISTIC_ZERO && cfg->heuristicWeight != 1.0f;
+    int tombstones = graph->deadNodes > 0 || graph->deadEdges > 0;
+    int instrumented = stats != NULL || cfg->trace != NULL || ASTAR_COUNTERS_ENABLED;
+    return graph_kernels[heuristic][weighted][tombstones][instrumented];
+}
+
+// Context lifecycle
+AStarContext* astar_context_create(int nodeCapacity) {
+    AStarContext* ctx = (AStarContext*)calloc(1, sizeof(AStarContext));
+    if (!ctx) return NULL;
+    
+    if (!pq_init(&ctx->forward.openSet, PQ_INDEXED_HEAP, 0) ||
+        !pq_init(&ctx->backward.openSet, PQ_INDEXED_HEAP, 0) ||
+        !astar_context_reset(ctx, nodeCapacity, PQ_INDEXED_HEAP, false)) {
+        astar_context_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+static void frontier_free(AStarFrontier* frontier) {
+    pq_free(&frontier->openSet);
+    free(frontier->gScore);
+    free(frontier->cameFrom);
+    free(frontier->mark);
+}
+
+void astar_context_free(AStarContext* ctx) {
+    if (!ctx) return;
+    frontier_free(&ctx->forward);
+    frontier_free(&ctx->backward);
+    free(ctx->path);
+    free(ctx);
+}
+
+// Grow the per-node arrays; new slots are stamped as never reached
+static bool frontier_reserve(AStarFrontier* frontier, int nodeCount) {
+    if (nodeCount <= frontier->capacity) return true;
+    
+    int capacity = frontier->capacity > 0 ? frontier->capacity : 64;
+    while (capacity < nodeCount) capacity *= 2;
     
-    result.length = length;
-    result.found = true;
-    result.totalCost = gScore[goalId];
+    float* gScore = (float*)realloc(frontier->gScore, capacity * sizeof(float));
+    if (!gScore) return false;
+    frontier->gScore = gScore;
     
-    // Fill path in reverse order
-    current = goalId;
-    for (int i = length - 1; i >= 0; i--) {
-        result.nodes[i] = current;
-        current = cameFrom[current];
+    int* cameFrom = (int*)realloc(frontier->cameFrom, capacity * sizeof(int));
+    if (!cameFrom) return false;
+    frontier->cameFrom = cameFrom;
+    
+    unsigned int* mark = (unsigned int*)realloc(frontier->mark, capacity * sizeof(unsigned int));
+    if (!mark) return false;
+    memset(mark + frontier->capacity, 0, (capacity - frontier->capacity) * sizeof(unsigned int));
+    frontier->mark = mark;
+    ASTAR_COUNT(frontier->bytesAllocated += (unsigned long long)(capacity - frontier->capacity) *
+                (sizeof(float) + sizeof(int) + sizeof(unsigned int)));
+    
+    frontier->capacity = capacity;
+    return true;
+}
+
+// Prepare one frontier for a query with the requested open set strategy
+static bool frontier_reset(AStarFrontier* frontier, int nodeCount, PQType openSet) {
+    if (!frontier_reserve(frontier, nodeCount)) return false;
+    
+    if (frontier->openSet.type != openSet) {
+        // Keep the running totals across the switch
+        unsigned long long siftSteps = frontier->openSet.siftSteps;
+        unsigned long long bytesAllocated = frontier->openSet.bytesAllocated;
+        pq_free(&frontier->openSet);
+        if (!pq_init(&frontier->openSet, openSet, 0)) return false;
+        frontier->openSet.siftSteps += siftSteps;
+        frontier->openSet.bytesAllocated += bytesAllocated;
     }
+    if (!pq_reserve_index(&frontier->openSet, frontier->capacity)) return false;
+    pq_clear(&frontier->openSet);
+    return true;
+}
+
+// Bucket width of the open sets for a query (only bucket queues read it)
+static void context_set_bucket_width(AStarContext* ctx, const AStarConfig* cfg, bool bidirectional) {
+    pq_set_bucket_width(&ctx->forward.openSet, cfg->bucketWidth);
+    if (bidirectional) pq_set_bucket_width(&ctx->backward.openSet, cfg->bucketWidth);
+}
+
+#if ASTAR_COUNTERS_ENABLED
+// Running totals of a context, sampled around a query to get its share
+typedef struct {
+    unsigned long long siftSteps;
+    unsigned long long bytesAllocated;
+} ContextTotals;
+
+static ContextTotals context_totals(const AStarContext* ctx) {
+    ContextTotals totals;
+    totals.siftSteps = ctx->forward.openSet.siftSteps + ctx->backward.openSet.siftSteps;
+    totals.bytesAllocated = ctx->forward.bytesAllocated + ctx->backward.bytesAllocated +
+                            ctx->forward.openSet.bytesAllocated + ctx->backward.openSet.bytesAllocated;
+    return totals;
+}
+
+// Fill in the breakdown of a finished query and add it to the histograms
+static void counters_finish(const AStarContext* ctx, const ContextTotals* before,
+                            double startTime, double searchStart, MetricsEngine engine,
+                            const PathResult* result, AStarStats* stats) {
+    ContextTotals after = context_totals(ctx);
+    double endTime = get_time_ms();
+    stats->siftSteps = (int)(after.siftSteps - before->siftSteps);
+    stats->bytesAllocated = (int)(after.bytesAllocated - before->bytesAllocated) +
+                            result->length * (int)sizeof(int);
+    stats->setupMs = (float)(searchStart - startTime);
+    stats->searchMs = (float)(endTime - searchStart) - stats->reconstructMs;
+    metrics_record_global(engine, stats, result->found);
+}
+#endif
+
+bool astar_context_reset(AStarContext* ctx, int nodeCount, PQType openSet, bool bidirectional) {
+    if (!ctx) return false;
+    if (!frontier_reset(&ctx->forward, nodeCount, openSet)) return false;
+    if (bidirectional && !frontier_reset(&ctx->backward, nodeCount, openSet)) return false;
+    
+    // Each query uses two stamps (reached, settled). Stamps only need
+    // clearing when the counter wraps around, once every 2^31 queries.
+    ctx->generation += 2;
+    if (ctx->generation < 2) {
+        memset(ctx->forward.mark, 0, ctx->forward.capacity * sizeof(unsigned int));
+        if (ctx->backward.mark) {
+            memset(ctx->backward.mark, 0, ctx->backward.capacity * sizeof(unsigned int));
+        }
+        ctx->generation = 2;
+    }
+    return true;
+}
+
+// Bidirectional search over a Graph (incoming edges via inEdges) or a CSR
+// (reverse rows); exactly one of graph/csr is set, and the context has been
+// reset with both frontiers. Keys use the average
+// potential p(v) = w * (h(v, goal) - h(start, v)) / 2: forward keys are
+// g + p, backward keys are g - p.
+static PathResult bidirectional_search(
+    AStarContext* ctx,
+    const Graph* graph,
+    const GraphCSR* csr,
+    int startId,
+    int goalId,
+    const AStarConfig* cfg,
+    AStarStats* localStats
+) {
+    PathResult result = path_result_create();
+    AStarTrace* trace = cfg->trace;
+    
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    AStarFrontier* sides[2] = { &ctx->forward, &ctx->backward };
+    
+    // Both layouts keep coordinates in dense arrays
+    const float* nodeX = graph ? graph->nodeX : csr->x;
+    const float* nodeY = graph ? graph->nodeY : csr->y;
+    float startX = nodeX[startId];
+    float startY = nodeY[startId];
+    float goalX = nodeX[goalId];
+    float goalY = nodeY[goalId];
+    float halfWeight = cfg->heuristicWeight * 0.5f;
+    
+    // Seed both frontiers
+    int seeds[2] = { startId, goalId };
+    for (int d = 0; d < 2; d++) {
+        AStarFrontier* side = sides[d];
+        side->gScore[seeds[d]] = 0.0f;
+        side->cameFrom[seeds[d]] = -1;
+        side->mark[seeds[d]] = reached;
+    }
+    // p(start) = w * h / 2 and p(goal) = -w * h / 2, so both seed keys are w * h / 2
+    float seedKey = node_heuristic(cfg, startId, startX, startY, goalId, goalX, goalY) * halfWeight;
+    pq_push(&ctx->forward.openSet, startId, seedKey);
+    pq_push(&ctx->backward.openSet, goalId, seedKey);
+    TRACE(trace, ASTAR_TRACE_PUSH, startId, -1, seedKey, 0);
+    TRACE(trace, ASTAR_TRACE_PUSH, goalId, -1, seedKey, 1);
+    localStats->maxOpenSetSize = 2;
+    
+    float bestCost = (startId == goalId) ? 0.0f : FLT_MAX;
+    int meetingNode = (startId == goalId) ? startId : -1;
+    
+    while (!pq_empty(&ctx->forward.openSet) && !pq_empty(&ctx->backward.openSet)) {
+        int topId;
+        float topForward, topBackward;
+        pq_peek(&ctx->forward.openSet, &topId, &topForward);
+        pq_peek(&ctx->backward.openSet, &topId, &topBackward);
+        
+        // Meeting criterion: no unexplored path can beat the best one
+        if (topForward + topBackward >= bestCost) break;
+        
+        // Expand the side with the smaller open set
+        int d = (ctx->forward.openSet.size <= ctx->backward.openSet.size) ? 0 : 1;
+        AStarFrontier* side = sides[d];
+        AStarFrontier* other = sides[1 - d];
+        
+        int currentId;
+        float currentKey;
+        pq_pop(&side->openSet, &currentId, &currentKey);
+        if (side->mark[currentId] == settled) {
+            ASTAR_COUNT(localStats->stalePops++);
+            continue;  // Stale lazy entry
+        }
+        side->mark[currentId] = settled;
+        TRACE(trace, ASTAR_TRACE_SETTLE, currentId, -1, side->gScore[currentId], d);
+        
+        localStats->nodesExplored++;
+        if (d == 0) localStats->nodesExploredForward++;
+        else localStats->nodesExploredBackward++;
+        
+        float currentG = side->gScore[currentId];
+        int count = 0;
+        if (csr) {
+            count = d == 0 ? csr->offsets[currentId + 1] - csr->offsets[currentId]
+                           : csr->inOffsets[currentId + 1] - csr->inOffsets[currentId];
+        } else {
+            count = d == 0 ? graph->edgeCounts[currentId] : graph->inEdgeCounts[currentId];
+        }
+        
+        for (int i = 0; i < count; i++) {
+            int neighborId;
+            float weight;
+            if (csr) {
+                int e = (d == 0 ? csr->offsets[currentId] : csr->inOffsets[currentId]) + i;
+                neighborId = d == 0 ? csr->to[e] : csr->inFrom[e];
+                weight = d == 0 ? csr->weight[e] : csr->inWeight[e];
+            } else {
+                const Edge* edge;
+                if (d == 0) {
+                    edge = &graph->edges[currentId][i];
+                    neighborId = edge->to;
+                } else {
+                    const EdgeRef* ref = &graph->inEdges[currentId][i];
+                    edge = &graph->edges[ref->from][ref->slot];
+                    neighborId = ref->from;
+                }
+                if (!edge->active || !GRAPH_NODE_ACTIVE(graph, neighborId)) {
+                    ASTAR_COUNT(localStats->edgesSkipped++);
+                    continue;
+                }
+                weight = edge->weight;
+            }
+            
+            unsigned int neighborMark = side->mark[neighborId];
+            if (neighborMark == settled) continue;
+            
+            float tentativeG = currentG + weight;
+            TRACE(trace, ASTAR_TRACE_RELAX, neighborId, currentId, tentativeG, d);
+            ASTAR_COUNT(localStats->edgesRelaxed++);
+            if (neighborMark == reached && tentativeG >= side->gScore[neighborId]) continue;
+            ASTAR_COUNT(localStats->decreaseKeys += neighborMark == reached);
+            
+            side->gScore[neighborId] = tentativeG;
+            side->cameFrom[neighborId] = currentId;
+            side->mark[neighborId] = reached;
+            
+            float nx = nodeX[neighborId];
+            float ny = nodeY[neighborId];
+            float potential = (node_heuristic(cfg, neighborId, nx, ny, goalId, goalX, goalY) -
+                               node_heuristic(cfg, startId, startX, startY, neighborId, nx, ny)) * halfWeight;
+            float key = d == 0 ? tentativeG + potential : tentativeG - potential;
+            pq_update(&side->openSet, neighborId, key);
+            TRACE(trace, ASTAR_TRACE_PUSH, neighborId, currentId, key, d);
+            
+            int openSize = ctx->forward.openSet.size + ctx->backward.openSet.size;
+            if (openSize > localStats->maxOpenSetSize) {
+                localStats->maxOpenSetSize = openSize;
+            }
+            
+            // Record the best path joining the two frontiers
+            if (other->mark[neighborId] >= reached) {
+                float cost = tentativeG + other->gScore[neighborId];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    meetingNode = neighborId;
+                }
+            }
+        }
+    }
+    
+    localStats->nodesInOpenSet = ctx->forward.openSet.size + ctx->backward.openSet.size;
+    if (meetingNode < 0) return result;
     
+    // Stitch start -> meeting node (forward parents) and meeting node -> goal
+#if ASTAR_COUNTERS_ENABLED
+    double reconstructStart = get_time_ms();
+#endif
+    // Forward half fills the scratch from the end in travel order, the
+    // backward half from the front; both trees are acyclic, so the halves
+    // fit in one slot per node
+    int capacity = ctx->forward.capacity;
+    if (!context_reserve_path(ctx, capacity)) return result;
+    int* path = ctx->path;
+    int head = capacity;
+    int tail = 0;
+    int v = meetingNode;
+    for (; v != -1 && head > tail; v = ctx->forward.cameFrom[v]) path[--head] = v;
+    int w = ctx->backward.cameFrom[meetingNode];
+    for (; w != -1 && tail < head; w = ctx->backward.cameFrom[w]) path[tail++] = w;
+    if (v != -1 || w != -1) return result;
+    
+    if (!path_result_take(&result, cfg->arena, path + head, capacity - head, path, tail)) return result;
+    result.totalCost = bestCost;
+    ASTAR_COUNT(localStats->reconstructMs = (float)(get_time_ms() - reconstructStart));
     return result;
 }
 
@@ -232,10 +580,28 @@ PathResult astar_find_path(
     int goalId,
     const AStarConfig* config,
     AStarStats* stats
+) {
+    if (!graph) return path_result_create();
+    
+    AStarContext* ctx = astar_context_create(graph->nodeCount);
+    if (!ctx) return path_result_create();
+    
+    PathResult result = astar_find_path_ctx(ctx, graph, startId, goalId, config, stats);
+    astar_context_free(ctx);
+    return result;
+}
+
+PathResult astar_find_path_ctx(
+    AStarContext* ctx,
+    const Graph* graph,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
 ) {
     PathResult result = path_result_create();
     
-    if (!graph || startId < 0 || goalId < 0 || 
+    if (!ctx || !graph || startId < 0 || goalId < 0 || 
         startId >= graph->nodeCount || goalId >= graph->nodeCount) {
         return result;
     }
@@ -245,131 +611,217 @@ PathResult astar_find_path(
     
     // Initialize stats
     AStarStats localStats = {0};
+    AStarTrace* trace = cfg.trace;
+    trace_begin(trace);
     double startTime = get_time_ms();
+#if ASTAR_COUNTERS_ENABLED
+    ContextTotals before = context_totals(ctx);
+#endif
     
-    int nodeCount = graph->nodeCount;
-    
-    // Allocate working arrays
-    float* gScore = (float*)malloc(nodeCount * sizeof(float));
-    float* fScore = (float*)malloc(nodeCount * sizeof(float));
-    int* cameFrom = (int*)malloc(nodeCount * sizeof(int));
-    bool* inClosedSet = (bool*)calloc(nodeCount, sizeof(bool));
-    bool* inOpenSet = (bool*)calloc(nodeCount, sizeof(bool));
-    
-    if (!gScore || !fScore || !cameFrom || !inClosedSet || !inOpenSet) {
-        free(gScore);
-        free(fScore);
-        free(cameFrom);
-        free(inClosedSet);
-        free(inOpenSet);
-        return result;
+    if (!astar_context_reset(ctx, graph->nodeCount, cfg.openSet, cfg.bidirectional)) return result;
+    context_set_bucket_width(ctx, &cfg, cfg.bidirectional);
+#if ASTAR_COUNTERS_ENABLED
+    double searchStart = get_time_ms();
+#endif
+    
+    if (cfg.bidirectional) {
+        result = bidirectional_search(ctx, graph, NULL, startId, goalId, &cfg, &localStats);
+    } else {
+        GraphKernel kernel = select_graph_kernel(graph, &cfg, stats);
+        result = kernel(ctx, graph, startId, goalId, &cfg, &localStats);
     }
     
-    // Initialize scores to infinity
-    for (int i = 0; i < nodeCount; i++) {
-        gScore[i] = FLT_MAX;
-        fScore[i] = FLT_MAX;
-        cameFrom[i] = -1;
+    // Record timing
+    localStats.searchTimeMs = (float)(get_time_ms() - startTime);
+#if ASTAR_COUNTERS_ENABLED
+    counters_finish(ctx, &before, startTime, searchStart, METRICS_ENGINE_ASTAR, &result, &localStats);
+#endif
+    
+    if (stats) {
+        *stats = localStats;
     }
     
-    // Get start and goal nodes
-    const Node* startNode = &graph->nodes[startId];
-    const Node* goalNode = &graph->nodes[goalId];
+    return result;
+}
+
+// A* over a frozen CSR snapshot
+PathResult astar_find_path_csr(
+    const GraphCSR* csr,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
+) {
+    if (!csr) return path_result_create();
+    
+    AStarContext* ctx = astar_context_create(csr->nodeCount);
+    if (!ctx) return path_result_create();
     
-    // Initialize start node
-    gScore[startId] = 0.0f;
-    float h = astar_heuristic(startNode, goalNode, cfg.heuristic) * cfg.heuristicWeight;
-    fScore[startId] = h;
-    
-    // Create priority queue (open set)
-    PriorityQueue* openSet = pq_create(nodeCount);
-    if (!openSet) {
-        free(gScore);
-        free(fScore);
-        free(cameFrom);
-        free(inClosedSet);
-        free(inOpenSet);
+    PathResult result = astar_find_path_csr_ctx(ctx, csr, startId, goalId, config, stats);
+    astar_context_free(ctx);
+    return result;
+}
+
+PathResult astar_find_path_csr_ctx(
+    AStarContext* ctx,
+    const GraphCSR* csr,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
+) {
+    PathResult result = path_result_create();
+    
+    if (!ctx || !csr || startId < 0 || goalId < 0 ||
+        startId >= csr->nodeCount || goalId >= csr->nodeCount) {
         return result;
     }
     
-    pq_push(openSet, startId, fScore[startId]);
-    inOpenSet[startId] = true;
+    AStarConfig cfg = config ? *config : astar_default_config();
+    
+    AStarStats localStats = {0};
+    AStarTrace* trace = cfg.trace;
+    trace_begin(trace);
+    double startTime = get_time_ms();
+#if ASTAR_COUNTERS_ENABLED
+    ContextTotals before = context_totals(ctx);
+#endif
+    
+    int nodeCount = csr->nodeCount;
+    if (!astar_context_reset(ctx, nodeCount, cfg.openSet, cfg.bidirectional)) return result;
+    context_set_bucket_width(ctx, &cfg, cfg.bidirectional);
+#if ASTAR_COUNTERS_ENABLED
+    double searchStart = get_time_ms();
+#endif
+    
+    if (cfg.bidirectional) {
+        result = bidirectional_search(ctx, NULL, csr, startId, goalId, &cfg, &localStats);
+        localStats.searchTimeMs = (float)(get_time_ms() - startTime);
+#if ASTAR_COUNTERS_ENABLED
+        counters_finish(ctx, &before, startTime, searchStart, METRICS_ENGINE_CSR, &result, &localStats);
+#endif
+        if (stats) *stats = localStats;
+        return result;
+    }
+    
+    float* gScore = ctx->forward.gScore;
+    int* cameFrom = ctx->forward.cameFrom;
+    unsigned int* mark = ctx->forward.mark;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    PriorityQueue* openSet = &ctx->forward.openSet;
+    
+    const float* xs = csr->x;
+    const float* ys = csr->y;
+    float goalX = xs[goalId];
+    float goalY = ys[goalId];
+    
+    // Heuristic resolved once for the vectorized rows
+    RelaxKernel kernel;
+    relax_kernel_init(&kernel, &cfg, xs, ys, goalId);
+    
+    gScore[startId] = 0.0f;
+    cameFrom[startId] = -1;
+    mark[startId] = reached;
+    float h = node_heuristic(&cfg, startId, xs[startId], ys[startId], goalId, goalX, goalY) * cfg.heuristicWeight;
+    pq_push(openSet, startId, h);
+    TRACE(trace, ASTAR_TRACE_PUSH, startId, -1, h, 0);
     localStats.maxOpenSetSize = 1;
     
-    // Main A* loop
     while (!pq_empty(openSet)) {
         int currentId;
         float currentFScore;
         pq_pop(openSet, &currentId, &currentFScore);
-        inOpenSet[currentId] = false;
+        
+        if (mark[currentId] == settled) {
+            ASTAR_COUNT(localStats.stalePops++);
+            continue;
+        }
+        TRACE(trace, ASTAR_TRACE_SETTLE, currentId, -1, gScore[currentId], 0);
         
         localStats.nodesExplored++;
+        localStats.nodesExploredForward++;
         
-        // Check if we reached the goal
         if (currentId == goalId) {
-            result = reconstruct_path(cameFrom, gScore, startId, goalId, nodeCount);
+            result = reconstruct_path_timed(ctx, &cfg, startId, goalId, nodeCount, &localStats);
             localStats.nodesInOpenSet = openSet->size;
             break;
         }
         
-        // Skip if already in closed set (can happen due to lazy deletion)
-        if (inClosedSet[currentId]) continue;
-        inClosedSet[currentId] = true;
+        mark[currentId] = settled;
         
-        const Node* currentNode = &graph->nodes[currentId];
+        // Rows only hold live edges, so no tombstone checks are needed
+        float currentG = gScore[currentId];
+        int rowStart = csr->offsets[currentId];
+        int rowEnd = csr->offsets[currentId + 1];
         
-        // Explore neighbors
-        for (int i = 0; i < graph->edgeCounts[currentId]; i++) {
-            const Edge* edge = &graph->edges[currentId][i];
-            if (!edge->active) continue;
-            
-            int neighborId = edge->to;
-            if (!graph->nodes[neighborId].active) continue;
-            if (inClosedSet[neighborId]) continue;
-            
-            // Calculate tentative g score
-            float tentativeG = gScore[currentId] + edge->weight;
-            
-            if (tentativeG < gScore[neighborId]) {
-                // This is a better path
-                const Node* neighborNode = &graph->nodes[neighborId];
+        // Hubs: score the row in blocks with the vector kernel first
+        if (rowEnd - rowStart >= RELAX_MIN_EDGES) {
+            float tentative[RELAX_BLOCK];
+            float keys[RELAX_BLOCK];
+            for (int block = rowStart; block < rowEnd; block += RELAX_BLOCK) {
+                int count = rowEnd - block < RELAX_BLOCK ? rowEnd - block : RELAX_BLOCK;
+                kernel.run(&kernel, csr->to + block, csr->weight + block, count, currentG, tentative, keys);
                 
+                for (int i = 0; i < count; i++) {
+                    int neighborId = csr->to[block + i];
+                    unsigned int neighborMark = mark[neighborId];
+                    if (neighborMark == settled) continue;
+                    
+                    float tentativeG = tentative[i];
+                    TRACE(trace, ASTAR_TRACE_RELAX, neighborId, currentId, tentativeG, 0);
+                    ASTAR_COUNT(localStats.edgesRelaxed++);
+                    if (neighborMark != reached || tentativeG < gScore[neighborId]) {
+                        ASTAR_COUNT(localStats.decreaseKeys += neighborMark == reached);
+                        cameFrom[neighborId] = currentId;
+                        gScore[neighborId] = tentativeG;
+                        mark[neighborId] = reached;
+                        
+                        pq_update(openSet, neighborId, keys[i]);
+                        TRACE(trace, ASTAR_TRACE_PUSH, neighborId, currentId, keys[i], 0);
+                        if (openSet->size > localStats.maxOpenSetSize) {
+                            localStats.maxOpenSetSize = openSet->size;
+                        }
+                    }
+                }
+            }
+            continue;
+        }
+        
+        for (int e = rowStart; e < rowEnd; e++) {
+            int neighborId = csr->to[e];
+            unsigned int neighborMark = mark[neighborId];
+            if (neighborMark == settled) continue;
+            
+            float tentativeG = currentG + csr->weight[e];
+            TRACE(trace, ASTAR_TRACE_RELAX, neighborId, currentId, tentativeG, 0);
+            ASTAR_COUNT(localStats.edgesRelaxed++);
+            if (neighborMark != reached || tentativeG < gScore[neighborId]) {
+                ASTAR_COUNT(localStats.decreaseKeys += neighborMark == reached);
                 cameFrom[neighborId] = currentId;
                 gScore[neighborId] = tentativeG;
-                h = astar_heuristic(neighborNode, goalNode, cfg.heuristic) * cfg.heuristicWeight;
-                fScore[neighborId] = tentativeG + h;
+                mark[neighborId] = reached;
+                h = node_heuristic(&cfg, neighborId, xs[neighborId], ys[neighborId],
+                                   goalId, goalX, goalY) * cfg.heuristicWeight;
                 
-                // Add to open set if not already there
-                if (!inOpenSet[neighborId]) {
-                    pq_push(openSet, neighborId, fScore[neighborId]);
-                    inOpenSet[neighborId] = true;
-                    
-                    if (openSet->size > localStats.maxOpenSetSize) {
-                        localStats.maxOpenSetSize = openSet->size;
-                    }
-                } else {
-                    // Update priority
-                    pq_decrease_priority(openSet, neighborId, fScore[neighborId]);
+                pq_update(openSet, neighborId, tentativeG + h);
+                TRACE(trace, ASTAR_TRACE_PUSH, neighborId, currentId, tentativeG + h, 0);
+                if (openSet->size > localStats.maxOpenSetSize) {
+                    localStats.maxOpenSetSize = openSet->size;
                 }
             }
         }
     }
     
-    // Record timing
     localStats.searchTimeMs = (float)(get_time_ms() - startTime);
+#if ASTAR_COUNTERS_ENABLED
+    counters_finish(ctx, &before, startTime, searchStart, METRICS_ENGINE_CSR, &result, &localStats);
+#endif
     
     if (stats) {
         *stats = localStats;
     }
     
-    // Cleanup
-    pq_free(openSet);
-    free(gScore);
-    free(fScore);
-    free(cameFrom);
-    free(inClosedSet);
-    free(inOpenSet);
-    
     return result;
 }
 
@@ -381,74 +833,24 @@ int astar_get_exploration_order(
     int* explored,
     int maxNodes
 ) {
-    if (!graph || !explored || startId < 0 || goalId < 0) return 0;
-    
-    int nodeCount = graph->nodeCount;
-    float* gScore = (float*)malloc(nodeCount * sizeof(float));
-    bool* inClosedSet = (bool*)calloc(nodeCount, sizeof(bool));
-    bool* inOpenSet = (bool*)calloc(nodeCount, sizeof(bool));
-    
-    if (!gScore || !inClosedSet || !inOpenSet) {
-        free(gScore);
-        free(inClosedSet);
-        free(inOpenSet);
-        return 0;
-    }
-    
-    for (int i = 0; i < nodeCount; i++) {
-        gScore[i] = FLT_MAX;
-    }
-    gScore[startId] = 0.0f;
+    if (!graph || !explored || maxNodes <= 0) return 0;
     
-    const Node* goalNode = &graph->nodes[goalId];
+    AStarTraceEvent* events = (AStarTraceEvent*)malloc(maxNodes * sizeof(AStarTraceEvent));
+    if (!events) return 0;
     
-    PriorityQueue* openSet = pq_create(nodeCount);
-    float h = astar_heuristic(&graph->nodes[startId], goalNode, HEURISTIC_EUCLIDEAN);
-    pq_push(openSet, startId, h);
-    inOpenSet[startId] = true;
+    AStarTrace trace = {0};
+    trace.events = events;
+    trace.capacity = maxNodes;
+    trace.kinds = ASTAR_TRACE_MASK(ASTAR_TRACE_SETTLE);
     
-    int exploredCount = 0;
+    AStarConfig config = astar_default_config();
+    config.trace = &trace;
+    PathResult result = astar_find_path(graph, startId, goalId, &config, NULL);
+    path_result_free(&result);
     
-    while (!pq_empty(openSet) && exploredCount < maxNodes) {
-        int currentId;
-        float currentFScore;
-        pq_pop(openSet, &currentId, &currentFScore);
-        inOpenSet[currentId] = false;
-        
-        if (inClosedSet[currentId]) continue;
-        inClosedSet[currentId] = true;
-        
-        explored[exploredCount++] = currentId;
-        
-        if (currentId == goalId) break;
-        
-        for (int i = 0; i < graph->edgeCounts[currentId]; i++) {
-            const Edge* edge = &graph->edges[currentId][i];
-            if (!edge->active) continue;
-            
-            int neighborId = edge->to;
-            if (!graph->nodes[neighborId].active) continue;
-            if (inClosedSet[neighborId]) continue;
-            
-            float tentativeG = gScore[currentId] + edge->weight;
-            
-            if (tentativeG < gScore[neighborId]) {
-                gScore[neighborId] = tentativeG;
-                h = astar_heuristic(&graph->nodes[neighborId], goalNode, HEURISTIC_EUCLIDEAN);
-                float fScore = tentativeG + h;
-                
-                if (!inOpenSet[neighborId]) {
-                    pq_push(openSet, neighborId, fScore);
-                    inOpenSet[neighborId] = true;
-                }
-            }
-        }
+    for (int i = 0; i < trace.count; i++) {
+        explored[i] = events[i].node;
     }
-    
-    pq_free(openSet);
-    free(gScore);
-    free(inClosedSet);
-    free(inOpenSet);
-    
-    return exploredCount;
+    free(events);
+    return trace.count;
 }
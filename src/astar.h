@@ -23,6 +23,9 @@
 #define ASTAR_H
 
 #include "graph.h"
+#include "pqueue.h"
+#include "landmarks.h"
+#include "arena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,15 +36,79 @@ typedef enum {
     HEURISTIC_EUCLIDEAN,     // Standard straight-line distance
     HEURISTIC_MANHATTAN,     // Grid-based distance (|dx| + |dy|)
     HEURISTIC_CHEBYSHEV,     // Diagonal distance (max(|dx|, |dy|))
-    HEURISTIC_ZERO           // Dijkstra's algorithm (no heuristic)
+    HEURISTIC_ZERO,          // Dijkstra's algorithm (no heuristic)
+    HEURISTIC_LANDMARKS      // ALT bounds from AStarConfig.landmarks
 } HeuristicType;
 
+// Search events that can be traced
+typedef enum {
+    ASTAR_TRACE_SETTLE,      // Node taken from the open set and expanded
+    ASTAR_TRACE_RELAX,       // Edge scanned towards a node not yet settled
+    ASTAR_TRACE_PUSH,        // Node inserted into the open set or its key lowered
+    ASTAR_TRACE_KIND_COUNT
+} AStarTraceKind;
+
+#define ASTAR_TRACE_MASK(kind) (1u << (kind))
+#define ASTAR_TRACE_ALL ((1u << ASTAR_TRACE_KIND_COUNT) - 1)
+
+// One traced event
+typedef struct {
+    int node;
+    int from;                // Node the edge starts at (-1 for settles and seeds)
+    float value;             // g for settles and relaxations, open-set key for pushes
+    unsigned char kind;      // AStarTraceKind
+    unsigned char backward;  // 1 for events of the backward frontier
+} AStarTraceEvent;
+
+// Event sink for a single search
+// The caller owns the buffer. Each search resets count and total; events
+// past capacity are counted in total but not stored. onRecord runs after
+// every stored event, on the searching thread; events[0 .. count) are
+// final by then, so it can publish count to a thread that reads the
+// buffer while the search runs.
+typedef struct {
+    AStarTraceEvent* events;
+    int capacity;
+    int count;               // Events stored
+    int total;               // Events that occurred (matching kinds)
+    unsigned int kinds;      // ASTAR_TRACE_MASK bits to record
+    void (*onRecord)(void* user, int count);  // NULL = none
+    void* user;
+} AStarTrace;
+
+// Hot-path counters. Builds with ASTAR_COUNTERS defined (make COUNTERS=1)
+// fill the breakdown fields of AStarStats and feed the process-wide
+// histograms in metrics.h; without it those fields stay 0 and the search
+// loops carry no counting code.
+#ifdef ASTAR_COUNTERS
+#define ASTAR_COUNTERS_ENABLED 1
+#define ASTAR_COUNT(stmt) do { stmt; } while (0)
+#else
+#define ASTAR_COUNTERS_ENABLED 0
+#define ASTAR_COUNT(stmt) do { } while (0)
+#endif
+
 // A* search statistics for visualization and analysis
 typedef struct {
     int nodesExplored;       // Total nodes visited
     int nodesInOpenSet;      // Nodes still in open set when path found
     int maxOpenSetSize;      // Maximum size of open set during search
     float searchTimeMs;      // Time taken for search
+    
+    // Per-frontier split (backward is 0 for unidirectional searches)
+    int nodesExploredForward;
+    int nodesExploredBackward;
+    
+    // Breakdown (ASTAR_COUNTERS builds only)
+    int edgesRelaxed;        // Edges scanned towards nodes not yet settled
+    int edgesSkipped;        // Inactive edges, or edges to removed nodes
+    int stalePops;           // Open set pops of nodes already settled
+    int decreaseKeys;        // Better paths to nodes already in the open set
+    int siftSteps;           // Heap levels moved by the open sets
+    float setupMs;           // Context reset (growing the arrays on a new graph)
+    float searchMs;          // Main loop
+    float reconstructMs;     // Path extraction
+    int bytesAllocated;      // Search buffer growth plus the returned path
 } AStarStats;
 
 // A* algorithm configuration
@@ -49,14 +116,74 @@ typedef struct {
     HeuristicType heuristic;
     float heuristicWeight;   // Weight for heuristic (1.0 = standard A*, >1 = greedy)
     bool allowDiagonal;      // Allow diagonal movement (for grid-based maps)
+    PQType openSet;          // Open set strategy (indexed heap, lazy heap or bucket queue)
+    float bucketWidth;       // Key range per bucket for PQ_BUCKET_QUEUE (0 = default)
+    bool bidirectional;      // Search from both ends and meet in the middle
+    const LandmarkTable* landmarks;  // Table for HEURISTIC_LANDMARKS (NULL = Dijkstra)
+    AStarTrace* trace;       // Event sink (NULL = off; not shared across threads)
+    PathArena* arena;        // Where found paths are allocated (NULL = malloc each)
 } AStarConfig;
 
+// One search direction: scores, parents and open set
+// gScore/cameFrom of a node are only meaningful while its mark is
+// ASTAR_MARK_REACHED or ASTAR_MARK_SETTLED for the current generation.
+// In a backward search cameFrom holds the next node towards the goal.
+typedef struct {
+    float* gScore;
+    int* cameFrom;
+    unsigned int* mark;      // Generation stamp per node
+    int capacity;
+    PriorityQueue openSet;
+    unsigned long long bytesAllocated;  // Running total of array growth (ASTAR_COUNTERS)
+} AStarFrontier;
+
+// Reusable search state
+// Create one context per thread and pass it to repeated queries. The
+// arrays grow with the graph and are never cleared: each query takes a new
+// generation, so resetting is O(1) instead of O(V). The backward frontier
+// is only allocated once a bidirectional query needs it.
+typedef struct {
+    AStarFrontier forward;
+    AStarFrontier backward;
+    unsigned int generation;
+    
+    // Path scratch: reconstruction writes the nodes here in one walk of
+    // cameFrom, then copies them out in a single allocation
+    int* path;
+    int pathCapacity;
+} AStarContext;
+
+#define ASTAR_MARK_REACHED(ctx) ((ctx)->generation)
+#define ASTAR_MARK_SETTLED(ctx) ((ctx)->generation + 1)
+
 // Default configuration
 AStarConfig astar_default_config(void);
 
+// Monotonic clock in milliseconds (shared by the search engines for stats)
+double astar_time_ms(void);
+
+// Context lifecycle
+AStarContext* astar_context_create(int nodeCapacity);
+void astar_context_free(AStarContext* ctx);
+
+/**
+ * Start a new query on a context: grow it to nodeCount nodes if needed,
+ * take a fresh generation and empty the open sets.
+ * 
+ * @param bidirectional  Also prepare the backward frontier
+ * @return               false if the arrays could not be grown
+ */
+bool astar_context_reset(AStarContext* ctx, int nodeCount, PQType openSet, bool bidirectional);
+
 /**
  * Find the shortest path between two nodes using A* algorithm
  * 
+ * With config->bidirectional set, a forward search from startId and a
+ * backward search (over incoming edges) from goalId run in alternation.
+ * Both use the average potential (h(v, goal) - h(start, v)) / 2, which
+ * keeps them consistent, and stop once the two smallest open-set keys
+ * add up to at least the best meeting cost found so far.
+ * 
  * @param graph     The graph to search
  * @param startId   Starting node ID
  * @param goalId    Goal node ID
@@ -72,9 +199,56 @@ PathResult astar_find_path(
     AStarStats* stats
 );
 
+/**
+ * Same as astar_find_path, but reuses the arrays and open set of ctx
+ * instead of allocating them per query.
+ */
+PathResult astar_find_path_ctx(
+    AStarContext* ctx,
+    const Graph* graph,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
+);
+
+/**
+ * Find the shortest path on a frozen CSR snapshot (see graph_freeze)
+ * 
+ * Same search as astar_find_path, but the relaxation loop walks the
+ * contiguous to/weight arrays of the snapshot. Use HEURISTIC_ZERO in the
+ * config for Dijkstra's algorithm.
+ * 
+ * @param csr       The frozen graph to search
+ * @param startId   Starting node ID
+ * @param goalId    Goal node ID
+ * @param config    Algorithm configuration (can be NULL for defaults)
+ * @param stats     Output statistics (can be NULL if not needed)
+ * @return          PathResult containing the path (call path_result_free when done)
+ */
+PathResult astar_find_path_csr(
+    const GraphCSR* csr,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
+);
+
+PathResult astar_find_path_csr_ctx(
+    AStarContext* ctx,
+    const GraphCSR* csr,
+    int startId,
+    int goalId,
+    const AStarConfig* config,
+    AStarStats* stats
+);
+
 /**
  * Calculate heuristic distance between two nodes
  * 
+ * Coordinate heuristics only; HEURISTIC_LANDMARKS needs a table, so it
+ * returns 0 here (use landmarks_lower_bound instead).
+ * 
  * @param a          First node
  * @param b          Second node
  * @param type       Type of heuristic to use
@@ -82,10 +256,16 @@ PathResult astar_find_path(
  */
 float astar_heuristic(const Node* a, const Node* b, HeuristicType type);
 
+// Same on raw coordinates (e.g. Graph.nodeX / nodeY)
+float astar_heuristic_xy(float ax, float ay, float bx, float by, HeuristicType type);
+
 /**
  * Visualize the A* search process (for debugging/educational purposes)
  * Returns an array of node IDs in the order they were explored
  * 
+ * Runs astar_find_path with the default configuration and a settle-only
+ * trace; pass a trace in AStarConfig to get the order from the real query.
+ * 
  * @param graph     The graph to search
  * @param startId   Starting node ID
  * @param goalId    Goal node ID
@@ -0,0 +1,218 @@
+/**
+ * astar_kernel.h - Specialized A* search loops over a Graph
+ *
+ * Not a regular header: astar.c includes it once per heuristic, after
+ * defining ASTAR_KERNEL_HEURISTIC (a HeuristicType constant) and
+ * ASTAR_KERNEL_PREFIX. The file then includes itself once per feature
+ * combination to define PREFIX_w<W>_t<T>_i<I>, where
+ *
+ *   W (ASTAR_KERNEL_WEIGHTED)      1 scales h by heuristicWeight, 0 is weight 1
+ *   T (ASTAR_KERNEL_TOMBSTONES)    1 skips inactive edges and nodes, 0 is for
+ *                                  graphs without dead slots
+ *   I (ASTAR_KERNEL_INSTRUMENTED)  1 fills the stats and records trace events
+ *                                  (always chosen in ASTAR_COUNTERS builds)
+ *
+ * The heuristic is a constant, so its switch folds away once inlined, and
+ * the disabled features are removed by the preprocessor: each instance
+ * only carries the work it needs. Every parameter is undefined again
+ * before the file returns.
+ */
+
+#ifndef ASTAR_KERNEL_BODY
+
+#define ASTAR_KERNEL_BODY
+#define ASTAR_KERNEL_JOIN2(a, b) a##b
+#define ASTAR_KERNEL_JOIN(a, b) ASTAR_KERNEL_JOIN2(a, b)
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w0_t0_i0)
+#define ASTAR_KERNEL_WEIGHTED 0
+#define ASTAR_KERNEL_TOMBSTONES 0
+#define ASTAR_KERNEL_INSTRUMENTED 0
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w0_t0_i1)
+#define ASTAR_KERNEL_WEIGHTED 0
+#define ASTAR_KERNEL_TOMBSTONES 0
+#define ASTAR_KERNEL_INSTRUMENTED 1
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w0_t1_i0)
+#define ASTAR_KERNEL_WEIGHTED 0
+#define ASTAR_KERNEL_TOMBSTONES 1
+#define ASTAR_KERNEL_INSTRUMENTED 0
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w0_t1_i1)
+#define ASTAR_KERNEL_WEIGHTED 0
+#define ASTAR_KERNEL_TOMBSTONES 1
+#define ASTAR_KERNEL_INSTRUMENTED 1
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w1_t0_i0)
+#define ASTAR_KERNEL_WEIGHTED 1
+#define ASTAR_KERNEL_TOMBSTONES 0
+#define ASTAR_KERNEL_INSTRUMENTED 0
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w1_t0_i1)
+#define ASTAR_KERNEL_WEIGHTED 1
+#define ASTAR_KERNEL_TOMBSTONES 0
+#define ASTAR_KERNEL_INSTRUMENTED 1
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w1_t1_i0)
+#define ASTAR_KERNEL_WEIGHTED 1
+#define ASTAR_KERNEL_TOMBSTONES 1
+#define ASTAR_KERNEL_INSTRUMENTED 0
+#include "astar_kernel.h"
+
+#define ASTAR_KERNEL_NAME ASTAR_KERNEL_JOIN(ASTAR_KERNEL_PREFIX, _w1_t1_i1)
+#define ASTAR_KERNEL_WEIGHTED 1
+#define ASTAR_KERNEL_TOMBSTONES 1
+#define ASTAR_KERNEL_INSTRUMENTED 1
+#include "astar_kernel.h"
+
+#undef ASTAR_KERNEL_JOIN
+#undef ASTAR_KERNEL_JOIN2
+#undef ASTAR_KERNEL_BODY
+#undef ASTAR_KERNEL_PREFIX
+#undef ASTAR_KERNEL_HEURISTIC
+
+#else
+
+// One kernel; the context must already be reset for a unidirectional query
+static PathResult ASTAR_KERNEL_NAME(
+    AStarContext* ctx,
+    const Graph* graph,
+    int startId,
+    int goalId,
+    const AStarConfig* cfg,
+    AStarStats* stats
+) {
+    PathResult result = path_result_create();
+    
+    float* gScore = ctx->forward.gScore;
+    int* cameFrom = ctx->forward.cameFrom;
+    unsigned int* mark = ctx->forward.mark;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    PriorityQueue* openSet = &ctx->forward.openSet;
+    
+#if ASTAR_KERNEL_INSTRUMENTED
+    AStarTrace* trace = cfg->trace;
+#endif
+    
+    // Coordinates come from the dense arrays, not the Node records
+    const float* nodeX = graph->nodeX;
+    const float* nodeY = graph->nodeY;
+    float goalX = nodeX[goalId];
+    float goalY = nodeY[goalId];
+    const LandmarkTable* landmarks = cfg->landmarks;
+    (void)landmarks;
+#if ASTAR_KERNEL_WEIGHTED
+    const float heuristicWeight = cfg->heuristicWeight;
+#define ASTAR_KERNEL_SCALE(h) ((h) * heuristicWeight)
+#else
+#define ASTAR_KERNEL_SCALE(h) (h)
+#endif
+#define ASTAR_KERNEL_H(id) ASTAR_KERNEL_SCALE(typed_heuristic(ASTAR_KERNEL_HEURISTIC, landmarks, \
+    (id), nodeX[id], nodeY[id], goalId, goalX, goalY))
+    
+    // Initialize start node
+    gScore[startId] = 0.0f;
+    cameFrom[startId] = -1;
+    mark[startId] = reached;
+    float h = ASTAR_KERNEL_H(startId);
+    
+    pq_push(openSet, startId, h);
+#if ASTAR_KERNEL_INSTRUMENTED
+    TRACE(trace, ASTAR_TRACE_PUSH, startId, -1, h, 0);
+    stats->maxOpenSetSize = 1;
+#endif
+    
+    // Main A* loop
+    while (!pq_empty(openSet)) {
+        int currentId;
+        float currentFScore;
+        pq_pop(openSet, &currentId, &currentFScore);
+    
+        // Skip stale entries left behind by the lazy heap
+        if (mark[currentId] == settled) {
+            ASTAR_COUNT(stats->stalePops++);
+            continue;
+        }
+#if ASTAR_KERNEL_INSTRUMENTED
+        TRACE(trace, ASTAR_TRACE_SETTLE, currentId, -1, gScore[currentId], 0);
+        stats->nodesExplored++;
+        stats->nodesExploredForward++;
+#endif
+    
+        // Check if we reached the goal
+        if (currentId == goalId) {
+            result = reconstruct_path_timed(ctx, cfg, startId, goalId, graph->nodeCount, stats);
+#if ASTAR_KERNEL_INSTRUMENTED
+            stats->nodesInOpenSet = openSet->size;
+#endif
+            break;
+        }
+    
+        mark[currentId] = settled;
+        float currentG = gScore[currentId];
+    
+        // Explore neighbors
+        const Edge* row = graph->edges[currentId];
+        int rowCount = graph->edgeCounts[currentId];
+        for (int i = 0; i < rowCount; i++) {
+            const Edge* edge = &row[i];
+            int neighborId = edge->to;
+#if ASTAR_KERNEL_TOMBSTONES
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, neighborId)) {
+                ASTAR_COUNT(stats->edgesSkipped++);
+                continue;
+            }
+#endif
+    
+            // Unreached nodes (older stamps) have an implicit g of infinity
+            unsigned int neighborMark = mark[neighborId];
+            if (neighborMark == settled) continue;
+    
+            // Calculate tentative g score
+            float tentativeG = currentG + edge->weight;
+#if ASTAR_KERNEL_INSTRUMENTED
+            TRACE(trace, ASTAR_TRACE_RELAX, neighborId, currentId, tentativeG, 0);
+            ASTAR_COUNT(stats->edgesRelaxed++);
+#endif
+    
+            if (neighborMark != reached || tentativeG < gScore[neighborId]) {
+                // This is a better path
+#if ASTAR_KERNEL_INSTRUMENTED
+                ASTAR_COUNT(stats->decreaseKeys += neighborMark == reached);
+#endif
+                cameFrom[neighborId] = currentId;
+                gScore[neighborId] = tentativeG;
+                mark[neighborId] = reached;
+                h = ASTAR_KERNEL_H(neighborId);
+    
+                // Add to open set, or move it up if already there
+                pq_update(openSet, neighborId, tentativeG + h);
+#if ASTAR_KERNEL_INSTRUMENTED
+                TRACE(trace, ASTAR_TRACE_PUSH, neighborId, currentId, tentativeG + h, 0);
+                if (openSet->size > stats->maxOpenSetSize) {
+                    stats->maxOpenSetSize = openSet->size;
+                }
+#endif
+            }
+        }
+    }
+    
+    return result;
+}
+
+#undef ASTAR_KERNEL_H
+#undef ASTAR_KERNEL_SCALE
+#undef ASTAR_KERNEL_NAME
+#undef ASTAR_KERNEL_WEIGHTED
+#undef ASTAR_KERNEL_TOMBSTONES
+#undef ASTAR_KERNEL_INSTRUMENTED
+
+#endif // ASTAR_KERNEL_BODY
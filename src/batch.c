@@ -0,0 +1,245 @@
+/**
+ * batch.c - Work-stealing batch query executor
+ */
+
+#include "batch.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Chunk range [head, tail) packed into one word, so that the owner taking
+// from the front and thieves taking from the back agree through a single
+// compare-and-swap
+#define RANGE_PACK(head, tail) (((unsigned long long)(unsigned int)(head) << 32) | (unsigned int)(tail))
+#define RANGE_HEAD(range) ((int)((range) >> 32))
+#define RANGE_TAIL(range) ((int)((range) & 0xFFFFFFFFu))
+
+typedef struct BatchJob BatchJob;
+
+// Per-worker state, padded so neighbouring ranges do not share a cache line
+typedef struct {
+    atomic_ullong range;
+    char padding[64 - sizeof(atomic_ullong)];
+    BatchJob* job;
+    int index;
+    Thread thread;
+    PathArena arena;         // Paths found by this worker (when the job has an arena)
+} BatchWorker;
+
+struct BatchJob {
+    const Graph* graph;      // Exactly one of graph/csr is set
+    const GraphCSR* csr;
+    const BatchQuery* queries;
+    int count;
+    int chunkSize;
+    AStarConfig config;
+    PathResult* results;
+    AStarStats* stats;
+    
+    BatchWorker* workers;
+    int workerCount;
+    atomic_bool failed;
+};
+
+// Take the first chunk of the worker's own range
+static bool batch_take_own(BatchWorker* worker, int* chunk) {
+    unsigned long long range = atomic_load(&worker->range);
+    while (RANGE_HEAD(range) < RANGE_TAIL(range)) {
+        unsigned long long next = RANGE_PACK(RANGE_HEAD(range) + 1, RANGE_TAIL(range));
+        if (atomic_compare_exchange_weak(&worker->range, &range, next)) {
+            *chunk = RANGE_HEAD(range);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Move the back half of some victim's range into the thief's (empty) range
+static bool batch_steal(BatchWorker* thief) {
+    BatchJob* job = thief->job;
+    for (int k = 1; k < job->workerCount; k++) {
+        BatchWorker* victim = &job->workers[(thief->index + k) % job->workerCount];
+        unsigned long long range = atomic_load(&victim->range);
+    
+        while (RANGE_HEAD(range) < RANGE_TAIL(range)) {
+            int head = RANGE_HEAD(range);
+            int tail = RANGE_TAIL(range);
+            int split = tail - (tail - head + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &range, RANGE_PACK(head, split))) {
+                atomic_store(&thief->range, RANGE_PACK(split, tail));
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void batch_run_chunk(BatchJob* job, AStarContext* ctx, const AStarConfig* config, int chunk) {
+    int begin = chunk * job->chunkSize;
+    int end = begin + job->chunkSize;
+    if (end > job->count) end = job->count;
+    
+    for (int i = begin; i < end; i++) {
+        const BatchQuery* q = &job->queries[i];
+        AStarStats* stats = job->stats ? &job->stats[i] : NULL;
+        if (job->csr) {
+            job->results[i] = astar_find_path_csr_ctx(ctx, job->csr, q->startId, q->goalId, config, stats);
+        } else {
+            job->results[i] = astar_find_path_ctx(ctx, job->graph, q->startId, q->goalId, config, stats);
+        }
+    }
+}
+
+// Chunks are never created after the start, so a worker is done once its
+// own range and every victim's range are empty
+static void batch_worker_run(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    BatchJob* job = worker->job;
+    
+    int nodeCount = job->csr ? job->csr->nodeCount : job->graph->nodeCount;
+    AStarContext* ctx = astar_context_create(nodeCount);
+    if (!ctx) {
+        atomic_store(&job->failed, true);
+        return;
+    }
+    
+    // The caller's arena is not thread-safe: fill a private one instead
+    AStarConfig config = job->config;
+    if (config.arena) config.arena = &worker->arena;
+    
+    int chunk;
+    while (true) {
+        if (batch_take_own(worker, &chunk)) {
+            batch_run_chunk(job, ctx, &config, chunk);
+        } else if (!batch_steal(worker)) {
+            break;
+        }
+    }
+    astar_context_free(ctx);
+}
+
+// Move every path out of the worker arenas into one run of the caller's
+// arena, in query order (falls back to one malloc per path if the run
+// cannot be allocated; a path that cannot be kept at all is dropped)
+static void batch_gather_paths(BatchJob* job) {
+    long long total = 0;
+    for (int i = 0; i < job->count; i++) total += job->results[i].length;
+    if (total == 0) return;
+    
+    int* run = total <= 0x7FFFFFFF ? path_arena_alloc(job->config.arena, (int)total) : NULL;
+    for (int i = 0; i < job->count; i++) {
+        PathResult* result = &job->results[i];
+        if (!result->nodes) continue;
+    
+        int* nodes = run ? run : (int*)malloc(result->length * sizeof(int));
+        if (!nodes) {
+            *result = path_result_create();
+            atomic_store(&job->failed, true);
+            continue;
+        }
+        memcpy(nodes, result->nodes, result->length * sizeof(int));
+        result->nodes = nodes;
+        result->inArena = run != NULL;
+        if (run) run += result->length;
+    }
+}
+
+static bool batch_run(BatchJob* job, int threadCount) {
+    for (int i = 0; i < job->count; i++) {
+        job->results[i] = path_result_create();
+    }
+    atomic_init(&job->failed, false);
+    
+    int workerCount = thread_worker_count(threadCount, job->count);
+    
+    // About 16 chunks per worker leaves room to rebalance
+    job->chunkSize = job->count / (workerCount * 16);
+    if (job->chunkSize < 1) job->chunkSize = 1;
+    if (job->chunkSize > BATCH_MAX_CHUNK) job->chunkSize = BATCH_MAX_CHUNK;
+    int chunkCount = (job->count + job->chunkSize - 1) / job->chunkSize;
+    
+    job->workers = (BatchWorker*)calloc(workerCount, sizeof(BatchWorker));
+    bool* started = (bool*)calloc(workerCount, sizeof(bool));
+    if (!job->workers || !started) {
+        free(job->workers);
+        free(started);
+        return false;
+    }
+    job->workerCount = workerCount;
+    for (int w = 0; w < workerCount; w++) path_arena_init(&job->workers[w].arena, 0);
+    
+    // Deal the chunks out evenly before any worker starts
+    for (int w = 0; w < workerCount; w++) {
+        int head = (int)((long long)chunkCount * w / workerCount);
+        int tail = (int)((long long)chunkCount * (w + 1) / workerCount);
+        atomic_init(&job->workers[w].range, RANGE_PACK(head, tail));
+        job->workers[w].job = job;
+        job->workers[w].index = w;
+    }
+    
+    // The calling thread is worker 0; unstarted workers' chunks get stolen
+    for (int w = 1; w < workerCount; w++) {
+        started[w] = thread_start(&job->workers[w].thread, batch_worker_run, &job->workers[w]);
+    }
+    batch_worker_run(&job->workers[0]);
+    for (int w = 1; w < workerCount; w++) {
+        if (started[w]) thread_join(&job->workers[w].thread);
+    }
+    
+    if (job->config.arena) {
+        batch_gather_paths(job);
+        for (int w = 0; w < workerCount; w++) path_arena_free(&job->workers[w].arena);
+    }
+    free(job->workers);
+    free(started);
+    return !atomic_load(&job->failed);
+}
+
+bool astar_find_paths_batch(
+    const Graph* graph,
+    const BatchQuery* queries,
+    int count,
+    const AStarConfig* config,
+    PathResult* results,
+    AStarStats* stats,
+    int threadCount
+) {
+    if (!graph || count < 0) return false;
+    if (count == 0) return true;
+    if (!queries || !results) return false;
+    
+    BatchJob job = {0};
+    job.graph = graph;
+    job.queries = queries;
+    job.count = count;
+    job.config = config ? *config : astar_default_config();
+    job.config.trace = NULL;  // One sink cannot serve concurrent queries
+    job.results = results;
+    job.stats = stats;
+    return batch_run(&job, threadCount);
+}
+
+bool astar_find_paths_batch_csr(
+    const GraphCSR* csr,
+    const BatchQuery* queries,
+    int count,
+    const AStarConfig* config,
+    PathResult* results,
+    AStarStats* stats,
+    int threadCount
+) {
+    if (!csr || count < 0) return false;
+    if (count == 0) return true;
+    if (!queries || !results) return false;
+    
+    BatchJob job = {0};
+    job.csr = csr;
+    job.queries = queries;
+    job.count = count;
+    job.config = config ? *config : astar_default_config();
+    job.config.trace = NULL;  // One sink cannot serve concurrent queries
+    job.results = results;
+    job.stats = stats;
+    return batch_run(&job, threadCount);
+}
@@ -0,0 +1,80 @@
+/**
+ * batch.h - Multithreaded batch path queries
+ *
+ * Runs many independent (start, goal) queries on a read-only graph using
+ * all cores. Each worker owns one AStarContext for the whole batch, so no
+ * query allocates search state.
+ *
+ * Scheduling is work stealing over chunks of consecutive queries: the
+ * chunks are dealt out evenly up front, each worker takes chunks from the
+ * front of its own range, and a worker that runs dry steals the back half
+ * of another worker's remaining range. Long queries therefore never leave
+ * the other cores idle.
+ *
+ * With an arena in the config every worker collects its paths in a
+ * private arena, and once all have finished the paths are copied in query
+ * order into a single contiguous run of the caller's arena. A batch is
+ * then released with one path_arena_reset.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "graph.h"
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BATCH_AUTO_THREADS 0     // One worker per CPU
+#define BATCH_MAX_CHUNK 64       // Upper bound on queries per chunk
+
+// One point-to-point query
+typedef struct {
+    int startId;
+    int goalId;
+} BatchQuery;
+
+/**
+ * Run count queries on a graph
+ *
+ * The graph must not be modified during the call.
+ *
+ * @param graph        The graph to search
+ * @param queries      Array of count queries
+ * @param count        Number of queries
+ * @param config       Search configuration for every query (NULL for defaults;
+ *                     its trace is ignored; with an arena the paths go into it)
+ * @param results      Output, count results (path_result_free each one)
+ * @param stats        Output, count stats (can be NULL if not needed)
+ * @param threadCount  Worker count, or BATCH_AUTO_THREADS
+ * @return             false on invalid arguments or if a worker could not
+ *                     allocate its context (results are still valid)
+ */
+bool astar_find_paths_batch(
+    const Graph* graph,
+    const BatchQuery* queries,
+    int count,
+    const AStarConfig* config,
+    PathResult* results,
+    AStarStats* stats,
+    int threadCount
+);
+
+// Same, on a frozen snapshot (see graph_freeze)
+bool astar_find_paths_batch_csr(
+    const GraphCSR* csr,
+    const BatchQuery* queries,
+    int count,
+    const AStarConfig* config,
+    PathResult* results,
+    AStarStats* stats,
+    int threadCount
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BATCH_H
@@ -0,0 +1,567 @@
+/**
+ * ch.c - Contraction Hierarchies implementation
+ */
+
+#include "ch.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+// Edge of the shrinking graph used during contraction
+typedef struct {
+    int node;                // Neighbour (target of an out-arc, source of an in-arc)
+    float weight;
+    int middle;              // Bypassed node, -1 for original edges
+} CHArc;
+
+typedef struct {
+    CHArc* arcs;
+    int count;
+    int capacity;
+} CHArcList;
+
+// Working state of ch_build
+typedef struct {
+    int nodeCount;
+    CHArcList* out;          // Remaining out-arcs per node
+    CHArcList* in;           // Remaining in-arcs per node
+    CHArcList* up;           // Final upward arcs (out-arcs at contraction time)
+    CHArcList* down;         // Final downward arcs (in-arcs at contraction time)
+    int* deletedNeighbors;   // Already-contracted neighbours per node
+    int* edgeDifference;     // Last simulated edge difference per node
+    int* level;              // Hierarchy depth below each node
+    bool* contracted;
+    AStarContext* witness;   // Scratch space for the witness searches
+    unsigned int* targetMark;  // targetMark[w] == targetStamp: w is an out-neighbour of the node being contracted
+    unsigned int targetStamp;
+} CHBuilder;
+
+// Insert an arc, or lower the weight of an existing arc to the same node.
+// Returns false only on allocation failure.
+static bool arc_list_set(CHArcList* list, int node, float weight, int middle) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->arcs[i].node == node) {
+            if (weight < list->arcs[i].weight) {
+                list->arcs[i].weight = weight;
+                list->arcs[i].middle = middle;
+            }
+            return true;
+        }
+    }
+    
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+        CHArc* arcs = (CHArc*)realloc(list->arcs, capacity * sizeof(CHArc));
+        if (!arcs) return false;
+        list->arcs = arcs;
+        list->capacity = capacity;
+    }
+    
+    CHArc* arc = &list->arcs[list->count++];
+    arc->node = node;
+    arc->weight = weight;
+    arc->middle = middle;
+    return true;
+}
+
+static void arc_list_remove(CHArcList* list, int node) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->arcs[i].node == node) {
+            list->arcs[i] = list->arcs[--list->count];
+            return;
+        }
+    }
+}
+
+static void arc_lists_free(CHArcList* lists, int count) {
+    if (!lists) return;
+    for (int i = 0; i < count; i++) {
+        free(lists[i].arcs);
+    }
+    free(lists);
+}
+
+// Bounded Dijkstra from source over the remaining graph, never entering
+// the node being contracted. Stops past maxDist, after settleLimit nodes or
+// once all targetCount marked targets are settled; distances are left in
+// the witness context's forward frontier.
+static void witness_search(CHBuilder* b, int source, int skipNode, float maxDist, int settleLimit,
+                           int targetCount) {
+    AStarContext* ctx = b->witness;
+    AStarFrontier* f = &ctx->forward;
+    astar_context_reset(ctx, b->nodeCount, PQ_INDEXED_HEAP, false);
+    
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    
+    f->gScore[source] = 0.0f;
+    f->mark[source] = reached;
+    pq_push(&f->openSet, source, 0.0f);
+    
+    int settledCount = 0;
+    while (!pq_empty(&f->openSet) && settledCount < settleLimit) {
+        int u;
+        float g;
+        pq_pop(&f->openSet, &u, &g);
+        if (g > maxDist) break;
+        f->mark[u] = settled;
+        settledCount++;
+        if (b->targetMark[u] == b->targetStamp && --targetCount == 0) break;
+    
+        const CHArcList* arcs = &b->out[u];
+        for (int i = 0; i < arcs->count; i++) {
+            int v = arcs->arcs[i].node;
+            if (v == skipNode || f->mark[v] == settled) continue;
+    
+            float tentative = g + arcs->arcs[i].weight;
+            if (f->mark[v] != reached || tentative < f->gScore[v]) {
+                f->gScore[v] = tentative;
+                f->mark[v] = reached;
+                pq_update(&f->openSet, v, tentative);
+            }
+        }
+    }
+}
+
+// Whether the witness search found a path from its source to 'to' that is
+// no longer than viaCost
+static bool witness_found(const CHBuilder* b, int to, float viaCost) {
+    const AStarContext* ctx = b->witness;
+    return ctx->forward.mark[to] >= ASTAR_MARK_REACHED(ctx) &&
+           ctx->forward.gScore[to] <= viaCost;
+}
+
+// Contract v (or, with simulate set, only count the shortcuts it would need).
+// Simulations run cheaper witness searches: an overestimate only delays v.
+static int contract_node(CHBuilder* b, int v, bool simulate, bool* ok) {
+    const CHArcList* in = &b->in[v];
+    const CHArcList* out = &b->out[v];
+    int shortcuts = 0;
+    
+    float maxOut = 0.0f;
+    b->targetStamp++;
+    for (int j = 0; j < out->count; j++) {
+        if (out->arcs[j].weight > maxOut) maxOut = out->arcs[j].weight;
+        b->targetMark[out->arcs[j].node] = b->targetStamp;
+    }
+    
+    for (int i = 0; i < in->count; i++) {
+        int u = in->arcs[i].node;
+        float inWeight = in->arcs[i].weight;
+        witness_search(b, u, v, inWeight + maxOut,
+                       simulate ? CH_WITNESS_SIMULATE_LIMIT : CH_WITNESS_SETTLE_LIMIT, out->count);
+    
+        for (int j = 0; j < out->count; j++) {
+            int w = out->arcs[j].node;
+            if (w == u) continue;
+    
+            float viaCost = inWeight + out->arcs[j].weight;
+            if (witness_found(b, w, viaCost)) continue;
+    
+            shortcuts++;
+            if (!simulate) {
+                if (!arc_list_set(&b->out[u], w, viaCost, v) ||
+                    !arc_list_set(&b->in[w], u, viaCost, v)) {
+                    *ok = false;
+                }
+            }
+        }
+    }
+    return shortcuts;
+}
+
+// Contraction priority: edge difference, contracted neighbours and depth.
+// The last two spread contraction evenly over the graph, which keeps the
+// upper levels sparse.
+static float priority_of(const CHBuilder* b, int v) {
+    return (float)(2 * b->edgeDifference[v] + b->deletedNeighbors[v] + b->level[v]);
+}
+
+// Priority with a fresh edge difference (runs the simulated contraction)
+static float node_priority(CHBuilder* b, int v) {
+    bool ok = true;
+    int shortcuts = contract_node(b, v, true, &ok);
+    b->edgeDifference[v] = shortcuts - b->in[v].count - b->out[v].count;
+    return priority_of(b, v);
+}
+
+// Flatten per-node arc lists into CSR arrays
+static bool flatten_arcs(const CHArcList* lists, int nodeCount,
+                         int** offsets, int** nodes, float** weights, int** middles) {
+    int total = 0;
+    for (int i = 0; i < nodeCount; i++) total += lists[i].count;
+    
+    *offsets = (int*)malloc((nodeCount + 1) * sizeof(int));
+    *nodes = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    *weights = (float*)malloc((total > 0 ? total : 1) * sizeof(float));
+    *middles = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    if (!*offsets || !*nodes || !*weights || !*middles) return false;
+    
+    int e = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        (*offsets)[i] = e;
+        for (int j = 0; j < lists[i].count; j++) {
+            (*nodes)[e] = lists[i].arcs[j].node;
+            (*weights)[e] = lists[i].arcs[j].weight;
+            (*middles)[e] = lists[i].arcs[j].middle;
+            e++;
+        }
+    }
+    (*offsets)[nodeCount] = e;
+    return true;
+}
+
+bool ch_build(const GraphCSR* csr, ContractionHierarchy* ch) {
+    if (!csr || !ch) return false;
+    memset(ch, 0, sizeof(*ch));
+    
+    int n = csr->nodeCount;
+    CHBuilder b = {0};
+    b.nodeCount = n;
+    b.out = (CHArcList*)calloc(n > 0 ? n : 1, sizeof(CHArcList));
+    b.in = (CHArcList*)calloc(n > 0 ? n : 1, sizeof(CHArcList));
+    b.up = (CHArcList*)calloc(n > 0 ? n : 1, sizeof(CHArcList));
+    b.down = (CHArcList*)calloc(n > 0 ? n : 1, sizeof(CHArcList));
+    b.deletedNeighbors = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    b.edgeDifference = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    b.level = (int*)calloc(n > 0 ? n : 1, sizeof(int));
+    b.contracted = (bool*)calloc(n > 0 ? n : 1, sizeof(bool));
+    b.witness = astar_context_create(n);
+    b.targetMark = (unsigned int*)calloc(n > 0 ? n : 1, sizeof(unsigned int));
+    ch->rank = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    
+    PriorityQueue order;
+    bool ok = pq_init(&order, PQ_INDEXED_HEAP, n) &&
+              b.out && b.in && b.up && b.down && b.deletedNeighbors && b.edgeDifference && b.level &&
+              b.contracted && b.witness && b.targetMark && ch->rank;
+    
+    // Copy the graph, dropping self-loops and keeping the cheapest parallel edge
+    for (int u = 0; u < n && ok; u++) {
+        for (int e = csr->offsets[u]; e < csr->offsets[u + 1] && ok; e++) {
+            int v = csr->to[e];
+            if (v == u) continue;
+            ok = arc_list_set(&b.out[u], v, csr->weight[e], -1) &&
+                 arc_list_set(&b.in[v], u, csr->weight[e], -1);
+        }
+    }
+    
+    for (int v = 0; v < n && ok; v++) {
+        ok = pq_push(&order, v, node_priority(&b, v));
+    }
+    
+    // Contract in priority order, re-evaluating lazily on pop
+    int nextRank = 0;
+    while (ok && !pq_empty(&order)) {
+        int v;
+        float key;
+        pq_pop(&order, &v, &key);
+    
+        float priority = node_priority(&b, v);
+        int topId;
+        float topKey;
+        if (pq_peek(&order, &topId, &topKey) && priority > topKey) {
+            ok = pq_push(&order, v, priority);
+            continue;
+        }
+    
+        contract_node(&b, v, false, &ok);
+    
+        // The remaining neighbours all outrank v: keep v's arcs as its
+        // upward/downward edges and detach v from the shrinking graph
+        b.up[v] = b.out[v];
+        b.down[v] = b.in[v];
+        memset(&b.out[v], 0, sizeof(CHArcList));
+        memset(&b.in[v], 0, sizeof(CHArcList));
+        b.contracted[v] = true;
+        ch->rank[v] = nextRank++;
+    
+        for (int i = 0; i < b.up[v].count; i++) {
+            int w = b.up[v].arcs[i].node;
+            arc_list_remove(&b.in[w], v);
+            b.deletedNeighbors[w]++;
+            if (b.level[w] < b.level[v] + 1) b.level[w] = b.level[v] + 1;
+        }
+        for (int i = 0; i < b.down[v].count; i++) {
+            int u = b.down[v].arcs[i].node;
+            arc_list_remove(&b.out[u], v);
+            b.deletedNeighbors[u]++;
+            if (b.level[u] < b.level[v] + 1) b.level[u] = b.level[v] + 1;
+        }
+    
+        // Neighbour priorities changed. Only the cheap terms are refreshed
+        // here; the edge difference is simulated again when a neighbour
+        // reaches the top of the queue.
+        for (int i = 0; i < b.up[v].count && ok; i++) {
+            int w = b.up[v].arcs[i].node;
+            pq_set_key(&order, w, priority_of(&b, w));
+        }
+        for (int i = 0; i < b.down[v].count && ok; i++) {
+            int u = b.down[v].arcs[i].node;
+            pq_set_key(&order, u, priority_of(&b, u));
+        }
+    }
+    
+    if (ok) {
+        ok = flatten_arcs(b.up, n, &ch->upOffsets, &ch->upTo, &ch->upWeight, &ch->upMiddle) &&
+             flatten_arcs(b.down, n, &ch->downOffsets, &ch->downFrom, &ch->downWeight, &ch->downMiddle);
+    }
+    
+    if (ok) {
+        ch->nodeCount = n;
+        ch->edgeCount = ch->upOffsets[n] + ch->downOffsets[n];
+        for (int e = 0; e < ch->upOffsets[n]; e++) {
+            if (ch->upMiddle[e] >= 0) ch->shortcutCount++;
+        }
+        for (int e = 0; e < ch->downOffsets[n]; e++) {
+            if (ch->downMiddle[e] >= 0) ch->shortcutCount++;
+        }
+    }
+    
+    pq_free(&order);
+    astar_context_free(b.witness);
+    arc_lists_free(b.out, n);
+    arc_lists_free(b.in, n);
+    arc_lists_free(b.up, n);
+    arc_lists_free(b.down, n);
+    free(b.deletedNeighbors);
+    free(b.edgeDifference);
+    free(b.level);
+    free(b.contracted);
+    free(b.targetMark);
+    
+    if (!ok) ch_free(ch);
+    return ok;
+}
+
+void ch_free(ContractionHierarchy* ch) {
+    if (!ch) return;
+    free(ch->rank);
+    free(ch->upOffsets);
+    free(ch->upTo);
+    free(ch->upWeight);
+    free(ch->upMiddle);
+    free(ch->downOffsets);
+    free(ch->downFrom);
+    free(ch->downWeight);
+    free(ch->downMiddle);
+    memset(ch, 0, sizeof(*ch));
+}
+
+// Find the hierarchy edge a -> b and return its bypassed node (or -1).
+// The edge is stored at its lower-ranked endpoint.
+static int ch_edge_middle(const ContractionHierarchy* ch, int a, int b) {
+    if (ch->rank[a] < ch->rank[b]) {
+        for (int e = ch->upOffsets[a]; e < ch->upOffsets[a + 1]; e++) {
+            if (ch->upTo[e] == b) return ch->upMiddle[e];
+        }
+    } else {
+        for (int e = ch->downOffsets[b]; e < ch->downOffsets[b + 1]; e++) {
+            if (ch->downFrom[e] == a) return ch->downMiddle[e];
+        }
+    }
+    return -1;
+}
+
+// Growable node list used while unpacking
+typedef struct {
+    int* nodes;
+    int length;
+    int capacity;
+} NodeList;
+
+static bool node_list_push(NodeList* list, int node) {
+    if (list->length >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        int* nodes = (int*)realloc(list->nodes, capacity * sizeof(int));
+        if (!nodes) return false;
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+    list->nodes[list->length++] = node;
+    return true;
+}
+
+// Append the original-edge expansion of a -> b, excluding a itself.
+// Uses an explicit stack of pending targets instead of recursion.
+static bool ch_unpack_edge(const ContractionHierarchy* ch, int a, int b, NodeList* out, NodeList* stack) {
+    stack->length = 0;
+    if (!node_list_push(stack, b)) return false;
+    
+    int from = a;
+    while (stack->length > 0) {
+        int to = stack->nodes[stack->length - 1];
+        int middle = ch_edge_middle(ch, from, to);
+        if (middle < 0) {
+            if (!node_list_push(out, to)) return false;
+            from = to;
+            stack->length--;
+        } else {
+            if (!node_list_push(stack, middle)) return false;
+        }
+    }
+    return true;
+}
+
+PathResult ch_find_path(const ContractionHierarchy* ch, int startId, int goalId, AStarStats* stats) {
+    if (!ch) return path_result_create();
+    
+    AStarContext* ctx = astar_context_create(ch->nodeCount);
+    if (!ctx) return path_result_create();
+    
+    PathResult result = ch_find_path_ctx(ctx, ch, startId, goalId, stats);
+    astar_context_free(ctx);
+    return result;
+}
+
+PathResult ch_find_path_ctx(
+    AStarContext* ctx,
+    const ContractionHierarchy* ch,
+    int startId,
+    int goalId,
+    AStarStats* stats
+) {
+    PathResult result = path_result_create();
+    
+    if (!ctx || !ch || startId < 0 || goalId < 0 ||
+        startId >= ch->nodeCount || goalId >= ch->nodeCount) {
+        return result;
+    }
+    
+    AStarStats localStats = {0};
+    double startTime = astar_time_ms();
+    
+    if (!astar_context_reset(ctx, ch->nodeCount, PQ_INDEXED_HEAP, true)) return result;
+    
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    AStarFrontier* sides[2] = { &ctx->forward, &ctx->backward };
+    int seeds[2] = { startId, goalId };
+    
+    for (int d = 0; d < 2; d++) {
+        sides[d]->gScore[seeds[d]] = 0.0f;
+        sides[d]->cameFrom[seeds[d]] = -1;
+        sides[d]->mark[seeds[d]] = reached;
+        pq_push(&sides[d]->openSet, seeds[d], 0.0f);
+    }
+    
+    float bestCost = FLT_MAX;
+    int meetingNode = -1;
+    int d = 1;
+    
+    while (true) {
+        // A side is finished once its smallest key cannot improve the best path
+        bool active[2];
+        for (int k = 0; k < 2; k++) {
+            int topId;
+            float topKey;
+            active[k] = pq_peek(&sides[k]->openSet, &topId, &topKey) && topKey < bestCost;
+        }
+        if (!active[0] && !active[1]) break;
+    
+        // Alternate between the directions that still have work
+        d = 1 - d;
+        if (!active[d]) d = 1 - d;
+    
+        AStarFrontier* side = sides[d];
+        AStarFrontier* other = sides[1 - d];
+    
+        int u;
+        float g;
+        pq_pop(&side->openSet, &u, &g);
+        side->mark[u] = settled;
+    
+        localStats.nodesExplored++;
+        if (d == 0) localStats.nodesExploredForward++;
+        else localStats.nodesExploredBackward++;
+    
+        if (other->mark[u] >= reached && g + other->gScore[u] < bestCost) {
+            bestCost = g + other->gScore[u];
+            meetingNode = u;
+        }
+    
+        // Forward climbs upward edges; backward climbs downward edges reversed.
+        const int* offsets = d == 0 ? ch->upOffsets : ch->downOffsets;
+        const int* targets = d == 0 ? ch->upTo : ch->downFrom;
+        const float* weights = d == 0 ? ch->upWeight : ch->downWeight;
+    
+        // Stall-on-demand: if a higher node already reached by this side
+        // reaches u more cheaply through an edge of the opposite direction,
+        // g(u) is not a shortest distance and u need not be expanded.
+        const int* stallOffsets = d == 0 ? ch->downOffsets : ch->upOffsets;
+        const int* stallTargets = d == 0 ? ch->downFrom : ch->upTo;
+        const float* stallWeights = d == 0 ? ch->downWeight : ch->upWeight;
+        bool stalled = false;
+        for (int e = stallOffsets[u]; e < stallOffsets[u + 1]; e++) {
+            int w = stallTargets[e];
+            if (side->mark[w] >= reached && side->gScore[w] + stallWeights[e] < g) {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled) continue;
+    
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+            int v = targets[e];
+            if (side->mark[v] == settled) continue;
+    
+            float tentative = g + weights[e];
+            if (side->mark[v] != reached || tentative < side->gScore[v]) {
+                side->gScore[v] = tentative;
+                side->cameFrom[v] = u;
+                side->mark[v] = reached;
+                pq_update(&side->openSet, v, tentative);
+            }
+        }
+    
+        int openSize = ctx->forward.openSet.size + ctx->backward.openSet.size;
+        if (openSize > localStats.maxOpenSetSize) {
+            localStats.maxOpenSetSize = openSize;
+        }
+    }
+    
+    localStats.nodesInOpenSet = ctx->forward.openSet.size + ctx->backward.openSet.size;
+    
+    if (meetingNode >= 0) {
+        // Hierarchy path: start -> ... -> meeting node -> ... -> goal
+        NodeList hierarchy = {0};
+        NodeList path = {0};
+        NodeList stack = {0};
+        bool ok = true;
+    
+        for (int v = meetingNode; v != -1 && ok; v = ctx->forward.cameFrom[v]) {
+            ok = node_list_push(&hierarchy, v);
+        }
+        for (int i = 0, j = hierarchy.length - 1; i < j; i++, j--) {
+            int tmp = hierarchy.nodes[i];
+            hierarchy.nodes[i] = hierarchy.nodes[j];
+            hierarchy.nodes[j] = tmp;
+        }
+        for (int v = ctx->backward.cameFrom[meetingNode]; v != -1 && ok; v = ctx->backward.cameFrom[v]) {
+            ok = node_list_push(&hierarchy, v);
+        }
+    
+        // Expand every shortcut into original edges
+        ok = ok && node_list_push(&path, startId);
+        for (int i = 0; i + 1 < hierarchy.length && ok; i++) {
+            ok = ch_unpack_edge(ch, hierarchy.nodes[i], hierarchy.nodes[i + 1], &path, &stack);
+        }
+    
+        if (ok) {
+            result.nodes = path.nodes;
+            result.length = path.length;
+            result.totalCost = bestCost;
+            result.found = true;
+        } else {
+            free(path.nodes);
+        }
+        free(hierarchy.nodes);
+        free(stack.nodes);
+    }
+    
+    localStats.searchTimeMs = (float)(astar_time_ms() - startTime);
+    ASTAR_COUNT(metrics_record_global(METRICS_ENGINE_CH, &localStats, result.found));
+    if (stats) *stats = localStats;
+    
+    return result;
+}
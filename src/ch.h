@@ -0,0 +1,96 @@
+/**
+ * ch.h - Contraction Hierarchies
+ *
+ * Offline preprocessing plus a fast point-to-point query engine for
+ * read-only road graphs. Preprocessing contracts nodes one at a time in
+ * order of importance (edge difference + contracted neighbours). For each
+ * pair of neighbours whose shortest connection ran through the contracted
+ * node, it inserts a shortcut edge; a bounded local "witness" Dijkstra
+ * decides whether a shortcut is needed. Priorities are updated lazily: a
+ * contraction only refreshes the cheap terms of its neighbours, and the
+ * edge difference is simulated again when a node reaches the top.
+ *
+ * Every edge ends up stored at its lower-ranked endpoint:
+ * - Upward graph:   u -> v with rank(v) > rank(u)
+ * - Downward graph: u -> v with rank(u) > rank(v), stored reversed at v
+ *
+ * A query runs a bidirectional Dijkstra that only climbs: forward over the
+ * upward graph from the start, backward over the downward graph from the
+ * goal. Both searches stay tiny because they only ever visit more important
+ * nodes. Shortcuts remember the node they bypass and are unpacked into
+ * original edges when the path is built.
+ */
+
+#ifndef CH_H
+#define CH_H
+
+#include "graph.h"
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tuning for the witness searches run during preprocessing
+#define CH_WITNESS_SETTLE_LIMIT 500       // When inserting shortcuts
+#define CH_WITNESS_SIMULATE_LIMIT 20      // When estimating priorities
+
+// Preprocessed hierarchy (immutable after ch_build)
+typedef struct {
+    int nodeCount;
+    int* rank;               // Contraction position of each node (higher = more important)
+    
+    // Upward edges of node u are [upOffsets[u], upOffsets[u + 1])
+    int* upOffsets;
+    int* upTo;
+    float* upWeight;
+    int* upMiddle;           // Bypassed node for shortcuts, -1 for original edges
+    
+    // Downward edges into node v are [downOffsets[v], downOffsets[v + 1])
+    int* downOffsets;
+    int* downFrom;
+    float* downWeight;
+    int* downMiddle;
+    
+    int edgeCount;           // Upward + downward edges
+    int shortcutCount;       // Edges added by contraction
+} ContractionHierarchy;
+
+/**
+ * Preprocess a frozen graph into a contraction hierarchy
+ *
+ * @param csr   Frozen graph (see graph_freeze); node IDs are preserved
+ * @param ch    Output hierarchy (call ch_free when done)
+ * @return      false on allocation failure
+ */
+bool ch_build(const GraphCSR* csr, ContractionHierarchy* ch);
+void ch_free(ContractionHierarchy* ch);
+
+/**
+ * Shortest path query on a hierarchy
+ *
+ * The returned path is fully unpacked into original edges.
+ * nodesExploredForward/Backward report the two upward search spaces.
+ *
+ * @param ch        Preprocessed hierarchy
+ * @param startId   Starting node ID
+ * @param goalId    Goal node ID
+ * @param stats     Output statistics (can be NULL if not needed)
+ * @return          PathResult containing the path (call path_result_free when done)
+ */
+PathResult ch_find_path(const ContractionHierarchy* ch, int startId, int goalId, AStarStats* stats);
+
+// Same as ch_find_path, reusing the frontiers of a search context
+PathResult ch_find_path_ctx(
+    AStarContext* ctx,
+    const ContractionHierarchy* ch,
+    int startId,
+    int goalId,
+    AStarStats* stats
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CH_H
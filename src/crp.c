@@ -0,0 +1,827 @@
+/**
+ * crp.c - Partition, customization and queries of the CRP overlay
+ */
+
+#include "crp.h"
+#include "thread.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <stdatomic.h>
+
+#define CRP_SPLIT_CANDIDATES 5   // Split positions tried per axis, from 30% to 70%
+#define CRP_BASE_CELL_SIZE 64    // Level 0 cell size of crp_default_config
+#define CRP_LEVEL_FANOUT 8       // Growth per level, and fewest cells on the top level
+
+CrpConfig crp_default_config(int nodeCount) {
+    CrpConfig config;
+    memset(&config, 0, sizeof(config));
+    int size = CRP_BASE_CELL_SIZE;
+    while (config.levelCount < CRP_MAX_LEVELS &&
+           (config.levelCount == 0 || size <= nodeCount / CRP_LEVEL_FANOUT)) {
+        config.cellSizes[config.levelCount++] = size;
+        size *= CRP_LEVEL_FANOUT;
+    }
+    return config;
+}
+
+// ============================================================================
+// Partition
+// ============================================================================
+
+typedef struct {
+    float key;
+    int node;
+} CrpSortItem;
+
+static int crp_compare_items(const void* a, const void* b) {
+    const CrpSortItem* x = (const CrpSortItem*)a;
+    const CrpSortItem* y = (const CrpSortItem*)b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->node > y->node) - (x->node < y->node);
+}
+
+typedef struct {
+    const Graph* graph;
+    CrpOverlay* overlay;
+    const int* cellSizes;
+    int* nodes;              // Active nodes; every range being split is contiguous
+    CrpSortItem* items;      // Sort scratch, parallel to nodes
+    int* position;           // Index in nodes of the nodes of the current range
+    unsigned int* stamp;     // stamp[v] == currentStamp while v is in that range
+    unsigned int currentStamp;
+} CrpPartitioner;
+
+static void crp_sort_axis(CrpPartitioner* p, int begin, int end, int axis) {
+    const float* coords = axis == 0 ? p->graph->nodeX : p->graph->nodeY;
+    for (int i = begin; i < end; i++) {
+        p->items[i].key = coords[p->nodes[i]];
+        p->items[i].node = p->nodes[i];
+    }
+    qsort(p->items + begin, (size_t)(end - begin), sizeof(CrpSortItem), crp_compare_items);
+    for (int i = begin; i < end; i++) {
+        p->nodes[i] = p->items[i].node;
+        p->position[p->nodes[i]] = i;
+    }
+}
+
+// Edges inside the range cut by each candidate split (a split s puts
+// positions below s on the left)
+static void crp_count_cuts(const CrpPartitioner* p, int begin, int end, const int* splits, int* cuts) {
+    const Graph* graph = p->graph;
+    memset(cuts, 0, CRP_SPLIT_CANDIDATES * sizeof(int));
+    for (int i = begin; i < end; i++) {
+        int u = p->nodes[i];
+        for (int k = 0; k < graph->edgeCounts[u]; k++) {
+            const Edge* edge = &graph->edges[u][k];
+            if (!edge->active || p->stamp[edge->to] != p->currentStamp) continue;
+            int lo = i;
+            int hi = p->position[edge->to];
+            if (lo > hi) {
+                lo = hi;
+                hi = i;
+            }
+            for (int c = 0; c < CRP_SPLIT_CANDIDATES; c++) {
+                if (lo < splits[c] && splits[c] <= hi) cuts[c]++;
+            }
+        }
+    }
+}
+
+// Reorder the range along the better axis and return where to cut it
+static int crp_split(CrpPartitioner* p, int begin, int end) {
+    int size = end - begin;
+    p->currentStamp++;
+    for (int i = begin; i < end; i++) p->stamp[p->nodes[i]] = p->currentStamp;
+    
+    int splits[CRP_SPLIT_CANDIDATES];
+    for (int c = 0; c < CRP_SPLIT_CANDIDATES; c++) {
+        int split = begin + (int)((long long)size * (3 + c) / 10);
+        if (split <= begin) split = begin + 1;
+        if (split >= end) split = end - 1;
+        splits[c] = split;
+    }
+    
+    // Fewest cut edges wins; ties go to the more balanced split
+    int bestAxis = 0;
+    int bestSplit = splits[CRP_SPLIT_CANDIDATES / 2];
+    int bestCuts = INT_MAX;
+    int bestImbalance = INT_MAX;
+    for (int axis = 0; axis < 2; axis++) {
+        int cuts[CRP_SPLIT_CANDIDATES];
+        crp_sort_axis(p, begin, end, axis);
+        crp_count_cuts(p, begin, end, splits, cuts);
+        for (int c = 0; c < CRP_SPLIT_CANDIDATES; c++) {
+            int imbalance = abs(c - CRP_SPLIT_CANDIDATES / 2);
+            if (cuts[c] < bestCuts || (cuts[c] == bestCuts && imbalance < bestImbalance)) {
+                bestAxis = axis;
+                bestSplit = splits[c];
+                bestCuts = cuts[c];
+                bestImbalance = imbalance;
+            }
+        }
+    }
+    if (bestAxis != 1) crp_sort_axis(p, begin, end, bestAxis);
+    return bestSplit;
+}
+
+// A range becomes a cell on every level whose size it is the first to fit
+static void crp_bisect(CrpPartitioner* p, int begin, int end, int parentSize) {
+    int size = end - begin;
+    for (int i = 0; i < p->overlay->levelCount; i++) {
+        if (size <= p->cellSizes[i] && parentSize > p->cellSizes[i]) {
+            CrpLevel* level = &p->overlay->levels[i];
+            int cell = level->cellCount++;
+            for (int k = begin; k < end; k++) level->cell[p->nodes[k]] = cell;
+        }
+    }
+    if (size <= p->cellSizes[0]) return;
+    
+    int split = crp_split(p, begin, end);
+    crp_bisect(p, begin, split, size);
+    crp_bisect(p, split, end, size);
+}
+
+// Boundary nodes (endpoints of edges between cells) and clique storage of one level
+static bool crp_build_boundaries(CrpLevel* level, const Graph* graph) {
+    int nodeCount = graph->nodeCount;
+    level->boundaryIndex = (int*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(int));
+    level->boundaryOffsets = (int*)calloc(level->cellCount + 1, sizeof(int));
+    level->matrixOffsets = (size_t*)calloc(level->cellCount + 1, sizeof(size_t));
+    if (!level->boundaryIndex || !level->boundaryOffsets || !level->matrixOffsets) return false;
+    
+    for (int v = 0; v < nodeCount; v++) level->boundaryIndex[v] = -1;
+    for (int u = 0; u < nodeCount; u++) {
+        if (level->cell[u] < 0) continue;
+        for (int k = 0; k < graph->edgeCounts[u]; k++) {
+            const Edge* edge = &graph->edges[u][k];
+            int v = edge->to;
+            if (!edge->active || level->cell[v] < 0 || level->cell[v] == level->cell[u]) continue;
+            level->boundaryIndex[u] = 0;
+            level->boundaryIndex[v] = 0;
+        }
+    }
+    
+    for (int v = 0; v < nodeCount; v++) {
+        if (level->boundaryIndex[v] == 0) level->boundaryOffsets[level->cell[v] + 1]++;
+    }
+    for (int c = 0; c < level->cellCount; c++) {
+        level->boundaryOffsets[c + 1] += level->boundaryOffsets[c];
+    }
+    int total = level->boundaryOffsets[level->cellCount];
+    level->boundary = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    if (!level->boundary) return false;
+    
+    // Filled in node order, so each cell's list is sorted
+    int* fill = (int*)malloc((level->cellCount > 0 ? level->cellCount : 1) * sizeof(int));
+    if (!fill) return false;
+    memcpy(fill, level->boundaryOffsets, level->cellCount * sizeof(int));
+    for (int v = 0; v < nodeCount; v++) {
+        if (level->boundaryIndex[v] != 0) continue;
+        int cell = level->cell[v];
+        level->boundaryIndex[v] = fill[cell] - level->boundaryOffsets[cell];
+        level->boundary[fill[cell]++] = v;
+    }
+    free(fill);
+    
+    for (int c = 0; c < level->cellCount; c++) {
+        size_t count = (size_t)(level->boundaryOffsets[c + 1] - level->boundaryOffsets[c]);
+        level->matrixOffsets[c + 1] = level->matrixOffsets[c] + count * count;
+    }
+    size_t cells = level->matrixOffsets[level->cellCount];
+    level->matrix = (float*)malloc((cells > 0 ? cells : 1) * sizeof(float));
+    level->matrixIn = (float*)malloc((cells > 0 ? cells : 1) * sizeof(float));
+    if (!level->matrix || !level->matrixIn) return false;
+    for (size_t i = 0; i < cells; i++) level->matrix[i] = INFINITY;
+    for (size_t i = 0; i < cells; i++) level->matrixIn[i] = INFINITY;
+    return true;
+}
+
+// Search space of every cell of one level and room for its parent tables
+static bool crp_build_members(CrpLevel* level, const CrpLevel* lower, int nodeCount) {
+    level->localIndex = (int*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(int));
+    level->memberOffsets = (int*)calloc(level->cellCount + 1, sizeof(int));
+    level->parentOffsets = (size_t*)calloc(level->cellCount + 1, sizeof(size_t));
+    if (!level->localIndex || !level->memberOffsets || !level->parentOffsets) return false;
+    
+    for (int v = 0; v < nodeCount; v++) {
+        bool member = level->cell[v] >= 0 && (!lower || lower->boundaryIndex[v] >= 0);
+        level->localIndex[v] = member ? 0 : -1;
+        if (member) level->memberOffsets[level->cell[v] + 1]++;
+    }
+    for (int c = 0; c < level->cellCount; c++) {
+        level->memberOffsets[c + 1] += level->memberOffsets[c];
+    }
+    int total = level->memberOffsets[level->cellCount];
+    level->members = (int*)malloc((total > 0 ? total : 1) * sizeof(int));
+    int* fill = (int*)malloc((level->cellCount > 0 ? level->cellCount : 1) * sizeof(int));
+    if (!level->members || !fill) {
+        free(fill);
+        return false;
+    }
+    memcpy(fill, level->memberOffsets, level->cellCount * sizeof(int));
+    for (int v = 0; v < nodeCount; v++) {
+        if (level->localIndex[v] < 0) continue;
+        int cell = level->cell[v];
+        level->localIndex[v] = fill[cell] - level->memberOffsets[cell];
+        level->members[fill[cell]++] = v;
+    }
+    free(fill);
+    
+    for (int c = 0; c < level->cellCount; c++) {
+        size_t boundary = (size_t)(level->boundaryOffsets[c + 1] - level->boundaryOffsets[c]);
+        size_t members = (size_t)(level->memberOffsets[c + 1] - level->memberOffsets[c]);
+        level->parentOffsets[c + 1] = level->parentOffsets[c] + boundary * members;
+    }
+    size_t entries = level->parentOffsets[level->cellCount];
+    level->parents = (int*)malloc((entries > 0 ? entries : 1) * sizeof(int));
+    return level->parents != NULL;
+}
+
+bool crp_build(const Graph* graph, const CrpConfig* config, CrpOverlay* overlay) {
+    if (!overlay) return false;
+    memset(overlay, 0, sizeof(*overlay));
+    if (!graph) return false;
+    
+    CrpConfig cfg = config ? *config : crp_default_config(graph->nodeCount - graph->deadNodes);
+    int nodeCount = graph->nodeCount;
+    overlay->nodeCount = nodeCount;
+    overlay->structureVersion = graph->structureVersion;
+    
+    CrpPartitioner p;
+    memset(&p, 0, sizeof(p));
+    p.graph = graph;
+    p.overlay = overlay;
+    p.cellSizes = cfg.cellSizes;
+    
+    size_t slots = nodeCount > 0 ? (size_t)nodeCount : 1;
+    p.nodes = (int*)malloc(slots * sizeof(int));
+    p.items = (CrpSortItem*)malloc(slots * sizeof(CrpSortItem));
+    p.position = (int*)malloc(slots * sizeof(int));
+    p.stamp = (unsigned int*)calloc(slots, sizeof(unsigned int));
+    bool ok = p.nodes && p.items && p.position && p.stamp;
+    
+    int active = 0;
+    for (int v = 0; ok && v < nodeCount; v++) {
+        if (GRAPH_NODE_ACTIVE(graph, v)) p.nodes[active++] = v;
+    }
+    
+    // Keep the levels that actually split the graph, in increasing size
+    int levelCount = cfg.levelCount < CRP_MAX_LEVELS ? cfg.levelCount : CRP_MAX_LEVELS;
+    int previous = 0;
+    for (int i = 0; ok && i < levelCount; i++) {
+        if (cfg.cellSizes[i] <= previous || cfg.cellSizes[i] >= active) break;
+        previous = cfg.cellSizes[i];
+    
+        CrpLevel* level = &overlay->levels[i];
+        level->cell = (int*)malloc(slots * sizeof(int));
+        if (!level->cell) {
+            ok = false;
+            break;
+        }
+        for (int v = 0; v < nodeCount; v++) level->cell[v] = -1;
+        overlay->levelCount = i + 1;
+    }
+    
+    if (ok && overlay->levelCount > 0) crp_bisect(&p, 0, active, INT_MAX);
+    for (int i = 0; ok && i < overlay->levelCount; i++) {
+        ok = crp_build_boundaries(&overlay->levels[i], graph) &&
+             crp_build_members(&overlay->levels[i], i > 0 ? &overlay->levels[i - 1] : NULL, nodeCount);
+    }
+    
+    free(p.nodes);
+    free(p.items);
+    free(p.position);
+    free(p.stamp);
+    if (!ok) crp_free(overlay);
+    return ok;
+}
+
+void crp_free(CrpOverlay* overlay) {
+    if (!overlay) return;
+    for (int i = 0; i < CRP_MAX_LEVELS; i++) {
+        CrpLevel* level = &overlay->levels[i];
+        free(level->cell);
+        free(level->boundaryIndex);
+        free(level->boundaryOffsets);
+        free(level->boundary);
+        free(level->matrixOffsets);
+        free(level->matrix);
+        free(level->matrixIn);
+        free(level->memberOffsets);
+        free(level->members);
+        free(level->localIndex);
+        free(level->parentOffsets);
+        free(level->parents);
+    }
+    memset(overlay, 0, sizeof(*overlay));
+}
+
+// ============================================================================
+// Searches inside a cell
+// ============================================================================
+
+static bool crp_is_clique_hop(const CrpLevel* level, int a, int b) {
+    return level->cell[a] == level->cell[b] && level->boundaryIndex[a] >= 0 && level->boundaryIndex[b] >= 0;
+}
+
+static void crp_relax(AStarFrontier* frontier, unsigned int reached, unsigned int settled,
+                      int v, float g, float key, int from) {
+    unsigned int mark = frontier->mark[v];
+    if (mark == settled || (mark == reached && g >= frontier->gScore[v])) return;
+    frontier->gScore[v] = g;
+    frontier->cameFrom[v] = from;
+    frontier->mark[v] = reached;
+    pq_update(&frontier->openSet, v, key);
+}
+
+// Dijkstra from source that never leaves `cell` of level li. Level 0
+// follows the cell's edges; higher levels follow the cliques of the
+// level li - 1 subcells and the edges between subcells. Stops once every
+// boundary node of the cell is settled, leaving the distances and parents
+// in ctx->forward.
+static bool crp_cell_search(AStarContext* ctx, const CrpOverlay* overlay, const Graph* graph,
+                            int li, int cell, int source) {
+    if (!astar_context_reset(ctx, overlay->nodeCount, PQ_INDEXED_HEAP, false)) return false;
+    
+    const CrpLevel* level = &overlay->levels[li];
+    const CrpLevel* lower = li > 0 ? &overlay->levels[li - 1] : NULL;
+    AStarFrontier* frontier = &ctx->forward;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    int remaining = level->boundaryOffsets[cell + 1] - level->boundaryOffsets[cell];
+    
+    frontier->gScore[source] = 0.0f;
+    frontier->cameFrom[source] = -1;
+    frontier->mark[source] = reached;
+    pq_push(&frontier->openSet, source, 0.0f);
+    
+    while (!pq_empty(&frontier->openSet)) {
+        int u;
+        float g;
+        pq_pop(&frontier->openSet, &u, &g);
+        frontier->mark[u] = settled;
+        if (level->boundaryIndex[u] >= 0 && --remaining == 0) break;
+    
+        // Boundary nodes of a subcell jump across it; anything else walks
+        int sub = -1;
+        if (lower && lower->boundaryIndex[u] >= 0) {
+            sub = lower->cell[u];
+            int first = lower->boundaryOffsets[sub];
+            int count = lower->boundaryOffsets[sub + 1] - first;
+            const float* row = lower->matrix + lower->matrixOffsets[sub] + (size_t)lower->boundaryIndex[u] * count;
+            for (int j = 0; j < count; j++) {
+                if (row[j] >= FLT_MAX) continue;
+                crp_relax(frontier, reached, settled, lower->boundary[first + j], g + row[j], g + row[j], u);
+            }
+        }
+        for (int k = 0; k < graph->edgeCounts[u]; k++) {
+            const Edge* edge = &graph->edges[u][k];
+            int v = edge->to;
+            if (!edge->active || level->cell[v] != cell) continue;
+            if (sub >= 0 && lower->cell[v] == sub) continue;
+            crp_relax(frontier, reached, settled, v, g + edge->weight, g + edge->weight, u);
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// Customization
+// ============================================================================
+
+typedef struct {
+    CrpOverlay* overlay;
+    const Graph* graph;
+    int level;
+    atomic_int nextCell;     // Cells are claimed one at a time
+    atomic_bool failed;
+} CrpJob;
+
+typedef struct {
+    CrpJob* job;
+    Thread thread;
+} CrpWorker;
+
+static void crp_customize_cell(CrpJob* job, AStarContext* ctx, int cell) {
+    CrpLevel* level = &job->overlay->levels[job->level];
+    int first = level->boundaryOffsets[cell];
+    int count = level->boundaryOffsets[cell + 1] - first;
+    float* clique = level->matrix + level->matrixOffsets[cell];
+    float* cliqueIn = level->matrixIn + level->matrixOffsets[cell];
+    const int* members = level->members + level->memberOffsets[cell];
+    int memberCount = level->memberOffsets[cell + 1] - level->memberOffsets[cell];
+    
+    for (int i = 0; i < count; i++) {
+        if (!crp_cell_search(ctx, job->overlay, job->graph, job->level, cell, level->boundary[first + i])) {
+            atomic_store(&job->failed, true);
+            return;
+        }
+        const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+        for (int j = 0; j < count; j++) {
+            int v = level->boundary[first + j];
+            float distance = ctx->forward.mark[v] == settled ? ctx->forward.gScore[v] : INFINITY;
+            clique[(size_t)i * count + j] = distance;
+            cliqueIn[(size_t)j * count + i] = distance;
+        }
+    
+        // Parents of settled members; a settled node's parent settled before it
+        int* parent = level->parents + level->parentOffsets[cell] + (size_t)i * memberCount;
+        for (int k = 0; k < memberCount; k++) {
+            int v = members[k];
+            int from = ctx->forward.mark[v] == settled ? ctx->forward.cameFrom[v] : -1;
+            parent[k] = from >= 0 ? level->localIndex[from] : -1;
+        }
+    }
+}
+
+static void crp_worker_run(void* arg) {
+    CrpWorker* worker = (CrpWorker*)arg;
+    CrpJob* job = worker->job;
+    
+    AStarContext* ctx = astar_context_create(job->overlay->nodeCount);
+    if (!ctx) {
+        atomic_store(&job->failed, true);
+        return;
+    }
+    
+    int cellCount = job->overlay->levels[job->level].cellCount;
+    while (!atomic_load(&job->failed)) {
+        int cell = atomic_fetch_add(&job->nextCell, 1);
+        if (cell >= cellCount) break;
+        crp_customize_cell(job, ctx, cell);
+    }
+    astar_context_free(ctx);
+}
+
+// Fill the cliques of one level; the calling thread is worker 0
+static bool crp_customize_level(CrpJob* job, int threadCount) {
+    atomic_init(&job->nextCell, 0);
+    atomic_init(&job->failed, false);
+    
+    int workerCount = thread_worker_count(threadCount, job->overlay->levels[job->level].cellCount);
+    CrpWorker* workers = (CrpWorker*)calloc(workerCount, sizeof(CrpWorker));
+    bool* started = (bool*)calloc(workerCount, sizeof(bool));
+    if (!workers || !started) {
+        free(workers);
+        free(started);
+        return false;
+    }
+    
+    for (int w = 0; w < workerCount; w++) workers[w].job = job;
+    for (int w = 1; w < workerCount; w++) {
+        started[w] = thread_start(&workers[w].thread, crp_worker_run, &workers[w]);
+    }
+    crp_worker_run(&workers[0]);
+    for (int w = 1; w < workerCount; w++) {
+        if (started[w]) thread_join(&workers[w].thread);
+    }
+    
+    free(workers);
+    free(started);
+    return !atomic_load(&job->failed);
+}
+
+bool crp_customize(CrpOverlay* overlay, const Graph* graph, int threadCount) {
+    if (!overlay || !graph) return false;
+    overlay->customized = false;
+    if (graph->structureVersion != overlay->structureVersion || graph->nodeCount != overlay->nodeCount) {
+        return false;  // Topology changed: needs crp_build
+    }
+    
+    // Largest scale with weight >= scale * length on every edge
+    float scale = FLT_MAX;
+    for (int u = 0; u < graph->nodeCount; u++) {
+        if (!GRAPH_NODE_ACTIVE(graph, u)) continue;
+        for (int k = 0; k < graph->edgeCounts[u]; k++) {
+            const Edge* edge = &graph->edges[u][k];
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, edge->to)) continue;
+            float dx = graph->nodeX[edge->to] - graph->nodeX[u];
+            float dy = graph->nodeY[edge->to] - graph->nodeY[u];
+            float length = sqrtf(dx * dx + dy * dy);
+            if (length > 0.0f && edge->weight < scale * length) scale = edge->weight / length;
+        }
+    }
+    overlay->potentialScale = scale > 0.0f && scale < FLT_MAX ? scale : 0.0f;
+    
+    // Each level reads the cliques of the one below
+    CrpJob job;
+    job.overlay = overlay;
+    job.graph = graph;
+    for (int i = 0; i < overlay->levelCount; i++) {
+        job.level = i;
+        if (!crp_customize_level(&job, threadCount)) return false;
+    }
+    
+    overlay->customized = true;
+    overlay->version = graph->version;
+    return true;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+// Growable node list
+typedef struct {
+    int* nodes;
+    int length;
+    int capacity;
+} CrpList;
+
+static bool crp_list_push(CrpList* list, int node) {
+    if (list->length >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        int* nodes = (int*)realloc(list->nodes, capacity * sizeof(int));
+        if (!nodes) return false;
+        list->nodes = nodes;
+        list->capacity = capacity;
+    }
+    list->nodes[list->length++] = node;
+    return true;
+}
+
+// Highest level (1-based) whose cell of v holds neither endpoint; 0 if
+// every level's cell of v holds one, so v uses the original edges
+static int crp_query_level(const CrpOverlay* overlay, int v, int startId, int goalId) {
+    for (int i = overlay->levelCount - 1; i >= 0; i--) {
+        const int* cell = overlay->levels[i].cell;
+        if (cell[v] != cell[startId] && cell[v] != cell[goalId]) return i + 1;
+    }
+    return 0;
+}
+
+// Append the original nodes after a up to b for a hop found at hopLevel
+// (1-based, 0 for an original edge). hops is scratch shared by the
+// recursion: each call pushes its part above the caller's and pops it.
+static bool crp_unpack(const CrpOverlay* overlay, int a, int b, int hopLevel,
+                       CrpList* hops, CrpList* path) {
+    if (hopLevel == 0 || !crp_is_clique_hop(&overlay->levels[hopLevel - 1], a, b)) {
+        return crp_list_push(path, b);
+    }
+    
+    // Walk the clique's path one level down from the parent table, then
+    // unpack each of its hops
+    int li = hopLevel - 1;
+    const CrpLevel* level = &overlay->levels[li];
+    int cell = level->cell[a];
+    const int* members = level->members + level->memberOffsets[cell];
+    int memberCount = level->memberOffsets[cell + 1] - level->memberOffsets[cell];
+    const int* parent = level->parents + level->parentOffsets[cell] +
+                        (size_t)level->boundaryIndex[a] * memberCount;
+    
+    int base = hops->length;
+    bool ok = true;
+    for (int k = level->localIndex[b]; ok && members[k] != a; k = parent[k]) {
+        ok = crp_list_push(hops, members[k]) && parent[k] >= 0;
+    }
+    
+    int previous = a;
+    for (int i = hops->length - 1; i >= base && ok; i--) {
+        int v = hops->nodes[i];
+        ok = crp_unpack(overlay, previous, v, li, hops, path);
+        previous = v;
+    }
+    hops->length = base;
+    return ok;
+}
+
+// State of one overlay query. Keys use the average potential
+// p(v) = scale * (|v goal| - |start v|) / 2 (forward g + p, backward
+// g - p); scale keeps scaled lengths below every edge's weight, and clique
+// weights are path costs, so it stays consistent on the overlay too.
+typedef struct {
+    AStarFrontier* sides[2];
+    unsigned int reached;
+    unsigned int settled;
+    const float* nodeX;
+    const float* nodeY;
+    float startX, startY;
+    float goalX, goalY;
+    float scale;
+    float bestCost;
+    int meetingNode;
+} CrpQuery;
+
+// Scaled distances from the start to v and from v to the goal, both
+// lower bounds on the cost of those legs
+static void crp_bounds(const CrpQuery* q, int v, float* fromStart, float* toGoal) {
+    float x = q->nodeX[v];
+    float y = q->nodeY[v];
+    *fromStart = sqrtf((x - q->startX) * (x - q->startX) + (y - q->startY) * (y - q->startY)) * q->scale;
+    *toGoal = sqrtf((x - q->goalX) * (x - q->goalX) + (y - q->goalY) * (y - q->goalY)) * q->scale;
+}
+
+// Relax one overlay edge of a query side, recording paths that meet the other side
+static void crp_query_relax(CrpQuery* q, int d, int v, float g, int from) {
+    if (g >= q->bestCost) return;  // Cannot lead to a shorter path
+    AStarFrontier* side = q->sides[d];
+    const AStarFrontier* other = q->sides[1 - d];
+    unsigned int mark = side->mark[v];
+    if (mark == q->settled || (mark == q->reached && g >= side->gScore[v])) return;
+    
+    // Skip nodes that cannot lie on a path shorter than the best one
+    float fromStart, toGoal;
+    crp_bounds(q, v, &fromStart, &toGoal);
+    if (g + (d == 0 ? toGoal : fromStart) >= q->bestCost) return;
+    
+    float potential = (toGoal - fromStart) * 0.5f;
+    crp_relax(side, q->reached, q->settled, v, g, d == 0 ? g + potential : g - potential, from);
+    if (other->mark[v] >= q->reached && g + other->gScore[v] < q->bestCost) {
+        q->bestCost = g + other->gScore[v];
+        q->meetingNode = v;
+    }
+}
+
+// Expand u on one side: forward follows outgoing edges and clique rows,
+// backward incoming edges and clique columns
+static void crp_query_expand(CrpQuery* q, const CrpOverlay* overlay, const Graph* graph,
+                             int d, int u, int level) {
+    const AStarFrontier* side = q->sides[d];
+    float g = side->gScore[u];
+    
+    // Inside an endpoint's cells (or off the boundary) the original edges are
+    // used. A node reached by a hop across its own cell skips the clique:
+    // cliques hold shortest paths, so the hop's tail already relaxed it.
+    int cell = -1;
+    const CrpLevel* cells = level > 0 ? &overlay->levels[level - 1] : NULL;
+    if (cells && cells->boundaryIndex[u] >= 0) cell = cells->cell[u];
+    int from = side->cameFrom[u];
+    if (cell >= 0 && !(from >= 0 && cells->cell[from] == cell && cells->boundaryIndex[from] >= 0)) {
+        int first = cells->boundaryOffsets[cell];
+        int count = cells->boundaryOffsets[cell + 1] - first;
+        const float* row = (d == 0 ? cells->matrix : cells->matrixIn) + cells->matrixOffsets[cell] +
+                           (size_t)cells->boundaryIndex[u] * count;
+        // Most targets of a row are already settled; skip those before the
+        // call, since rows are where nearly all relaxations come from
+        const int* boundary = cells->boundary + first;
+        for (int j = 0; j < count; j++) {
+            int v = boundary[j];
+            if (row[j] < FLT_MAX && side->mark[v] != q->settled) crp_query_relax(q, d, v, g + row[j], u);
+        }
+    }
+    
+    // Then the edges that leave the clique's cell (all edges without one)
+    if (d == 0) {
+        for (int k = 0; k < graph->edgeCounts[u]; k++) {
+            const Edge* edge = &graph->edges[u][k];
+            int v = edge->to;
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, v)) continue;
+            if (cell >= 0 && cells->cell[v] == cell) continue;
+            crp_query_relax(q, d, v, g + edge->weight, u);
+        }
+    } else {
+        for (int k = 0; k < graph->inEdgeCounts[u]; k++) {
+            const EdgeRef* ref = &graph->inEdges[u][k];
+            const Edge* edge = &graph->edges[ref->from][ref->slot];
+            int v = ref->from;
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, v)) continue;
+            if (cell >= 0 && cells->cell[v] == cell) continue;
+            crp_query_relax(q, d, v, g + edge->weight, u);
+        }
+    }
+}
+
+PathResult crp_find_path_ctx(
+    AStarContext* ctx,
+    const CrpOverlay* overlay,
+    const Graph* graph,
+    int startId,
+    int goalId,
+    AStarStats* stats
+) {
+    PathResult result = path_result_create();
+    if (!ctx || !overlay || !graph || !overlay->customized || overlay->version != graph->version) {
+        return result;
+    }
+    if (startId < 0 || goalId < 0 || startId >= graph->nodeCount || goalId >= graph->nodeCount) {
+        return result;
+    }
+    if (!GRAPH_NODE_ACTIVE(graph, startId) || !GRAPH_NODE_ACTIVE(graph, goalId)) return result;
+    
+    AStarStats localStats = {0};
+    double startTime = astar_time_ms();
+    if (!astar_context_reset(ctx, graph->nodeCount, PQ_INDEXED_HEAP, true)) return result;
+    
+    CrpQuery q;
+    q.sides[0] = &ctx->forward;
+    q.sides[1] = &ctx->backward;
+    q.reached = ASTAR_MARK_REACHED(ctx);
+    q.settled = ASTAR_MARK_SETTLED(ctx);
+    q.nodeX = graph->nodeX;
+    q.nodeY = graph->nodeY;
+    q.startX = graph->nodeX[startId];
+    q.startY = graph->nodeY[startId];
+    q.goalX = graph->nodeX[goalId];
+    q.goalY = graph->nodeY[goalId];
+    q.scale = overlay->potentialScale;
+    q.bestCost = startId == goalId ? 0.0f : FLT_MAX;
+    q.meetingNode = startId == goalId ? startId : -1;
+    
+    // p(start) and -p(goal) are both half the scaled start-goal distance
+    float fromStart, toGoal;
+    crp_bounds(&q, startId, &fromStart, &toGoal);
+    float seedKey = toGoal * 0.5f;
+    int seeds[2] = { startId, goalId };
+    for (int d = 0; d < 2; d++) {
+        q.sides[d]->gScore[seeds[d]] = 0.0f;
+        q.sides[d]->cameFrom[seeds[d]] = -1;
+        q.sides[d]->mark[seeds[d]] = q.reached;
+        pq_push(&q.sides[d]->openSet, seeds[d], seedKey);
+    }
+    
+    while (true) {
+        // Done once no pair of frontier keys can beat the best path
+        float tops[2];
+        for (int k = 0; k < 2; k++) {
+            int topId;
+            if (!pq_peek(&q.sides[k]->openSet, &topId, &tops[k])) tops[k] = FLT_MAX;
+        }
+        if (tops[0] == FLT_MAX || tops[1] == FLT_MAX || tops[0] + tops[1] >= q.bestCost) break;
+        int d = tops[0] <= tops[1] ? 0 : 1;
+    
+        int u;
+        float key;
+        pq_pop(&q.sides[d]->openSet, &u, &key);
+        q.sides[d]->mark[u] = q.settled;
+        localStats.nodesExplored++;
+        if (d == 0) localStats.nodesExploredForward++;
+        else localStats.nodesExploredBackward++;
+    
+        float g = q.sides[d]->gScore[u];
+        const AStarFrontier* other = q.sides[1 - d];
+        if (other->mark[u] >= q.reached && g + other->gScore[u] < q.bestCost) {
+            q.bestCost = g + other->gScore[u];
+            q.meetingNode = u;
+        }
+        crp_query_expand(&q, overlay, graph, d, u, crp_query_level(overlay, u, startId, goalId));
+    
+        int openSize = ctx->forward.openSet.size + ctx->backward.openSet.size;
+        if (openSize > localStats.maxOpenSetSize) {
+            localStats.maxOpenSetSize = openSize;
+        }
+    }
+    localStats.nodesInOpenSet = ctx->forward.openSet.size + ctx->backward.openSet.size;
+    
+    int meetingNode = q.meetingNode;
+    if (meetingNode >= 0) {
+        // Overlay path start -> meeting node -> goal
+        CrpList overlayPath = {0};
+        CrpList hops = {0};
+        CrpList path = {0};
+        bool ok = true;
+        for (int v = meetingNode; v != -1 && ok; v = ctx->forward.cameFrom[v]) {
+            ok = crp_list_push(&overlayPath, v);
+        }
+        int meetingIndex = overlayPath.length - 1;
+        for (int i = 0, j = overlayPath.length - 1; i < j; i++, j--) {
+            int tmp = overlayPath.nodes[i];
+            overlayPath.nodes[i] = overlayPath.nodes[j];
+            overlayPath.nodes[j] = tmp;
+        }
+        for (int v = ctx->backward.cameFrom[meetingNode]; v != -1 && ok; v = ctx->backward.cameFrom[v]) {
+            ok = crp_list_push(&overlayPath, v);
+        }
+    
+        // A hop was relaxed from its tail on the forward side and from its
+        // head on the backward side, at that node's query level
+        ok = ok && crp_list_push(&path, startId);
+        for (int i = 0; i + 1 < overlayPath.length && ok; i++) {
+            int a = overlayPath.nodes[i];
+            int b = overlayPath.nodes[i + 1];
+            int level = crp_query_level(overlay, i < meetingIndex ? a : b, startId, goalId);
+            ok = crp_unpack(overlay, a, b, level, &hops, &path);
+        }
+    
+        if (ok) {
+            result.nodes = path.nodes;
+            result.length = path.length;
+            result.totalCost = q.bestCost;
+            result.found = true;
+        } else {
+            free(path.nodes);
+        }
+        free(overlayPath.nodes);
+        free(hops.nodes);
+    }
+    
+    localStats.searchTimeMs = (float)(astar_time_ms() - startTime);
+    ASTAR_COUNT(metrics_record_global(METRICS_ENGINE_CRP, &localStats, result.found));
+    if (stats) *stats = localStats;
+    return result;
+}
+
+PathResult crp_find_path(const CrpOverlay* overlay, const Graph* graph,
+                         int startId, int goalId, AStarStats* stats) {
+    if (!overlay || overlay->nodeCount <= 0) return path_result_create();
+    
+    AStarContext* ctx = astar_context_create(overlay->nodeCount);
+    if (!ctx) return path_result_create();
+    
+    PathResult result = crp_find_path_ctx(ctx, overlay, graph, startId, goalId, stats);
+    astar_context_free(ctx);
+    return result;
+}
@@ -0,0 +1,154 @@
+/**
+ * crp.h - Customizable route planning (multi-level partition overlay)
+ *
+ * Splits the graph into nested cells and keeps, for every cell, a clique
+ * of shortest distances between its boundary nodes (nodes with an edge to
+ * another cell). Unlike contraction hierarchies, the expensive part only
+ * depends on the topology, so new weights need no new preprocessing:
+ *
+ * - crp_build (metric-independent, slow): recursive bisection of the node
+ *   coordinates. Each split tries both axes and several positions around
+ *   the median and keeps the one cutting the fewest edges. Level i cells
+ *   hold at most cellSizes[i] nodes and are unions of level i - 1 cells.
+ * - crp_customize (fast, parallel): recomputes every clique from the
+ *   current weights, level by level. A level 0 clique comes from Dijkstra
+ *   over the cell's own edges; a higher one from Dijkstra over the cliques
+ *   of its subcells and the edges between them, so each search only sees
+ *   boundary nodes. The cells of a level are shared out between threads.
+ *   Each search's parent pointers are kept for unpacking.
+ * - crp_find_path: bidirectional A* on the overlay, with a coordinate
+ *   potential scaled below the smallest weight per unit length. A node
+ *   uses the highest level at which its cell contains neither endpoint: it
+ *   follows that cell's clique plus the edges leaving it, or the original
+ *   edges near the endpoints. Clique hops are unpacked level by level into
+ *   original edges by walking the stored parents.
+ *
+ * Queries do not reach CH speed. On the bench graphs (10k-40k nodes) the
+ * median query takes 2.5-7x as long as ch_find_path and 1.3-2.7x less
+ * than plain A*. Nearly all of it goes to clique rows (about 14k
+ * relaxations per query for under 1200 settled nodes). What the overlay
+ * buys is that new weights cost one crp_customize instead of a new
+ * ch_build.
+ *
+ * Call crp_customize after edge weights change (for example after
+ * graph_apply_weight_updates); queries on an overlay whose graph changed
+ * since the last customization find no path. Adding or removing nodes or
+ * edges needs a new crp_build.
+ */
+
+#ifndef CRP_H
+#define CRP_H
+
+#include "graph.h"
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRP_MAX_LEVELS 4
+#define CRP_AUTO_THREADS 0       // One worker per CPU
+
+typedef struct {
+    int levelCount;                  // Requested levels (at most CRP_MAX_LEVELS)
+    int cellSizes[CRP_MAX_LEVELS];   // Most nodes per cell, increasing with the level
+} CrpConfig;
+
+// One level of the partition
+typedef struct {
+    int cellCount;
+    int* cell;               // cell[v]: cell of node v (-1 for inactive nodes)
+    int* boundaryIndex;      // Position of v among its cell's boundary nodes (-1 if inside)
+
+    // Boundary nodes of cell c are boundary[boundaryOffsets[c] .. boundaryOffsets[c + 1])
+    int* boundaryOffsets;
+    int* boundary;
+
+    // Clique of cell c: b x b distances from boundary i to boundary j at
+    // matrix[matrixOffsets[c] + i * b + j] (INFINITY if not connected inside)
+    size_t* matrixOffsets;
+    float* matrix;
+    float* matrixIn;         // Transpose of matrix, so backward searches read rows too
+    
+    // Nodes a search inside cell c can settle: all of its nodes on level 0,
+    // the boundary nodes of its subcells above. They are
+    // members[memberOffsets[c] .. memberOffsets[c + 1]), and localIndex[v]
+    // is v's position there (-1 if v is not a member of its cell).
+    int* memberOffsets;
+    int* members;
+    int* localIndex;
+    
+    // Shortest path trees behind the clique, for unpacking: with m members,
+    // parents[parentOffsets[c] + i * m + k] is the member before member k
+    // on the path from boundary i (-1 for the source and unreached members)
+    size_t* parentOffsets;
+    int* parents;
+} CrpLevel;
+
+// Partition overlay of a graph
+typedef struct {
+    int nodeCount;
+    int levelCount;
+    CrpLevel levels[CRP_MAX_LEVELS];
+
+    unsigned int structureVersion;   // Graph structure the partition was built for
+
+    bool customized;
+    unsigned int version;    // Graph version at the last customization
+    float potentialScale;    // Largest s with weight >= s * length on every edge (goal direction)
+} CrpOverlay;
+
+// Cells of up to 64 nodes, growing 8x per level while the top level keeps
+// at least 8 cells (two levels at 10k nodes, three at 40k)
+CrpConfig crp_default_config(int nodeCount);
+
+/**
+ * Partition a graph and lay out its overlay (weights are not read)
+ *
+ * Levels whose cells would hold the whole graph are dropped.
+ *
+ * @param graph    The graph to partition
+ * @param config   Cell sizes (NULL for crp_default_config of the active node count)
+ * @param overlay  Output (call crp_free when done; crp_customize before querying)
+ * @return         false on allocation failure
+ */
+bool crp_build(const Graph* graph, const CrpConfig* config, CrpOverlay* overlay);
+void crp_free(CrpOverlay* overlay);
+
+/**
+ * Recompute every clique from the graph's current weights
+ *
+ * @param threadCount  Worker count, or CRP_AUTO_THREADS
+ * @return             false if nodes or edges were added or removed (or
+ *                     the graph was reloaded or compacted) since
+ *                     crp_build, or on allocation failure
+ */
+bool crp_customize(CrpOverlay* overlay, const Graph* graph, int threadCount);
+
+/**
+ * Shortest path query on a customized overlay
+ *
+ * The path is made of original edges. nodesExploredForward/Backward
+ * count the overlay search only, not the unpacking.
+ *
+ * @return  PathResult (call path_result_free when done); not found if the
+ *          overlay is not customized for the graph's current version
+ */
+PathResult crp_find_path(const CrpOverlay* overlay, const Graph* graph,
+                         int startId, int goalId, AStarStats* stats);
+
+// Same as crp_find_path, reusing the frontiers of a search context
+PathResult crp_find_path_ctx(
+    AStarContext* ctx,
+    const CrpOverlay* overlay,
+    const Graph* graph,
+    int startId,
+    int goalId,
+    AStarStats* stats
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRP_H
@@ -0,0 +1,407 @@
+/**
+ * dstar.c - D* Lite incremental re-planning
+ */
+
+#include "dstar.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#define DSTAR_INF FLT_MAX
+
+// ============================================================================
+// Keys and heuristic
+// ============================================================================
+
+static bool dstar_key_less(DStarKey a, DStarKey b) {
+    return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+}
+
+// Lower bound on the cost from -> to
+static float dstar_heuristic(const DStarPlanner* planner, int from, int to) {
+    if (planner->heuristic == HEURISTIC_LANDMARKS) {
+        return landmarks_lower_bound(planner->landmarks, from, to);
+    }
+    const Graph* graph = planner->graph;
+    return astar_heuristic_xy(graph->nodeX[from], graph->nodeY[from],
+                              graph->nodeX[to], graph->nodeY[to], planner->heuristic);
+}
+
+static DStarKey dstar_calculate_key(const DStarPlanner* planner, int v) {
+    float best = fminf(planner->g[v], planner->rhs[v]);
+    DStarKey key;
+    if (best == DSTAR_INF) {
+        key.k1 = DSTAR_INF;
+        key.k2 = DSTAR_INF;
+    } else {
+        key.k1 = best + dstar_heuristic(planner, planner->startId, v) + planner->km;
+        key.k2 = best;
+    }
+    return key;
+}
+
+// ============================================================================
+// Indexed heap over DStarKey
+// ============================================================================
+
+static void dstar_heap_place(DStarPlanner* planner, int slot, int v, DStarKey key) {
+    planner->heap[slot] = v;
+    planner->heapKeys[slot] = key;
+    planner->position[v] = slot;
+}
+
+static void dstar_sift_up(DStarPlanner* planner, int slot) {
+    int v = planner->heap[slot];
+    DStarKey key = planner->heapKeys[slot];
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!dstar_key_less(key, planner->heapKeys[parent])) break;
+        dstar_heap_place(planner, slot, planner->heap[parent], planner->heapKeys[parent]);
+        slot = parent;
+    }
+    dstar_heap_place(planner, slot, v, key);
+}
+
+static void dstar_sift_down(DStarPlanner* planner, int slot) {
+    int v = planner->heap[slot];
+    DStarKey key = planner->heapKeys[slot];
+    for (;;) {
+        int child = 2 * slot + 1;
+        if (child >= planner->heapSize) break;
+        if (child + 1 < planner->heapSize &&
+            dstar_key_less(planner->heapKeys[child + 1], planner->heapKeys[child])) {
+            child++;
+        }
+        if (!dstar_key_less(planner->heapKeys[child], key)) break;
+        dstar_heap_place(planner, slot, planner->heap[child], planner->heapKeys[child]);
+        slot = child;
+    }
+    dstar_heap_place(planner, slot, v, key);
+}
+
+// Insert v or change its key (the heap holds at most one entry per node,
+// so it never outgrows nodeCapacity)
+static void dstar_heap_set(DStarPlanner* planner, int v, DStarKey key) {
+    int slot = planner->position[v];
+    if (slot < 0) {
+        slot = planner->heapSize++;
+        dstar_heap_place(planner, slot, v, key);
+        dstar_sift_up(planner, slot);
+        return;
+    }
+    
+    bool lower = dstar_key_less(key, planner->heapKeys[slot]);
+    planner->heapKeys[slot] = key;
+    if (lower) {
+        dstar_sift_up(planner, slot);
+    } else {
+        dstar_sift_down(planner, slot);
+    }
+}
+
+static void dstar_heap_remove(DStarPlanner* planner, int v) {
+    int slot = planner->position[v];
+    if (slot < 0) return;
+    planner->position[v] = -1;
+    
+    int last = --planner->heapSize;
+    if (slot == last) return;
+    
+    DStarKey removed = planner->heapKeys[slot];
+    dstar_heap_place(planner, slot, planner->heap[last], planner->heapKeys[last]);
+    if (dstar_key_less(planner->heapKeys[slot], removed)) {
+        dstar_sift_up(planner, slot);
+    } else {
+        dstar_sift_down(planner, slot);
+    }
+}
+
+// ============================================================================
+// Planner state
+// ============================================================================
+
+// Grow the per-node arrays to cover every node of the graph
+static bool dstar_reserve(DStarPlanner* planner) {
+    int needed = planner->graph->nodeCount;
+    if (needed <= planner->nodeCapacity) return true;
+    
+    int capacity = planner->nodeCapacity * 2;
+    if (capacity < needed) capacity = needed;
+    
+    float* g = (float*)realloc(planner->g, capacity * sizeof(float));
+    if (!g) return false;
+    planner->g = g;
+    float* rhs = (float*)realloc(planner->rhs, capacity * sizeof(float));
+    if (!rhs) return false;
+    planner->rhs = rhs;
+    int* position = (int*)realloc(planner->position, capacity * sizeof(int));
+    if (!position) return false;
+    planner->position = position;
+    int* heap = (int*)realloc(planner->heap, capacity * sizeof(int));
+    if (!heap) return false;
+    planner->heap = heap;
+    DStarKey* heapKeys = (DStarKey*)realloc(planner->heapKeys, capacity * sizeof(DStarKey));
+    if (!heapKeys) return false;
+    planner->heapKeys = heapKeys;
+    
+    for (int i = planner->nodeCapacity; i < capacity; i++) {
+        g[i] = DSTAR_INF;
+        rhs[i] = DSTAR_INF;
+        position[i] = -1;
+    }
+    planner->nodeCapacity = capacity;
+    planner->heapCapacity = capacity;
+    return true;
+}
+
+// One-step lookahead: min over the out-edges of u of weight + g(target)
+static float dstar_lookahead(const DStarPlanner* planner, int u) {
+    const Graph* graph = planner->graph;
+    if (!GRAPH_NODE_ACTIVE(graph, u)) return DSTAR_INF;
+    if (u == planner->goalId) return 0.0f;
+    
+    float best = DSTAR_INF;
+    for (int i = 0; i < graph->edgeCounts[u]; i++) {
+        const Edge* edge = &graph->edges[u][i];
+        if (!edge->active || !GRAPH_NODE_ACTIVE(graph, edge->to)) continue;
+    
+        float next = planner->g[edge->to];
+        if (next == DSTAR_INF) continue;
+        if (edge->weight + next < best) best = edge->weight + next;
+    }
+    return best;
+}
+
+// Recompute rhs(u) and queue u exactly when it is inconsistent
+static void dstar_update_vertex(DStarPlanner* planner, int u) {
+    planner->rhs[u] = dstar_lookahead(planner, u);
+    if (planner->g[u] != planner->rhs[u]) {
+        dstar_heap_set(planner, u, dstar_calculate_key(planner, u));
+    } else {
+        dstar_heap_remove(planner, u);
+    }
+}
+
+// Re-evaluate every node with an active edge into v
+static void dstar_update_predecessors(DStarPlanner* planner, int v) {
+    const Graph* graph = planner->graph;
+    for (int i = 0; i < graph->inEdgeCounts[v]; i++) {
+        const EdgeRef* ref = &graph->inEdges[v][i];
+        if (ref->slot >= graph->edgeCounts[ref->from]) continue;
+        if (!graph->edges[ref->from][ref->slot].active) continue;
+        dstar_update_vertex(planner, ref->from);
+    }
+}
+
+// Expand inconsistent nodes until the start is consistent and its key is
+// no larger than any queued key
+static int dstar_compute_shortest_path(DStarPlanner* planner, int* maxOpenSetSize) {
+    int start = planner->startId;
+    int expanded = 0;
+    
+    while (planner->heapSize > 0) {
+        if (planner->heapSize > *maxOpenSetSize) *maxOpenSetSize = planner->heapSize;
+    
+        DStarKey top = planner->heapKeys[0];
+        if (!dstar_key_less(top, dstar_calculate_key(planner, start)) &&
+            planner->rhs[start] == planner->g[start]) {
+            break;
+        }
+    
+        // Queued with a key from an earlier start; re-key and retry
+        int u = planner->heap[0];
+        DStarKey fresh = dstar_calculate_key(planner, u);
+        if (dstar_key_less(top, fresh)) {
+            dstar_heap_set(planner, u, fresh);
+            continue;
+        }
+    
+        dstar_heap_remove(planner, u);
+        expanded++;
+    
+        if (planner->g[u] > planner->rhs[u]) {
+            // Cost went down: settle it and offer it to the predecessors
+            planner->g[u] = planner->rhs[u];
+        } else {
+            // Cost went up: invalidate and let u and its predecessors
+            // find their best remaining successor
+            planner->g[u] = DSTAR_INF;
+            dstar_update_vertex(planner, u);
+        }
+        dstar_update_predecessors(planner, u);
+    }
+    
+    return expanded;
+}
+
+// Follow the cheapest successors (weight + g) from the start to the goal
+static PathResult dstar_extract_path(const DStarPlanner* planner) {
+    PathResult result = path_result_create();
+    const Graph* graph = planner->graph;
+    if (planner->rhs[planner->startId] == DSTAR_INF) return result;
+    
+    int capacity = 16;
+    int* nodes = (int*)malloc(capacity * sizeof(int));
+    if (!nodes) return result;
+    
+    int length = 0;
+    float cost = 0.0f;
+    int current = planner->startId;
+    nodes[length++] = current;
+    
+    while (current != planner->goalId) {
+        // A cycle (zero-weight loops) or a broken chain ends the walk
+        if (length > graph->nodeCount) {
+            free(nodes);
+            return result;
+        }
+    
+        int next = -1;
+        float nextWeight = 0.0f;
+        float best = DSTAR_INF;
+        for (int i = 0; i < graph->edgeCounts[current]; i++) {
+            const Edge* edge = &graph->edges[current][i];
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, edge->to)) continue;
+            if (planner->g[edge->to] == DSTAR_INF) continue;
+    
+            float total = edge->weight + planner->g[edge->to];
+            if (total < best) {
+                best = total;
+                next = edge->to;
+                nextWeight = edge->weight;
+            }
+        }
+        if (next < 0) {
+            free(nodes);
+            return result;
+        }
+    
+        if (length == capacity) {
+            int* grown = (int*)realloc(nodes, capacity * 2 * sizeof(int));
+            if (!grown) {
+                free(nodes);
+                return result;
+            }
+            nodes = grown;
+            capacity *= 2;
+        }
+        nodes[length++] = next;
+        cost += nextWeight;
+        current = next;
+    }
+    
+    result.nodes = nodes;
+    result.length = length;
+    result.totalCost = cost;
+    result.found = true;
+    return result;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+DStarPlanner* dstar_create(const Graph* graph, int startId, int goalId, const AStarConfig* config) {
+    if (!graph) return NULL;
+    if (startId < 0 || startId >= graph->nodeCount) return NULL;
+    if (goalId < 0 || goalId >= graph->nodeCount) return NULL;
+    
+    AStarConfig defaults = astar_default_config();
+    if (!config) config = &defaults;
+    
+    DStarPlanner* planner = (DStarPlanner*)calloc(1, sizeof(DStarPlanner));
+    if (!planner) return NULL;
+    
+    planner->graph = graph;
+    planner->startId = startId;
+    planner->goalId = goalId;
+    planner->lastStartId = startId;
+    planner->km = 0.0f;
+    planner->heuristic = config->heuristic;
+    planner->landmarks = config->landmarks;
+    
+    if (!dstar_reserve(planner)) {
+        dstar_free(planner);
+        return NULL;
+    }
+    
+    // Seed the backward search at the goal
+    dstar_update_vertex(planner, goalId);
+    return planner;
+}
+
+void dstar_free(DStarPlanner* planner) {
+    if (!planner) return;
+    free(planner->g);
+    free(planner->rhs);
+    free(planner->position);
+    free(planner->heap);
+    free(planner->heapKeys);
+    free(planner);
+}
+
+bool dstar_update_edge(DStarPlanner* planner, int from, int to) {
+    if (!planner || !dstar_reserve(planner)) return false;
+    
+    // Only rhs(from) depends on the edge
+    (void)to;
+    if (from >= 0 && from < planner->graph->nodeCount) {
+        dstar_update_vertex(planner, from);
+    }
+    return true;
+}
+
+bool dstar_update_edges(DStarPlanner* planner, const DStarEdge* edges, int count) {
+    if (!planner || !dstar_reserve(planner)) return false;
+    
+    for (int i = 0; i < count; i++) {
+        dstar_update_edge(planner, edges[i].from, edges[i].to);
+    }
+    return true;
+}
+
+bool dstar_update_node(DStarPlanner* planner, int nodeId) {
+    if (!planner || !dstar_reserve(planner)) return false;
+    
+    const Graph* graph = planner->graph;
+    if (nodeId < 0 || nodeId >= graph->nodeCount) return true;
+    
+    // Removal also deactivates the in-edges, so visit all of them
+    dstar_update_vertex(planner, nodeId);
+    for (int i = 0; i < graph->inEdgeCounts[nodeId]; i++) {
+        dstar_update_vertex(planner, graph->inEdges[nodeId][i].from);
+    }
+    return true;
+}
+
+bool dstar_set_start(DStarPlanner* planner, int startId) {
+    if (!planner || startId < 0 || startId >= planner->graph->nodeCount) return false;
+    planner->startId = startId;
+    return true;
+}
+
+PathResult dstar_find_path(DStarPlanner* planner, AStarStats* stats) {
+    double startTime = astar_time_ms();
+    AStarStats localStats = {0};
+    PathResult result = path_result_create();
+    
+    if (planner && dstar_reserve(planner) && GRAPH_NODE_ACTIVE(planner->graph, planner->startId)) {
+        // Keys already queued were computed for the old start; km keeps
+        // them lower bounds instead of re-keying the whole queue
+        if (planner->startId != planner->lastStartId) {
+            planner->km += dstar_heuristic(planner, planner->lastStartId, planner->startId);
+            planner->lastStartId = planner->startId;
+        }
+    
+        localStats.nodesExplored = dstar_compute_shortest_path(planner, &localStats.maxOpenSetSize);
+        localStats.nodesExploredForward = localStats.nodesExplored;
+        localStats.nodesInOpenSet = planner->heapSize;
+        result = dstar_extract_path(planner);
+    }
+    
+    localStats.searchTimeMs = (float)(astar_time_ms() - startTime);
+    ASTAR_COUNT(metrics_record_global(METRICS_ENGINE_DSTAR, &localStats, result.found));
+    if (stats) *stats = localStats;
+    return result;
+}
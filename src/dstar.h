@@ -0,0 +1,121 @@
+/**
+ * dstar.h - D* Lite incremental re-planning
+ *
+ * A planner that keeps its search state between queries, for routes that
+ * must follow a changing graph (traffic updates, closures) and a moving
+ * start (a vehicle driving the route).
+ *
+ * The search runs backward from the goal, so g(v) is the cost from v to
+ * the goal and rhs(v) is the one-step lookahead min over out-edges of
+ * weight + g(target). A node is consistent when g == rhs. After edges
+ * change, only the nodes whose rhs changed are queued, and the repair
+ * stops as soon as the start is consistent again and no queued key can
+ * improve it; the work scales with the part of the shortest-path tree
+ * the change touches, not with the size of the map.
+ *
+ * The planner reads the live Graph. Edit it directly (graph_add_edge,
+ * graph_remove_edge, graph_set_edge_weight, graph_remove_node, ...)
+ * and report the touched edges and nodes before the next dstar_find_path.
+ *
+ * Reference: S. Koenig and M. Likhachev, "D* Lite", AAAI 2002.
+ */
+
+#ifndef DSTAR_H
+#define DSTAR_H
+
+#include "graph.h"
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Priority of a queued node, compared lexicographically
+typedef struct {
+    float k1;                // min(g, rhs) + h(start, v) + km
+    float k2;                // min(g, rhs)
+} DStarKey;
+
+// An edge whose weight changed, or that was added or removed
+typedef struct {
+    int from;
+    int to;
+} DStarEdge;
+
+// Persistent planner state
+// Per-node arrays are sized for nodeCapacity IDs and grow with the graph.
+typedef struct {
+    const Graph* graph;
+    int startId;
+    int goalId;
+    int lastStartId;         // Start when km was last updated
+    float km;                // Accumulated heuristic offset for start moves
+    
+    HeuristicType heuristic;
+    const LandmarkTable* landmarks;
+    
+    float* g;
+    float* rhs;
+    int* position;           // Node ID -> heap slot, -1 when not queued
+    int nodeCapacity;
+    
+    // Binary min-heap of inconsistent nodes
+    int* heap;
+    DStarKey* heapKeys;
+    int heapSize;
+    int heapCapacity;
+} DStarPlanner;
+
+/**
+ * Create a planner for one start/goal pair
+ *
+ * Only the heuristic and landmarks of config are used (the search always
+ * runs with weight 1 and does not trace). The heuristic must stay a lower
+ * bound while weights change: coordinate heuristics need weights of at
+ * least the straight-line distance, landmark tables stay valid only while
+ * weights do not drop below the ones they were built from. HEURISTIC_ZERO
+ * is always safe.
+ *
+ * @param graph     The graph to plan on (must outlive the planner)
+ * @param startId   Starting node ID
+ * @param goalId    Goal node ID
+ * @param config    Algorithm configuration (can be NULL for defaults)
+ * @return          The planner, or NULL on invalid IDs or allocation failure
+ */
+DStarPlanner* dstar_create(const Graph* graph, int startId, int goalId, const AStarConfig* config);
+void dstar_free(DStarPlanner* planner);
+
+/**
+ * Report edges that changed since the last query
+ *
+ * Call after editing the graph. An edge may be reported more than once;
+ * the work is done by the next dstar_find_path.
+ *
+ * @return  false if the per-node arrays could not be grown
+ */
+bool dstar_update_edges(DStarPlanner* planner, const DStarEdge* edges, int count);
+bool dstar_update_edge(DStarPlanner* planner, int from, int to);
+
+// Report a node that was added or removed (covers all of its in-edges)
+bool dstar_update_node(DStarPlanner* planner, int nodeId);
+
+// Move the start (e.g. to the vehicle's current node); the goal is fixed
+bool dstar_set_start(DStarPlanner* planner, int startId);
+
+/**
+ * Bring the search up to date and extract the current shortest path
+ *
+ * The first call runs a full backward search; later calls only repair
+ * what the reported changes invalidated. stats->nodesExplored counts the
+ * nodes expanded by this call.
+ *
+ * @param stats     Output statistics (can be NULL if not needed)
+ * @return          PathResult containing the path (call path_result_free when done)
+ */
+PathResult dstar_find_path(DStarPlanner* planner, AStarStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSTAR_H
@@ -3,61 +3,390 @@
  */
 
 #include "graph.h"
+#include "nameindex.h"
+#include "spatial.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdatomic.h>
+
+// Copy a string of at most maxLength - 1 characters into the arena
+static const char* string_arena_store(StringArena* arena, const char* text, size_t maxLength) {
+    size_t length = strlen(text);
+    if (length > maxLength - 1) length = maxLength - 1;
+    if (length == 0) return "";
+    
+    StringBlock* block = arena->head;
+    if (!block || block->size - block->used < length + 1) {
+        size_t size = STRING_ARENA_BLOCK_SIZE > length + 1 ? STRING_ARENA_BLOCK_SIZE : length + 1;
+        block = (StringBlock*)malloc(sizeof(StringBlock) + size);
+        if (!block) return NULL;
+        block->next = arena->head;
+        block->size = size;
+        block->used = 0;
+        arena->head = block;
+    }
+    
+    char* copy = block->data + block->used;
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    block->used += length + 1;
+    arena->bytes += length + 1;
+    return copy;
+}
+
+static void string_arena_free(StringArena* arena) {
+    StringBlock* block = arena->head;
+    while (block) {
+        StringBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->bytes = 0;
+}
+
+// Source of Graph.instanceId
+static atomic_uint graphInstanceCounter;
 
 // Initialize graph
 void graph_init(Graph* graph) {
     if (!graph) return;
     
+    graph->nodes = NULL;
     graph->nodeCount = 0;
-    memset(graph->nodes, 0, sizeof(graph->nodes));
-    memset(graph->edges, 0, sizeof(graph->edges));
-    memset(graph->edgeCounts, 0, sizeof(graph->edgeCounts));
+    graph->nodeCapacity = 0;
+    graph->nodeX = NULL;
+    graph->nodeY = NULL;
+    graph->activeBits = NULL;
+    graph->names.head = NULL;
+    graph->names.bytes = 0;
+    graph->edges = NULL;
+    graph->edgeCounts = NULL;
+    graph->edgeCapacities = NULL;
+    graph->inEdges = NULL;
+    graph->inEdgeCounts = NULL;
+    graph->inEdgeCapacities = NULL;
+    graph->edgeIndex = NULL;
+    graph->edgeIdCount = 0;
+    graph->edgeIdCapacity = 0;
+    graph->deadNodes = 0;
+    graph->deadEdges = 0;
+    graph->version = 0;
+    graph->structureVersion = 0;
+    graph->instanceId = atomic_fetch_add_explicit(&graphInstanceCounter, 1, memory_order_relaxed) + 1;
+    graph->blockVersions = NULL;
+    graph->nameIndex = NULL;
+    graph->spatialIndex = NULL;
 }
 
 // Free graph resources
 void graph_free(Graph* graph) {
     if (!graph) return;
+    
+    if (graph->edges) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            free(graph->edges[i]);
+        }
+    }
+    if (graph->inEdges) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            free(graph->inEdges[i]);
+        }
+    }
+    free(graph->nodes);
+    free(graph->nodeX);
+    free(graph->nodeY);
+    free(graph->activeBits);
+    string_arena_free(&graph->names);
+    free(graph->edges);
+    free(graph->edgeCounts);
+    free(graph->edgeCapacities);
+    free(graph->inEdges);
+    free(graph->inEdgeCounts);
+    free(graph->inEdgeCapacities);
+    free(graph->edgeIndex);
+    free(graph->blockVersions);
+    name_index_free(graph->nameIndex);
+    spatial_index_free(graph->spatialIndex);
+    
+    // Keep counting, so results cached for the old contents stay stale
+    unsigned int version = graph->version;
+    unsigned int structureVersion = graph->structureVersion;
     graph_init(graph);  // Reset to initial state
+    graph->version = version + 1;
+    graph->structureVersion = structureVersion + 1;
+}
+
+// Record a change to the block of a node (after bumping the version)
+static void graph_mark_block(Graph* graph, int nodeId) {
+    graph->blockVersions[nodeId >> GRAPH_BLOCK_SHIFT] = graph->version;
+}
+
+static void graph_mark_all_blocks(Graph* graph) {
+    int blocks = (graph->nodeCount + GRAPH_BLOCK_NODES - 1) >> GRAPH_BLOCK_SHIFT;
+    for (int i = 0; i < blocks; i++) graph->blockVersions[i] = graph->version;
+}
+
+// Mark the graph as changed (for edits made through graph_get_node etc.)
+// Which nodes changed is unknown, so every block counts as changed.
+void graph_touch(Graph* graph) {
+    if (!graph) return;
+    graph->version++;
+    graph->structureVersion++;
+    graph_mark_all_blocks(graph);
+}
+
+// Make room for at least nodeCapacity nodes
+bool graph_reserve(Graph* graph, int nodeCapacity) {
+    if (!graph || nodeCapacity < 0) return false;
+    if (nodeCapacity <= graph->nodeCapacity) return true;
+    
+    Node* nodes = (Node*)realloc(graph->nodes, nodeCapacity * sizeof(Node));
+    if (!nodes) return false;
+    graph->nodes = nodes;
+    
+    float* nodeX = (float*)realloc(graph->nodeX, nodeCapacity * sizeof(float));
+    if (!nodeX) return false;
+    graph->nodeX = nodeX;
+    
+    float* nodeY = (float*)realloc(graph->nodeY, nodeCapacity * sizeof(float));
+    if (!nodeY) return false;
+    graph->nodeY = nodeY;
+    
+    int oldWords = (graph->nodeCapacity + 31) / 32;
+    int words = (nodeCapacity + 31) / 32;
+    unsigned int* activeBits = (unsigned int*)realloc(graph->activeBits, words * sizeof(unsigned int));
+    if (!activeBits) return false;
+    memset(activeBits + oldWords, 0, (words - oldWords) * sizeof(unsigned int));
+    graph->activeBits = activeBits;
+    
+    // New blocks start out changed
+    int oldBlocks = (graph->nodeCapacity + GRAPH_BLOCK_NODES - 1) >> GRAPH_BLOCK_SHIFT;
+    int blocks = (nodeCapacity + GRAPH_BLOCK_NODES - 1) >> GRAPH_BLOCK_SHIFT;
+    unsigned int* blockVersions = (unsigned int*)realloc(graph->blockVersions, blocks * sizeof(unsigned int));
+    if (!blockVersions) return false;
+    for (int i = oldBlocks; i < blocks; i++) blockVersions[i] = graph->version;
+    graph->blockVersions = blockVersions;
+    
+    Edge** edges = (Edge**)realloc(graph->edges, nodeCapacity * sizeof(Edge*));
+    if (!edges) return false;
+    graph->edges = edges;
+    
+    int* edgeCounts = (int*)realloc(graph->edgeCounts, nodeCapacity * sizeof(int));
+    if (!edgeCounts) return false;
+    graph->edgeCounts = edgeCounts;
+    
+    int* edgeCapacities = (int*)realloc(graph->edgeCapacities, nodeCapacity * sizeof(int));
+    if (!edgeCapacities) return false;
+    graph->edgeCapacities = edgeCapacities;
+    
+    EdgeRef** inEdges = (EdgeRef**)realloc(graph->inEdges, nodeCapacity * sizeof(EdgeRef*));
+    if (!inEdges) return false;
+    graph->inEdges = inEdges;
+    
+    int* inEdgeCounts = (int*)realloc(graph->inEdgeCounts, nodeCapacity * sizeof(int));
+    if (!inEdgeCounts) return false;
+    graph->inEdgeCounts = inEdgeCounts;
+    
+    int* inEdgeCapacities = (int*)realloc(graph->inEdgeCapacities, nodeCapacity * sizeof(int));
+    if (!inEdgeCapacities) return false;
+    graph->inEdgeCapacities = inEdgeCapacities;
+    
+    graph->nodeCapacity = nodeCapacity;
+    return true;
+}
+
+// Grow the edge row of a node so it can hold one more edge
+static bool graph_reserve_edge(Graph* graph, int nodeId) {
+    if (graph->edgeCounts[nodeId] < graph->edgeCapacities[nodeId]) return true;
+    
+    int capacity = graph->edgeCapacities[nodeId] > 0 ?
+                   graph->edgeCapacities[nodeId] * 2 : GRAPH_INITIAL_EDGE_CAPACITY;
+    Edge* row = (Edge*)realloc(graph->edges[nodeId], capacity * sizeof(Edge));
+    if (!row) return false;
+    
+    graph->edges[nodeId] = row;
+    graph->edgeCapacities[nodeId] = capacity;
+    return true;
+}
+
+// Grow the reverse row of a node so it can hold one more entry
+static bool graph_reserve_reverse(Graph* graph, int nodeId) {
+    if (graph->inEdgeCounts[nodeId] < graph->inEdgeCapacities[nodeId]) return true;
+    
+    int capacity = graph->inEdgeCapacities[nodeId] > 0 ?
+                   graph->inEdgeCapacities[nodeId] * 2 : GRAPH_INITIAL_EDGE_CAPACITY;
+    EdgeRef* row = (EdgeRef*)realloc(graph->inEdges[nodeId], capacity * sizeof(EdgeRef));
+    if (!row) return false;
+    
+    graph->inEdges[nodeId] = row;
+    graph->inEdgeCapacities[nodeId] = capacity;
+    return true;
+}
+
+// Grow the edge ID index so it can hold one more ID
+static bool graph_reserve_edge_id(Graph* graph) {
+    if (graph->edgeIdCount < graph->edgeIdCapacity) return true;
+    
+    int capacity = graph->edgeIdCapacity > 0 ? graph->edgeIdCapacity * 2 : GRAPH_INITIAL_EDGE_CAPACITY;
+    EdgeRef* index = (EdgeRef*)realloc(graph->edgeIndex, capacity * sizeof(EdgeRef));
+    if (!index) return false;
+    
+    graph->edgeIndex = index;
+    graph->edgeIdCapacity = capacity;
+    return true;
+}
+
+// Record edges[from][slot] in the reverse adjacency of its target
+static bool graph_link_reverse(Graph* graph, int from, int slot) {
+    int to = graph->edges[from][slot].to;
+    if (!graph_reserve_reverse(graph, to)) return false;
+    
+    EdgeRef* ref = &graph->inEdges[to][graph->inEdgeCounts[to]++];
+    ref->from = from;
+    ref->slot = slot;
+    return true;
+}
+
+// Mirror a node's coordinates and active flag into the hot arrays
+static void graph_sync_node(Graph* graph, int id) {
+    const Node* node = &graph->nodes[id];
+    graph->nodeX[id] = node->x;
+    graph->nodeY[id] = node->y;
+    if (node->active) {
+        graph->activeBits[id >> 5] |= 1u << (id & 31);
+    } else {
+        graph->activeBits[id >> 5] &= ~(1u << (id & 31));
+    }
+}
+
+// Give edges[from][slot] the next edge ID
+static bool graph_register_edge(Graph* graph, int from, int slot) {
+    if (!graph_reserve_edge_id(graph)) return false;
+    
+    int id = graph->edgeIdCount++;
+    graph->edgeIndex[id].from = from;
+    graph->edgeIndex[id].slot = slot;
+    graph->edges[from][slot].id = id;
+    return true;
+}
+
+// Index the names of all active nodes from scratch
+// On failure the graph is left without an index (lookups fall back to scanning).
+static bool graph_rebuild_name_index(Graph* graph) {
+    name_index_free(graph->nameIndex);
+    graph->nameIndex = name_index_create();
+    
+    bool ok = graph->nameIndex != NULL;
+    for (int i = 0; i < graph->nodeCount && ok; i++) {
+        if (graph->nodes[i].active) ok = name_index_add(graph->nameIndex, graph->nodes[i].name, i);
+    }
+    if (!ok) {
+        name_index_free(graph->nameIndex);
+        graph->nameIndex = NULL;
+    }
+    return ok;
+}
+
+// Same for the spatial index
+static bool graph_rebuild_spatial_index(Graph* graph) {
+    spatial_index_free(graph->spatialIndex);
+    graph->spatialIndex = spatial_index_create(SPATIAL_DEFAULT_CELL_SIZE);
+    
+    bool ok = graph->spatialIndex != NULL;
+    for (int i = 0; i < graph->nodeCount && ok; i++) {
+        const Node* node = &graph->nodes[i];
+        if (node->active) ok = spatial_index_add(graph->spatialIndex, i, node->x, node->y);
+    }
+    if (!ok) {
+        spatial_index_free(graph->spatialIndex);
+        graph->spatialIndex = NULL;
+    }
+    return ok;
 }
 
 // Add a node to the graph
 int graph_add_node(Graph* graph, const char* name, float x, float y) {
-    if (!graph || graph->nodeCount >= MAX_NODES) return -1;
+    if (!graph || !name) return -1;
+    
+    if (graph->nodeCount >= graph->nodeCapacity) {
+        int capacity = graph->nodeCapacity > 0 ?
+                       graph->nodeCapacity * 2 : GRAPH_INITIAL_NODE_CAPACITY;
+        if (!graph_reserve(graph, capacity)) return -1;
+    }
+    
+    const char* stored = string_arena_store(&graph->names, name, MAX_NAME_LENGTH);
+    if (!stored) return -1;
     
     int id = graph->nodeCount;
     Node* node = &graph->nodes[id];
     
     node->id = id;
-    strncpy(node->name, name, MAX_NAME_LENGTH - 1);
-    node->name[MAX_NAME_LENGTH - 1] = '\0';
+    node->name = stored;
     node->x = x;
     node->y = y;
     node->active = true;
+    graph_sync_node(graph, id);
+    
+    graph->edges[id] = NULL;
+    graph->edgeCounts[id] = 0;
+    graph->edgeCapacities[id] = 0;
+    graph->inEdges[id] = NULL;
+    graph->inEdgeCounts[id] = 0;
+    graph->inEdgeCapacities[id] = 0;
     
     graph->nodeCount++;
+    graph->version++;
+    graph->structureVersion++;
+    graph_mark_block(graph, id);
+    
+    // A partially updated index would miss names, so rebuild it instead
+    if (!graph->nameIndex || !name_index_add(graph->nameIndex, node->name, id)) {
+        graph_rebuild_name_index(graph);
+    }
+    if (!graph->spatialIndex || !spatial_index_add(graph->spatialIndex, id, x, y)) {
+        graph_rebuild_spatial_index(graph);
+    }
     return id;
 }
 
-// Remove a node (mark as inactive)
+// Remove a node (mark it and its edges inactive)
+// Incoming edges are found through the reverse adjacency, so this costs
+// O(degree) rather than a sweep over every edge in the graph.
 bool graph_remove_node(Graph* graph, int nodeId) {
     if (!graph || nodeId < 0 || nodeId >= graph->nodeCount) return false;
     
-    graph->nodes[nodeId].active = false;
-    
-    // Remove all edges to/from this node
-    graph->edgeCounts[nodeId] = 0;
+    Node* node = &graph->nodes[nodeId];
+    if (!node->active) return true;
+    
+    name_index_remove(graph->nameIndex, node->name, nodeId);
+    spatial_index_remove(graph->spatialIndex, nodeId, node->x, node->y);
+    node->active = false;
+    graph_sync_node(graph, nodeId);
+    graph->deadNodes++;
+    graph->version++;
+    graph->structureVersion++;
+    graph_mark_block(graph, nodeId);
+    
+    // Remove all edges from this node
+    for (int i = 0; i < graph->edgeCounts[nodeId]; i++) {
+        Edge* edge = &graph->edges[nodeId][i];
+        if (edge->active) {
+            edge->active = false;
+            graph->deadEdges++;
+        }
+    }
     
     // Remove edges from other nodes to this one
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (i == nodeId) continue;
-        for (int j = 0; j < graph->edgeCounts[i]; j++) {
-            if (graph->edges[i][j].to == nodeId) {
-                graph->edges[i][j].active = false;
-            }
+    for (int i = 0; i < graph->inEdgeCounts[nodeId]; i++) {
+        const EdgeRef* ref = &graph->inEdges[nodeId][i];
+        Edge* edge = &graph->edges[ref->from][ref->slot];
+        if (edge->active) {
+            edge->active = false;
+            graph->deadEdges++;
+            graph_mark_block(graph, ref->from);
         }
     }
     
@@ -71,71 +400,47 @@ Node* graph_get_node(Graph* graph, int nodeId) {
     return &graph->nodes[nodeId];
 }
 
-// Find node by name (case-insensitive partial match)
+// Find node by name (case-insensitive; exact match first, then the
+// lowest ID whose name contains it)
 int graph_find_node_by_name(const Graph* graph, const char* name) {
     if (!graph || !name) return -1;
     
-    // First try exact match
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (graph->nodes[i].active) {
-            #ifdef _WIN32
-            if (_stricmp(graph->nodes[i].name, name) == 0) return i;
-            #else
-            if (strcasecmp(graph->nodes[i].name, name) == 0) return i;
-            #endif
-        }
-    }
-    
-    // Then try partial match
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (graph->nodes[i].active) {
-            #ifdef _WIN32
-            if (strstr(graph->nodes[i].name, name) != NULL) return i;
-            #else
-            // Case-insensitive substring search
-            const char* haystack = graph->nodes[i].name;
-            size_t nameLen = strlen(name);
-            size_t hayLen = strlen(haystack);
-            for (size_t j = 0; j <= hayLen - nameLen; j++) {
-                bool match = true;
-                for (size_t k = 0; k < nameLen; k++) {
-                    char c1 = haystack[j + k];
-                    char c2 = name[k];
-                    if (c1 >= 'A' && c1 <= 'Z') c1 += 32;
-                    if (c2 >= 'A' && c2 <= 'Z') c2 += 32;
-                    if (c1 != c2) { match = false; break; }
-                }
-                if (match) return i;
-            }
-            #endif
-        }
-    }
-    
-    return -1;
+    int id = name_index_find_exact(graph->nameIndex, graph, name);
+    if (id < 0) id = name_index_find_partial(graph->nameIndex, graph, name);
+    return id;
+}
+
+// Best matches for a partial name (exact, then prefix, then substring)
+int graph_find_nodes_by_name(const Graph* graph, const char* query, int* results, int maxResults) {
+    if (!graph) return 0;
+    return name_index_search(graph->nameIndex, graph, query, results, maxResults);
 }
 
-// Find node at screen position
+// Find node at screen position (closest within radius)
 int graph_find_node_at_position(const Graph* graph, float x, float y, float radius) {
     if (!graph) return -1;
-    
-    float radiusSq = radius * radius;
-    int closest = -1;
-    float closestDist = radiusSq;
-    
-    for (int i = 0; i < graph->nodeCount; i++) {
-        if (!graph->nodes[i].active) continue;
-        
-        float dx = graph->nodes[i].x - x;
-        float dy = graph->nodes[i].y - y;
-        float distSq = dx * dx + dy * dy;
-        
-        if (distSq < closestDist) {
-            closestDist = distSq;
-            closest = i;
-        }
-    }
-    
-    return closest;
+    return spatial_index_nearest(graph->spatialIndex, graph, x, y, radius);
+}
+
+// Snap an arbitrary point to the closest node, however far away
+int graph_find_nearest_node(const Graph* graph, float x, float y) {
+    if (!graph) return -1;
+    return spatial_index_nearest(graph->spatialIndex, graph, x, y, -1.0f);
+}
+
+// Nodes within radius of a point; returns the total number found
+int graph_find_nodes_in_radius(const Graph* graph, float x, float y, float radius,
+                               int* results, int maxResults) {
+    if (!graph) return 0;
+    return spatial_index_query_radius(graph->spatialIndex, graph, x, y, radius, results, maxResults);
+}
+
+// Nodes inside a rectangle (e.g. the viewport); returns the total number found
+int graph_find_nodes_in_rect(const Graph* graph, float minX, float minY, float maxX, float maxY,
+                             int* results, int maxResults) {
+    if (!graph) return 0;
+    return spatial_index_query_rect(graph->spatialIndex, graph, minX, minY, maxX, maxY,
+                                    results, maxResults);
 }
 
 // Add a directed edge
@@ -143,16 +448,28 @@ bool graph_add_edge(Graph* graph, int from, int to, float weight) {
     if (!graph) return false;
     if (from < 0 || from >= graph->nodeCount) return false;
     if (to < 0 || to >= graph->nodeCount) return false;
-    if (graph->edgeCounts[from] >= MAX_EDGES_PER_NODE) return false;
     
     // Check if edge already exists
     if (graph_has_edge(graph, from, to)) return false;
     
+    // Reserve every row first, so running out of memory leaves the graph
+    // untouched (no version bump, no edge ID without an edge)
+    if (!graph_reserve_edge(graph, from) || !graph_reserve_reverse(graph, to) ||
+        !graph_reserve_edge_id(graph)) {
+        return false;
+    }
+    
     int idx = graph->edgeCounts[from];
+    graph->version++;
+    graph->structureVersion++;
+    graph_mark_block(graph, from);
+    graph_mark_block(graph, to);  // Its reverse row
     graph->edges[from][idx].from = from;
     graph->edges[from][idx].to = to;
     graph->edges[from][idx].weight = weight;
     graph->edges[from][idx].active = true;
+    graph_register_edge(graph, from, idx);  // Cannot fail after the reserves
+    graph_link_reverse(graph, from, idx);
     graph->edgeCounts[from]++;
     
     return true;
@@ -172,6 +489,10 @@ bool graph_remove_edge(Graph* graph, int from, int to) {
     for (int i = 0; i < graph->edgeCounts[from]; i++) {
         if (graph->edges[from][i].to == to && graph->edges[from][i].active) {
             graph->edges[from][i].active = false;
+            graph->deadEdges++;
+            graph->version++;
+            graph->structureVersion++;
+            graph_mark_block(graph, from);
             return true;
         }
     }
@@ -179,6 +500,60 @@ bool graph_remove_edge(Graph* graph, int from, int to) {
     return false;
 }
 
+// Look up an edge by ID; the checks catch IDs whose edge never made it
+// into its row (a failed graph_add_edge) and whose slot was reused
+static Edge* graph_edge_by_id(const Graph* graph, int edgeId) {
+    if (!graph || edgeId < 0 || edgeId >= graph->edgeIdCount) return NULL;
+    
+    const EdgeRef* ref = &graph->edgeIndex[edgeId];
+    if (ref->slot >= graph->edgeCounts[ref->from]) return NULL;
+    
+    Edge* edge = &graph->edges[ref->from][ref->slot];
+    if (edge->id != edgeId || !edge->active) return NULL;
+    return edge;
+}
+
+// ID of the active edge from -> to
+int graph_find_edge(const Graph* graph, int from, int to) {
+    if (!graph || from < 0 || from >= graph->nodeCount) return -1;
+    
+    for (int i = 0; i < graph->edgeCounts[from]; i++) {
+        if (graph->edges[from][i].to == to && graph->edges[from][i].active) {
+            return graph->edges[from][i].id;
+        }
+    }
+    
+    return -1;
+}
+
+const Edge* graph_get_edge(const Graph* graph, int edgeId) {
+    return graph_edge_by_id(graph, edgeId);
+}
+
+// Change a weight in place
+bool graph_set_edge_weight(Graph* graph, int edgeId, float weight) {
+    if (!(weight >= 0.0f)) return false;  // Also rejects NaN
+    
+    Edge* edge = graph_edge_by_id(graph, edgeId);
+    if (!edge) return false;
+    edge->weight = weight;
+    graph->version++;
+    graph_mark_block(graph, edge->from);
+    return true;
+}
+
+// Apply a batch of weight changes (e.g. one traffic feed tick); updates
+// for removed edges or with invalid weights are skipped
+int graph_apply_weight_updates(Graph* graph, const EdgeWeightUpdate* updates, int count) {
+    if (!graph || !updates) return 0;
+    
+    int applied = 0;
+    for (int i = 0; i < count; i++) {
+        if (graph_set_edge_weight(graph, updates[i].edgeId, updates[i].weight)) applied++;
+    }
+    return applied;
+}
+
 // Get edge weight
 float graph_get_edge_weight(const Graph* graph, int from, int to) {
     if (!graph || from < 0 || from >= graph->nodeCount) return -1.0f;
@@ -230,6 +605,238 @@ int graph_get_neighbors(const Graph* graph, int nodeId, int* neighbors, int maxN
     return count;
 }
 
+static bool graph_csr_build_reverse(GraphCSR* csr);
+
+// Count the inactive nodes and edge slots of a freshly loaded graph
+static void graph_count_tombstones(Graph* graph) {
+    graph->deadNodes = 0;
+    graph->deadEdges = 0;
+    for (int i = 0; i < graph->nodeCount; i++) {
+        if (!graph->nodes[i].active) graph->deadNodes++;
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            if (!graph->edges[i][j].active) graph->deadEdges++;
+        }
+    }
+}
+
+// Rebuild the graph without tombstones
+// The compacted graph is assembled next to the old one and only swapped in
+// once complete, so on failure the graph is left as it was.
+bool graph_compact(Graph* graph, int* nodeMap, int* edgeMap) {
+    if (!graph) return false;
+    
+    int oldCount = graph->nodeCount;
+    int* remap = nodeMap ? nodeMap : (int*)malloc((oldCount > 0 ? oldCount : 1) * sizeof(int));
+    if (!remap) return false;
+        
+    int liveNodes = 0;
+    int liveEdges = 0;
+    for (int i = 0; i < oldCount; i++) {
+        remap[i] = graph->nodes[i].active ? liveNodes++ : -1;
+    }
+    for (int i = 0; i < graph->edgeIdCount && edgeMap; i++) {
+        edgeMap[i] = -1;
+    }
+    
+    Graph compact;
+    graph_init(&compact);
+    bool ok = graph_reserve(&compact, liveNodes > 0 ? liveNodes : GRAPH_INITIAL_NODE_CAPACITY);
+    
+    // Nodes, with rows sized to their surviving edges
+    for (int i = 0; i < oldCount && ok; i++) {
+        if (remap[i] < 0) continue;
+    
+        int id = compact.nodeCount++;
+        compact.nodes[id] = graph->nodes[i];
+        compact.nodes[id].id = id;
+        graph_sync_node(&compact, id);
+        compact.edgeCounts[id] = 0;
+        compact.edgeCapacities[id] = 0;
+        compact.inEdges[id] = NULL;
+        compact.inEdgeCounts[id] = 0;
+        compact.inEdgeCapacities[id] = 0;
+    
+        int live = 0;
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            const Edge* edge = &graph->edges[i][j];
+            if (edge->active && remap[edge->to] >= 0) live++;
+        }
+        liveEdges += live;
+        compact.edges[id] = live > 0 ? (Edge*)malloc(live * sizeof(Edge)) : NULL;
+        ok = live == 0 || compact.edges[id] != NULL;
+        if (ok) compact.edgeCapacities[id] = live;
+    }
+    
+    if (ok && liveEdges > 0) {
+        compact.edgeIndex = (EdgeRef*)malloc(liveEdges * sizeof(EdgeRef));
+        ok = compact.edgeIndex != NULL;
+        if (ok) compact.edgeIdCapacity = liveEdges;
+    }
+    
+    // Edges keep their order within each row and get dense IDs
+    for (int i = 0; i < oldCount && ok; i++) {
+        int from = remap[i];
+        if (from < 0) continue;
+    
+        for (int j = 0; j < graph->edgeCounts[i] && ok; j++) {
+            const Edge* old = &graph->edges[i][j];
+            if (!old->active || remap[old->to] < 0) continue;
+    
+            int slot = compact.edgeCounts[from];
+            Edge* edge = &compact.edges[from][slot];
+            edge->from = from;
+            edge->to = remap[old->to];
+            edge->weight = old->weight;
+            edge->active = true;
+            ok = graph_register_edge(&compact, from, slot) && graph_link_reverse(&compact, from, slot);
+            if (!ok) break;
+            compact.edgeCounts[from]++;
+            if (edgeMap) edgeMap[old->id] = edge->id;
+        }
+    }
+    
+    if (ok) {
+        // The names stay where they are; hand the arena over
+        compact.names = graph->names;
+        graph->names.head = NULL;
+        graph->names.bytes = 0;
+        
+        graph_rebuild_name_index(&compact);
+        graph_rebuild_spatial_index(&compact);
+        graph_free(graph);  // Bumps the version
+        compact.version = graph->version;
+        compact.structureVersion = graph->structureVersion;
+        graph_mark_all_blocks(&compact);
+        *graph = compact;
+    } else {
+        graph_free(&compact);
+    }
+    
+    if (remap != nodeMap) free(remap);
+    return ok;
+}
+
+// Whether tombstones make up more than GRAPH_COMPACT_DEAD_FRACTION of the
+// node and edge slots
+bool graph_needs_compaction(const Graph* graph) {
+    if (!graph) return false;
+    
+    int dead = graph->deadNodes + graph->deadEdges;
+    int total = graph->nodeCount + graph->edgeIdCount;
+    return dead >= GRAPH_COMPACT_MIN_DEAD && dead > total * GRAPH_COMPACT_DEAD_FRACTION;
+}
+
+bool graph_maybe_compact(Graph* graph, int* nodeMap, int* edgeMap) {
+    return graph_needs_compaction(graph) && graph_compact(graph, nodeMap, edgeMap);
+}
+
+// Build a compact CSR snapshot of the active part of the graph
+bool graph_freeze(const Graph* graph, GraphCSR* csr) {
+    if (!graph || !csr) return false;
+    
+    memset(csr, 0, sizeof(*csr));
+    int nodeCount = graph->nodeCount;
+    
+    // Count surviving edges per row
+    int edgeCount = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        if (!graph->nodes[i].active) continue;
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            const Edge* edge = &graph->edges[i][j];
+            if (edge->active && graph->nodes[edge->to].active) edgeCount++;
+        }
+    }
+    
+    csr->offsets = (int*)malloc((nodeCount + 1) * sizeof(int));
+    csr->to = (int*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+    csr->weight = (float*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(float));
+    csr->x = (float*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(float));
+    csr->y = (float*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(float));
+    if (!csr->offsets || !csr->to || !csr->weight || !csr->x || !csr->y) {
+        graph_csr_free(csr);
+        return false;
+    }
+    
+    // Fill rows in node order
+    int e = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        csr->offsets[i] = e;
+        csr->x[i] = graph->nodeX[i];
+        csr->y[i] = graph->nodeY[i];
+        if (!GRAPH_NODE_ACTIVE(graph, i)) continue;
+        
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            const Edge* edge = &graph->edges[i][j];
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, edge->to)) continue;
+            csr->to[e] = edge->to;
+            csr->weight[e] = edge->weight;
+            e++;
+        }
+    }
+    csr->offsets[nodeCount] = e;
+    
+    csr->nodeCount = nodeCount;
+    csr->edgeCount = edgeCount;
+    
+    if (!graph_csr_build_reverse(csr)) {
+        graph_csr_free(csr);
+        return false;
+    }
+    return true;
+}
+
+// Transpose the forward rows into the reverse CSR (counting sort by target)
+static bool graph_csr_build_reverse(GraphCSR* csr) {
+    int nodeCount = csr->nodeCount;
+    int edgeCount = csr->edgeCount;
+    
+    csr->inOffsets = (int*)calloc(nodeCount + 1, sizeof(int));
+    csr->inFrom = (int*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+    csr->inWeight = (float*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(float));
+    if (!csr->inOffsets || !csr->inFrom || !csr->inWeight) return false;
+    
+    // Count in-degrees, then turn them into row starts
+    for (int e = 0; e < edgeCount; e++) {
+        csr->inOffsets[csr->to[e] + 1]++;
+    }
+    for (int i = 0; i < nodeCount; i++) {
+        csr->inOffsets[i + 1] += csr->inOffsets[i];
+    }
+    
+    // Scatter; inOffsets[v] is used as the insertion cursor and restored after
+    for (int u = 0; u < nodeCount; u++) {
+        for (int e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int slot = csr->inOffsets[csr->to[e]]++;
+            csr->inFrom[slot] = u;
+            csr->inWeight[slot] = csr->weight[e];
+        }
+    }
+    for (int i = nodeCount; i > 0; i--) {
+        csr->inOffsets[i] = csr->inOffsets[i - 1];
+    }
+    csr->inOffsets[0] = 0;
+    return true;
+}
+
+void graph_csr_free(GraphCSR* csr) {
+    if (!csr) return;
+    free(csr->offsets);
+    free(csr->to);
+    free(csr->weight);
+    free(csr->x);
+    free(csr->y);
+    free(csr->inOffsets);
+    free(csr->inFrom);
+    free(csr->inWeight);
+    memset(csr, 0, sizeof(*csr));
+}
+
+// Size of the edge-count table in an RCGRAPH1 file. Files written before
+// the graph became growable always stored RCGRAPH1_EDGE_TABLE entries.
+static int rcgraph1_edge_table_size(int nodeCount) {
+    return nodeCount > RCGRAPH1_EDGE_TABLE ? nodeCount : RCGRAPH1_EDGE_TABLE;
+}
+
 // Save graph to file
 bool graph_save(const Graph* graph, const char* filename) {
     if (!graph || !filename) return false;
@@ -244,18 +851,24 @@ bool graph_save(const Graph* graph, const char* filename) {
     // Write node count
     fwrite(&graph->nodeCount, sizeof(int), 1, file);
     
-    // Write nodes
+    // Write nodes (names zero-padded to MAX_NAME_LENGTH)
     for (int i = 0; i < graph->nodeCount; i++) {
         const Node* node = &graph->nodes[i];
+        char name[MAX_NAME_LENGTH] = {0};
+        strncpy(name, node->name, MAX_NAME_LENGTH - 1);
         fwrite(&node->id, sizeof(int), 1, file);
-        fwrite(node->name, sizeof(char), MAX_NAME_LENGTH, file);
+        fwrite(name, sizeof(char), MAX_NAME_LENGTH, file);
         fwrite(&node->x, sizeof(float), 1, file);
         fwrite(&node->y, sizeof(float), 1, file);
         fwrite(&node->active, sizeof(bool), 1, file);
     }
     
-    // Write edge counts
-    fwrite(graph->edgeCounts, sizeof(int), MAX_NODES, file);
+    // Write edge counts (zero-padded to the table size)
+    int tableSize = rcgraph1_edge_table_size(graph->nodeCount);
+    for (int i = 0; i < tableSize; i++) {
+        int count = i < graph->nodeCount ? graph->edgeCounts[i] : 0;
+        fwrite(&count, sizeof(int), 1, file);
+    }
     
     // Write edges
     for (int i = 0; i < graph->nodeCount; i++) {
@@ -268,11 +881,13 @@ bool graph_save(const Graph* graph, const char* filename) {
         }
     }
     
-    fclose(file);
-    return true;
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    return ok;
 }
 
 // Load graph from file
+// The graph must be initialized; its previous contents are released.
 bool graph_load(Graph* graph, const char* filename) {
     if (!graph || !filename) return false;
     
@@ -286,41 +901,93 @@ bool graph_load(Graph* graph, const char* filename) {
         return false;
     }
     
-    // Initialize graph
-    graph_init(graph);
-    
     // Read node count
-    if (fread(&graph->nodeCount, sizeof(int), 1, file) != 1) {
+    int nodeCount;
+    if (fread(&nodeCount, sizeof(int), 1, file) != 1 || nodeCount < 0) {
         fclose(file);
         return false;
     }
     
+    // Reset graph and size it from the file
+    graph_free(graph);
+    if (!graph_reserve(graph, nodeCount)) {
+        fclose(file);
+        return false;
+    }
+    graph->nodeCount = nodeCount;
+    for (int i = 0; i < nodeCount; i++) {
+        graph->edges[i] = NULL;
+        graph->edgeCounts[i] = 0;
+        graph->edgeCapacities[i] = 0;
+        graph->inEdges[i] = NULL;
+        graph->inEdgeCounts[i] = 0;
+        graph->inEdgeCapacities[i] = 0;
+    }
+    
+    bool ok = true;
+    
     // Read nodes
-    for (int i = 0; i < graph->nodeCount; i++) {
+    for (int i = 0; i < nodeCount && ok; i++) {
         Node* node = &graph->nodes[i];
-        fread(&node->id, sizeof(int), 1, file);
-        fread(node->name, sizeof(char), MAX_NAME_LENGTH, file);
-        fread(&node->x, sizeof(float), 1, file);
-        fread(&node->y, sizeof(float), 1, file);
-        fread(&node->active, sizeof(bool), 1, file);
+        char name[MAX_NAME_LENGTH];
+        ok = fread(&node->id, sizeof(int), 1, file) == 1 &&
+             fread(name, sizeof(char), MAX_NAME_LENGTH, file) == MAX_NAME_LENGTH &&
+             fread(&node->x, sizeof(float), 1, file) == 1 &&
+             fread(&node->y, sizeof(float), 1, file) == 1 &&
+             fread(&node->active, sizeof(bool), 1, file) == 1 &&
+             node->id == i;
+        name[MAX_NAME_LENGTH - 1] = '\0';
+        
+        const char* stored = ok ? string_arena_store(&graph->names, name, MAX_NAME_LENGTH) : NULL;
+        ok = stored != NULL;
+        node->name = ok ? stored : "";
+        graph_sync_node(graph, i);
     }
     
-    // Read edge counts
-    fread(graph->edgeCounts, sizeof(int), MAX_NODES, file);
+    // Read edge counts and allocate rows sized from the data
+    int tableSize = rcgraph1_edge_table_size(nodeCount);
+    for (int i = 0; i < tableSize && ok; i++) {
+        int count;
+        ok = fread(&count, sizeof(int), 1, file) == 1 && count >= 0;
+        if (!ok || i >= nodeCount || count == 0) continue;
+        
+        graph->edges[i] = (Edge*)malloc(count * sizeof(Edge));
+        ok = graph->edges[i] != NULL;
+        if (ok) {
+            graph->edgeCounts[i] = count;
+            graph->edgeCapacities[i] = count;
+        }
+    }
     
-    // Read edges
-    for (int i = 0; i < graph->nodeCount; i++) {
-        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+    // Read edges; each row must hold the edges of its own node, since the
+    // block tracking and the edge index trust edge->from
+    for (int i = 0; i < nodeCount && ok; i++) {
+        for (int j = 0; j < graph->edgeCounts[i] && ok; j++) {
             Edge* edge = &graph->edges[i][j];
-            fread(&edge->from, sizeof(int), 1, file);
-            fread(&edge->to, sizeof(int), 1, file);
-            fread(&edge->weight, sizeof(float), 1, file);
-            fread(&edge->active, sizeof(bool), 1, file);
+            ok = fread(&edge->from, sizeof(int), 1, file) == 1 &&
+                 fread(&edge->to, sizeof(int), 1, file) == 1 &&
+                 fread(&edge->weight, sizeof(float), 1, file) == 1 &&
+                 fread(&edge->active, sizeof(bool), 1, file) == 1 &&
+                 edge->from == i && edge->to >= 0 && edge->to < nodeCount;
+        }
+    }
+    
+    // Rebuild the reverse adjacency and number the edges in row order
+    for (int i = 0; i < nodeCount && ok; i++) {
+        for (int j = 0; j < graph->edgeCounts[i] && ok; j++) {
+            ok = graph_register_edge(graph, i, j) && graph_link_reverse(graph, i, j);
         }
     }
     
     fclose(file);
-    return true;
+    if (ok) {
+        graph_count_tombstones(graph);
+        graph_rebuild_name_index(graph);
+        graph_rebuild_spatial_index(graph);
+        graph_mark_all_blocks(graph);
+    }
+    if (!ok) graph_free(graph);
+    return ok;
 }
 
 // Path result management
@@ -330,13 +997,15 @@ PathResult path_result_create(void) {
     result.length = 0;
     result.totalCost = 0.0f;
     result.found = false;
+    result.inArena = false;
     return result;
 }
 
 void path_result_free(PathResult* result) {
     if (result && result->nodes) {
-        free(result->nodes);
+        if (!result->inArena) free(result->nodes);
         result->nodes = NULL;
         result->length = 0;
+        result->inArena = false;
     }
 }
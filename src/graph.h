@@ -17,15 +17,47 @@
 extern "C" {
 #endif
 
-// Maximum limits
-#define MAX_NODES 1000
-#define MAX_EDGES_PER_NODE 20
+// Limits
 #define MAX_NAME_LENGTH 128
+#define RCGRAPH1_EDGE_TABLE 1000  // Minimum edge-count table size in RCGRAPH1 files
+
+// Initial capacities of the growable arrays
+#define GRAPH_INITIAL_NODE_CAPACITY 16
+#define GRAPH_INITIAL_EDGE_CAPACITY 4
+
+// Nodes are grouped in blocks of 2^GRAPH_BLOCK_SHIFT consecutive IDs for
+// change tracking (the unit snapshots share, see snapshot.h)
+#define GRAPH_BLOCK_SHIFT 6
+#define GRAPH_BLOCK_NODES (1 << GRAPH_BLOCK_SHIFT)
+
+// Automatic compaction (see graph_maybe_compact)
+#define GRAPH_COMPACT_DEAD_FRACTION 0.25f
+#define GRAPH_COMPACT_MIN_DEAD 64
+
+// Name storage block (see StringArena)
+typedef struct StringBlock {
+    struct StringBlock* next;   // Older block
+    size_t size;
+    size_t used;
+    char data[];
+} StringBlock;
+
+// Append-only pool of NUL-terminated strings. Blocks are never moved or
+// reallocated, so pointers into the arena stay valid until it is freed.
+typedef struct {
+    StringBlock* head;          // Block being filled
+    size_t bytes;               // Bytes used across all blocks
+} StringArena;
+
+#define STRING_ARENA_BLOCK_SIZE 16384
 
 // Node structure representing a location
+// The search loops read coordinates and liveness from the Graph's
+// structure-of-arrays copies (nodeX, nodeY, activeBits) instead; graph.c
+// is the only writer and keeps both in sync.
 typedef struct {
     int id;
-    char name[MAX_NAME_LENGTH];
+    const char* name;  // In the graph's name arena (at most MAX_NAME_LENGTH - 1 chars)
     float x;  // Screen/map x coordinate
     float y;  // Screen/map y coordinate
     bool active;
@@ -37,36 +69,148 @@ typedef struct {
     int to;
     float weight;  // Distance/cost
     bool active;
+    int id;        // Stable edge ID (see graph_find_edge)
 } Edge;
 
+// Reverse adjacency entry: the incoming edge is edges[from][slot]
+typedef struct {
+    int from;
+    int slot;
+} EdgeRef;
+
+// New weight for the edge with ID edgeId (see graph_apply_weight_updates)
+typedef struct {
+    int edgeId;
+    float weight;
+} EdgeWeightUpdate;
+
+typedef struct NameIndex NameIndex;        // See nameindex.h
+typedef struct SpatialIndex SpatialIndex;  // See spatial.h
+
 // Graph structure
+// All storage is heap-owned and grows on demand; a zero-initialized Graph
+// is a valid empty graph. Pointers into nodes/edges are invalidated by
+// any call that adds nodes or edges.
 typedef struct {
-    Node nodes[MAX_NODES];
+    Node* nodes;
     int nodeCount;
+    int nodeCapacity;
+    
+    // Hot per-node data as dense arrays indexed by node ID, so a search
+    // loads 8 bytes of coordinates per node rather than a whole Node
+    float* nodeX;
+    float* nodeY;
+    unsigned int* activeBits;   // Bit (id % 32) of word (id / 32); see GRAPH_NODE_ACTIVE
+    
+    // Storage for node names
+    StringArena names;
+    
+    // Adjacency list representation (one growable row per node)
+    Edge** edges;
+    int* edgeCounts;
+    int* edgeCapacities;
+    
+    // Reverse adjacency: incoming edges of each node. Entries are never
+    // removed; check the referenced edge's active flag.
+    EdgeRef** inEdges;
+    int* inEdgeCounts;
+    int* inEdgeCapacities;
     
-    // Adjacency list representation
-    Edge edges[MAX_NODES][MAX_EDGES_PER_NODE];
-    int edgeCounts[MAX_NODES];
+    // Edge ID -> location of the edge. IDs are handed out in creation
+    // order and never reused, so an ID keeps naming the same edge (or
+    // reports it removed) until the graph is reloaded or compacted.
+    EdgeRef* edgeIndex;
+    int edgeIdCount;
+    int edgeIdCapacity;
+    
+    // Inactive nodes and edges still taking up slots (removed since the
+    // last graph_compact or found in the loaded file)
+    int deadNodes;
+    int deadEdges;
+    
+    // Bumped by every graph_* call that changes the nodes, edges or
+    // weights (including load, compact and free), so caches can tell
+    // whether their results still apply. Code that writes Node or Edge
+    // fields directly must call graph_touch.
+    unsigned int version;
+    
+    // Bumped alongside version by the calls that add or remove nodes or
+    // edges (and by load, compact, free and graph_touch), but not by
+    // weight changes, so structures built for the topology can tell a
+    // reweighted graph from a different one
+    unsigned int structureVersion;
+    
+    // Unique per graph instance: set by graph_init (and so by graph_free,
+    // graph_load and graph_compact), never 0 for an initialized graph.
+    // Versions only order the states of one instance; this tells instances
+    // apart, even at the same address.
+    unsigned int instanceId;
+    
+    // Version of the last change to each block of nodes: their records,
+    // out-edges or reverse rows (entry i covers IDs i << GRAPH_BLOCK_SHIFT
+    // onwards). Changes later than version V are in blocks marked above V.
+    unsigned int* blockVersions;
+    
+    // Name lookup index, maintained by graph_add_node / graph_remove_node
+    // (NULL if it could not be allocated; lookups then scan)
+    NameIndex* nameIndex;
+    
+    // Grid over node positions, maintained the same way
+    SpatialIndex* spatialIndex;
 } Graph;
 
+// Liveness of a valid node ID, read from the bitset
+#define GRAPH_NODE_ACTIVE(graph, nodeId) \
+    (((graph)->activeBits[(nodeId) >> 5] >> ((nodeId) & 31)) & 1u)
+
+// Frozen, read-only compressed sparse row (CSR) view of a graph.
+// Node IDs match the source graph; inactive nodes keep their ID but have
+// empty rows, and edges that are inactive or touch an inactive node are
+// dropped. The out-edges of node i are [offsets[i], offsets[i + 1]).
+typedef struct {
+    int nodeCount;
+    int edgeCount;
+    int* offsets;       // nodeCount + 1 row offsets into to/weight
+    int* to;            // Target node of each edge
+    float* weight;      // Weight of each edge
+    float* x;           // Node coordinates, indexed by node ID
+    float* y;
+    
+    // Reverse CSR: the in-edges of node i are [inOffsets[i], inOffsets[i + 1])
+    int* inOffsets;
+    int* inFrom;        // Source node of each incoming edge
+    float* inWeight;
+} GraphCSR;
+
 // Path result from A* algorithm
 typedef struct {
     int* nodes;         // Array of node IDs in the path
     int length;         // Number of nodes in path
     float totalCost;    // Total distance
     bool found;         // Whether a path was found
+    bool inArena;       // nodes belongs to a PathArena (path_result_free keeps it)
 } PathResult;
 
 // Graph lifecycle
+// graph_init expects an uninitialized or freed graph; use graph_free to
+// release (and reset) a graph that already holds data.
 void graph_init(Graph* graph);
 void graph_free(Graph* graph);
+bool graph_reserve(Graph* graph, int nodeCapacity);
+void graph_touch(Graph* graph);  // Bump the version after editing fields in place
 
 // Node operations
 int graph_add_node(Graph* graph, const char* name, float x, float y);
 bool graph_remove_node(Graph* graph, int nodeId);
 Node* graph_get_node(Graph* graph, int nodeId);
 int graph_find_node_by_name(const Graph* graph, const char* name);
+int graph_find_nodes_by_name(const Graph* graph, const char* query, int* results, int maxResults);
 int graph_find_node_at_position(const Graph* graph, float x, float y, float radius);
+int graph_find_nearest_node(const Graph* graph, float x, float y);
+int graph_find_nodes_in_radius(const Graph* graph, float x, float y, float radius,
+                               int* results, int maxResults);
+int graph_find_nodes_in_rect(const Graph* graph, float minX, float minY, float maxX, float maxY,
+                             int* results, int maxResults);
 
 // Edge operations
 bool graph_add_edge(Graph* graph, int from, int to, float weight);
@@ -75,6 +219,32 @@ bool graph_remove_edge(Graph* graph, int from, int to);
 float graph_get_edge_weight(const Graph* graph, int from, int to);
 bool graph_has_edge(const Graph* graph, int from, int to);
 
+// Edges by stable ID (the last edge added has ID edgeIdCount - 1)
+// All of these are O(1) and never touch the adjacency structure.
+int graph_find_edge(const Graph* graph, int from, int to);         // Edge ID, or -1
+const Edge* graph_get_edge(const Graph* graph, int edgeId);         // NULL if removed
+bool graph_set_edge_weight(Graph* graph, int edgeId, float weight); // false if removed or weight < 0
+int graph_apply_weight_updates(Graph* graph, const EdgeWeightUpdate* updates, int count);  // Number applied
+
+/**
+ * Drop inactive nodes and edges and renumber the rest densely
+ *
+ * Surviving nodes and edges keep their relative order. Every node and
+ * edge ID held outside the graph is invalidated: translate them with the
+ * maps, and rebuild snapshots, landmark tables and planners.
+ *
+ * @param nodeMap   Output, old node ID -> new ID or -1 (nodeCount entries, can be NULL)
+ * @param edgeMap   Output, old edge ID -> new ID or -1 (edgeIdCount entries, can be NULL)
+ * @return          false on allocation failure (the graph is unchanged)
+ */
+bool graph_compact(Graph* graph, int* nodeMap, int* edgeMap);
+bool graph_needs_compaction(const Graph* graph);
+bool graph_maybe_compact(Graph* graph, int* nodeMap, int* edgeMap);  // true if it compacted
+
+// Frozen snapshots (the CSR does not track later edits to the graph)
+bool graph_freeze(const Graph* graph, GraphCSR* csr);
+void graph_csr_free(GraphCSR* csr);
+
 // Serialization
 bool graph_save(const Graph* graph, const char* filename);
 bool graph_load(Graph* graph, const char* filename);
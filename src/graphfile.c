@@ -0,0 +1,336 @@
+/**
+ * graphfile.c - RCGRAPH2 writer and memory-mapped reader
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // mmap, fstat
+#endif
+
+#include "graphfile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+_Static_assert(sizeof(RCG2Header) <= RCGRAPH2_HEADER_SIZE, "RCGRAPH2 header too large");
+
+#define CHECKSUM_SEED 0xcbf29ce484222325ull
+#define CHECKSUM_PRIME 0x100000001b3ull
+
+// Word-wise FNV-style hash; data is consumed as zero-padded 64-bit words
+static uint64_t checksum_update(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t words = size / 8;
+    for (size_t i = 0; i < words; i++) {
+        uint64_t word;
+        memcpy(&word, bytes + i * 8, 8);
+        hash = (hash ^ word) * CHECKSUM_PRIME;
+    }
+    if (size % 8) {
+        uint64_t word = 0;
+        memcpy(&word, bytes + words * 8, size % 8);
+        hash = (hash ^ word) * CHECKSUM_PRIME;
+    }
+    return hash;
+}
+
+static uint64_t align_up(uint64_t value) {
+    return (value + RCGRAPH2_ALIGNMENT - 1) & ~(uint64_t)(RCGRAPH2_ALIGNMENT - 1);
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+// Write one section plus zero padding up to the next aligned offset,
+// folding both into the checksum
+static bool write_section(FILE* file, RCG2Header* header, RCG2SectionId id,
+                          const void* data, size_t size, uint64_t* offset, uint64_t* hash) {
+    static const unsigned char zeros[RCGRAPH2_ALIGNMENT] = {0};
+    
+    header->sections[id].offset = *offset;
+    header->sections[id].size = size;
+    if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+    
+    uint64_t end = align_up(*offset + size);
+    size_t padding = (size_t)(end - *offset - size);
+    if (padding > 0 && fwrite(zeros, 1, padding, file) != padding) return false;
+    
+    // The tail word of data is zero-padded, then the rest is whole zero words
+    *hash = checksum_update(*hash, data, size);
+    size_t tailPadding = size % 8 ? 8 - size % 8 : 0;
+    for (size_t i = tailPadding; i < padding; i += 8) {
+        *hash *= CHECKSUM_PRIME;  // (hash ^ 0) * prime
+    }
+    
+    *offset = end;
+    return true;
+}
+
+bool graphfile_save(const Graph* graph, const char* filename) {
+    if (!graph || !filename) return false;
+    
+    GraphCSR csr;
+    if (!graph_freeze(graph, &csr)) return false;
+    
+    int n = csr.nodeCount;
+    uint8_t* active = (uint8_t*)malloc(n > 0 ? n : 1);
+    uint32_t* nameOffsets = (uint32_t*)malloc((n + 1) * sizeof(uint32_t));
+    bool ok = active && nameOffsets;
+    
+    // Name pool: each name once, NUL-terminated, in node order
+    size_t poolSize = 0;
+    for (int i = 0; i < n && ok; i++) {
+        active[i] = graph->nodes[i].active ? 1 : 0;
+        nameOffsets[i] = (uint32_t)poolSize;
+        poolSize += strlen(graph->nodes[i].name) + 1;
+    }
+    if (ok) nameOffsets[n] = (uint32_t)poolSize;
+    
+    char* names = ok ? (char*)malloc(poolSize > 0 ? poolSize : 1) : NULL;
+    ok = ok && names;
+    for (int i = 0; i < n && ok; i++) {
+        memcpy(names + nameOffsets[i], graph->nodes[i].name, nameOffsets[i + 1] - nameOffsets[i]);
+    }
+    
+    FILE* file = ok ? fopen(filename, "wb") : NULL;
+    ok = ok && file;
+    
+    RCG2Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "RCGRAPH2", 8);
+    header.version = RCGRAPH2_VERSION;
+    header.byteOrder = RCGRAPH2_BYTE_ORDER;
+    header.nodeCount = (uint32_t)n;
+    header.edgeCount = (uint32_t)csr.edgeCount;
+    
+    // Reserve the header; it is rewritten once offsets and checksum are known
+    unsigned char headerBlock[RCGRAPH2_HEADER_SIZE] = {0};
+    ok = ok && fwrite(headerBlock, 1, RCGRAPH2_HEADER_SIZE, file) == RCGRAPH2_HEADER_SIZE;
+    
+    uint64_t offset = RCGRAPH2_HEADER_SIZE;
+    uint64_t hash = CHECKSUM_SEED;
+    size_t nodeFloats = (size_t)n * sizeof(float);
+    size_t rowInts = (size_t)(n + 1) * sizeof(int);
+    size_t edgeInts = (size_t)csr.edgeCount * sizeof(int);
+    size_t edgeFloats = (size_t)csr.edgeCount * sizeof(float);
+    
+    ok = ok &&
+         write_section(file, &header, RCG2_SECTION_X, csr.x, nodeFloats, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_Y, csr.y, nodeFloats, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_ACTIVE, active, n, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_OFFSETS, csr.offsets, rowInts, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_TO, csr.to, edgeInts, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_WEIGHT, csr.weight, edgeFloats, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_IN_OFFSETS, csr.inOffsets, rowInts, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_IN_FROM, csr.inFrom, edgeInts, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_IN_WEIGHT, csr.inWeight, edgeFloats, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_NAME_OFFSETS, nameOffsets, rowInts, &offset, &hash) &&
+         write_section(file, &header, RCG2_SECTION_NAMES, names, poolSize, &offset, &hash);
+    
+    if (ok) {
+        header.fileSize = offset;
+        header.checksum = hash;
+        memcpy(headerBlock, &header, sizeof(header));
+        ok = fseek(file, 0, SEEK_SET) == 0 &&
+             fwrite(headerBlock, 1, RCGRAPH2_HEADER_SIZE, file) == RCGRAPH2_HEADER_SIZE;
+    }
+    
+    if (file && fclose(file) != 0) ok = false;
+    free(active);
+    free(nameOffsets);
+    free(names);
+    graph_csr_free(&csr);
+    return ok;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+static bool map_file(GraphFile* file, const char* filename) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart < RCGRAPH2_HEADER_SIZE) {
+        CloseHandle(handle);
+        return false;
+    }
+    
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!base) {
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(handle);
+        return false;
+    }
+    
+    file->fileHandle = handle;
+    file->mappingHandle = mapping;
+    file->base = base;
+    file->size = (size_t)size.QuadPart;
+    return true;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < RCGRAPH2_HEADER_SIZE) {
+        close(fd);
+        return false;
+    }
+    
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file referenced
+    if (base == MAP_FAILED) return false;
+    
+    file->base = base;
+    file->size = (size_t)st.st_size;
+    return true;
+#endif
+}
+
+static void unmap_file(GraphFile* file) {
+    if (!file->base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(file->base);
+    CloseHandle((HANDLE)file->mappingHandle);
+    CloseHandle((HANDLE)file->fileHandle);
+#else
+    munmap((void*)file->base, file->size);
+#endif
+}
+
+// Section id must exist in the file with exactly the expected size
+static const void* section_at(const GraphFile* file, const RCG2Header* header,
+                              RCG2SectionId id, uint64_t expectedSize) {
+    const RCG2Section* s = &header->sections[id];
+    if (s->offset < RCGRAPH2_HEADER_SIZE || s->offset % RCGRAPH2_ALIGNMENT != 0) return NULL;
+    if (s->size != expectedSize || s->offset + s->size > file->size) return NULL;
+    return (const unsigned char*)file->base + s->offset;
+}
+
+// Full structural check of the adjacency arrays and name offsets
+static bool verify_contents(const GraphFile* file, uint64_t namesSize) {
+    const GraphCSR* csr = &file->csr;
+    for (int i = 0; i < csr->nodeCount; i++) {
+        if (csr->offsets[i] > csr->offsets[i + 1] || csr->inOffsets[i] > csr->inOffsets[i + 1]) {
+            return false;
+        }
+        if (file->nameOffsets[i] >= file->nameOffsets[i + 1]) return false;
+    }
+    for (int e = 0; e < csr->edgeCount; e++) {
+        if (csr->to[e] < 0 || csr->to[e] >= csr->nodeCount) return false;
+        if (csr->inFrom[e] < 0 || csr->inFrom[e] >= csr->nodeCount) return false;
+    }
+    return file->nameOffsets[csr->nodeCount] == namesSize;
+}
+
+bool graphfile_open(GraphFile* file, const char* filename, bool verify) {
+    if (!file || !filename) return false;
+    memset(file, 0, sizeof(*file));
+    if (!map_file(file, filename)) return false;
+    
+    RCG2Header header;
+    memcpy(&header, file->base, sizeof(header));
+    
+    bool ok = memcmp(header.magic, "RCGRAPH2", 8) == 0 &&
+              header.version == RCGRAPH2_VERSION &&
+              header.byteOrder == RCGRAPH2_BYTE_ORDER &&
+              header.fileSize == file->size &&
+              header.nodeCount <= (uint32_t)0x7FFFFFFE && header.edgeCount <= (uint32_t)0x7FFFFFFF;
+    
+    uint64_t n = header.nodeCount;
+    uint64_t m = header.edgeCount;
+    uint64_t namesSize = header.sections[RCG2_SECTION_NAMES].size;
+    GraphCSR* csr = &file->csr;
+    
+    // Section pointers (const-cast: GraphCSR is shared with the owning builders)
+    if (ok) {
+        csr->nodeCount = (int)n;
+        csr->edgeCount = (int)m;
+        csr->x = (float*)section_at(file, &header, RCG2_SECTION_X, n * sizeof(float));
+        csr->y = (float*)section_at(file, &header, RCG2_SECTION_Y, n * sizeof(float));
+        file->active = (const uint8_t*)section_at(file, &header, RCG2_SECTION_ACTIVE, n);
+        csr->offsets = (int*)section_at(file, &header, RCG2_SECTION_OFFSETS, (n + 1) * sizeof(int));
+        csr->to = (int*)section_at(file, &header, RCG2_SECTION_TO, m * sizeof(int));
+        csr->weight = (float*)section_at(file, &header, RCG2_SECTION_WEIGHT, m * sizeof(float));
+        csr->inOffsets = (int*)section_at(file, &header, RCG2_SECTION_IN_OFFSETS, (n + 1) * sizeof(int));
+        csr->inFrom = (int*)section_at(file, &header, RCG2_SECTION_IN_FROM, m * sizeof(int));
+        csr->inWeight = (float*)section_at(file, &header, RCG2_SECTION_IN_WEIGHT, m * sizeof(float));
+        file->nameOffsets = (const uint32_t*)section_at(file, &header, RCG2_SECTION_NAME_OFFSETS,
+                                                        (n + 1) * sizeof(uint32_t));
+        file->names = (const char*)section_at(file, &header, RCG2_SECTION_NAMES, namesSize);
+    
+        // Empty sections may legitimately sit at the very end of the file
+        ok = csr->x && csr->y && file->active && csr->offsets && csr->to && csr->weight &&
+             csr->inOffsets && csr->inFrom && csr->inWeight && file->nameOffsets && file->names;
+    }
+    
+    // O(1) sanity checks only. Row offsets, edge targets and reverse sources
+    // are not range-checked here, so an unverified file must be trusted: a
+    // corrupt one can make searches index past nodeCount.
+    ok = ok && csr->offsets[0] == 0 && csr->offsets[n] == (int)m &&
+         csr->inOffsets[0] == 0 && csr->inOffsets[n] == (int)m &&
+         (namesSize == 0 || file->names[namesSize - 1] == '\0');
+    
+    if (ok && verify) {
+        const unsigned char* data = (const unsigned char*)file->base + RCGRAPH2_HEADER_SIZE;
+        uint64_t hash = checksum_update(CHECKSUM_SEED, data, file->size - RCGRAPH2_HEADER_SIZE);
+        ok = hash == header.checksum && verify_contents(file, namesSize);
+    }
+    
+    if (!ok) {
+        graphfile_close(file);
+        return false;
+    }
+    return true;
+}
+
+void graphfile_close(GraphFile* file) {
+    if (!file) return;
+    unmap_file(file);
+    memset(file, 0, sizeof(*file));
+}
+
+const char* graphfile_node_name(const GraphFile* file, int nodeId) {
+    if (!file || !file->base || nodeId < 0 || nodeId >= file->csr.nodeCount) return "";
+    uint64_t namesSize = ((const RCG2Header*)file->base)->sections[RCG2_SECTION_NAMES].size;
+    uint32_t offset = file->nameOffsets[nodeId];
+    return offset < namesSize ? file->names + offset : "";
+}
+
+bool graphfile_to_graph(const GraphFile* file, Graph* graph) {
+    if (!file || !file->base || !graph) return false;
+    
+    const GraphCSR* csr = &file->csr;
+    graph_free(graph);
+    if (!graph_reserve(graph, csr->nodeCount)) return false;
+    
+    bool ok = true;
+    for (int i = 0; i < csr->nodeCount && ok; i++) {
+        ok = graph_add_node(graph, graphfile_node_name(file, i), csr->x[i], csr->y[i]) == i;
+        if (ok && !file->active[i]) graph_remove_node(graph, i);
+    }
+    for (int u = 0; u < csr->nodeCount && ok; u++) {
+        for (int e = csr->offsets[u]; e < csr->offsets[u + 1] && ok; e++) {
+            int v = csr->to[e];
+            ok = v >= 0 && v < csr->nodeCount &&
+                 (graph_add_edge(graph, u, v, csr->weight[e]) || graph_has_edge(graph, u, v));
+        }
+    }
+    
+    if (!ok) graph_free(graph);
+    return ok;
+}
@@ -0,0 +1,111 @@
+/**
+ * graphfile.h - RCGRAPH2 memory-mapped map format
+ *
+ * RCGRAPH2 stores a frozen graph exactly as the search engines use it, so
+ * loading is a single mmap with no parsing or copying:
+ *
+ * - A fixed 256-byte header: magic, version, byte-order mark, counts,
+ *   file size, checksum and an (offset, size) table of sections
+ * - One section per array, each starting on a 64-byte boundary: node
+ *   coordinates and active flags, forward and reverse CSR adjacency, name
+ *   offsets and a pool of NUL-terminated names
+ *
+ * Integers and floats are stored in native (little-endian) byte order.
+ * The checksum covers every byte after the header, read as 64-bit words.
+ *
+ * A GraphFile exposes its arrays through an ordinary GraphCSR, so
+ * astar_find_path_csr, ch_build, etc. run straight on the mapped pages.
+ * The mapping is read-only; never write through or free those pointers.
+ */
+
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include "graph.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RCGRAPH2_VERSION 1
+#define RCGRAPH2_HEADER_SIZE 256
+#define RCGRAPH2_ALIGNMENT 64
+#define RCGRAPH2_BYTE_ORDER 0x01020304u
+
+// Sections, in file order
+typedef enum {
+    RCG2_SECTION_X,              // float[nodeCount]
+    RCG2_SECTION_Y,              // float[nodeCount]
+    RCG2_SECTION_ACTIVE,         // uint8_t[nodeCount]
+    RCG2_SECTION_OFFSETS,        // int32[nodeCount + 1]
+    RCG2_SECTION_TO,             // int32[edgeCount]
+    RCG2_SECTION_WEIGHT,         // float[edgeCount]
+    RCG2_SECTION_IN_OFFSETS,     // int32[nodeCount + 1]
+    RCG2_SECTION_IN_FROM,        // int32[edgeCount]
+    RCG2_SECTION_IN_WEIGHT,      // float[edgeCount]
+    RCG2_SECTION_NAME_OFFSETS,   // uint32[nodeCount + 1] into the name pool
+    RCG2_SECTION_NAMES,          // NUL-terminated names
+    RCG2_SECTION_COUNT
+} RCG2SectionId;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t size;               // Bytes used (the section is padded after)
+} RCG2Section;
+
+// On-disk header (zero-padded to RCGRAPH2_HEADER_SIZE)
+typedef struct {
+    char magic[8];               // "RCGRAPH2"
+    uint32_t version;
+    uint32_t byteOrder;          // RCGRAPH2_BYTE_ORDER as written
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint64_t fileSize;
+    uint64_t checksum;
+    RCG2Section sections[RCG2_SECTION_COUNT];
+} RCG2Header;
+
+// An open, mapped RCGRAPH2 file
+typedef struct {
+    GraphCSR csr;                // Arrays point into the mapping
+    const uint8_t* active;
+    const uint32_t* nameOffsets;
+    const char* names;
+    
+    const void* base;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+} GraphFile;
+
+// Write a graph in RCGRAPH2 format (inactive edges are dropped)
+bool graphfile_save(const Graph* graph, const char* filename);
+
+/**
+ * Map an RCGRAPH2 file read-only
+ *
+ * The header and section table are always validated. With verify set,
+ * the checksum and every adjacency entry are checked as well; that reads
+ * the whole file, so skip it for trusted files when startup time matters.
+ * Without it, edge targets and offsets are used as stored, and a corrupt
+ * file can make searches read out of bounds.
+ *
+ * @return  false if the file is missing, malformed or fails verification
+ */
+bool graphfile_open(GraphFile* file, const char* filename, bool verify);
+void graphfile_close(GraphFile* file);
+
+// Name of a node ("" for invalid IDs)
+const char* graphfile_node_name(const GraphFile* file, int nodeId);
+
+// Copy the mapped graph into an editable Graph (previous contents released)
+bool graphfile_to_graph(const GraphFile* file, Graph* graph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GRAPHFILE_H
@@ -0,0 +1,820 @@
+/**
+ * import.c - Streaming CSV and OSM XML importer
+ */
+
+#include "import.h"
+#include "thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#define IMPORT_EARTH_RADIUS 6378137.0   // WGS84 equatorial radius in metres
+#define IMPORT_DEG_TO_RAD (3.14159265358979323846 / 180.0)
+
+#define IMPORT_ID_EMPTY LLONG_MIN       // Free slot of the ID map (never a valid ID)
+#define IMPORT_ID_UNPLACED (-2)         // Node a road uses, not read yet
+#define IMPORT_ID_INITIAL_CAPACITY 1024
+#define IMPORT_SLICE_INITIAL_RECORDS 1024
+
+// ============================================================================
+// External ID map
+// ============================================================================
+
+// Open-addressing map from external (CSV / OSM) IDs to node IDs
+typedef struct {
+    long long* keys;
+    int* values;
+    size_t capacity;         // Power of two, at most half full
+    size_t count;
+} ImportIdMap;
+
+static size_t import_id_slot(long long key, size_t mask) {
+    unsigned long long hash = (unsigned long long)key * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash ^ (hash >> 32)) & mask;
+}
+
+static bool import_id_map_init(ImportIdMap* map, size_t capacity) {
+    map->keys = (long long*)malloc(capacity * sizeof(long long));
+    map->values = (int*)malloc(capacity * sizeof(int));
+    map->capacity = capacity;
+    map->count = 0;
+    if (!map->keys || !map->values) {
+        free(map->keys);
+        free(map->values);
+        map->keys = NULL;
+        map->values = NULL;
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) map->keys[i] = IMPORT_ID_EMPTY;
+    return true;
+}
+
+static void import_id_map_free(ImportIdMap* map) {
+    free(map->keys);
+    free(map->values);
+    map->keys = NULL;
+    map->values = NULL;
+    map->capacity = 0;
+    map->count = 0;
+}
+
+// Value of key, or NULL if absent
+static int* import_id_map_find(const ImportIdMap* map, long long key) {
+    size_t mask = map->capacity - 1;
+    for (size_t i = import_id_slot(key, mask); map->keys[i] != IMPORT_ID_EMPTY; i = (i + 1) & mask) {
+        if (map->keys[i] == key) return &map->values[i];
+    }
+    return NULL;
+}
+
+static bool import_id_map_grow(ImportIdMap* map) {
+    ImportIdMap grown;
+    if (!import_id_map_init(&grown, map->capacity * 2)) return false;
+    
+    size_t mask = grown.capacity - 1;
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->keys[i] == IMPORT_ID_EMPTY) continue;
+        size_t slot = import_id_slot(map->keys[i], mask);
+        while (grown.keys[slot] != IMPORT_ID_EMPTY) slot = (slot + 1) & mask;
+        grown.keys[slot] = map->keys[i];
+        grown.values[slot] = map->values[i];
+    }
+    grown.count = map->count;
+    import_id_map_free(map);
+    *map = grown;
+    return true;
+}
+
+// Value slot of key, added with value `initial` if absent (NULL if out of
+// memory). The slot stays valid until the next insertion.
+static int* import_id_map_insert(ImportIdMap* map, long long key, int initial, bool* inserted) {
+    if ((map->count + 1) * 2 > map->capacity && !import_id_map_grow(map)) return NULL;
+    
+    size_t mask = map->capacity - 1;
+    size_t i = import_id_slot(key, mask);
+    for (; map->keys[i] != IMPORT_ID_EMPTY; i = (i + 1) & mask) {
+        if (map->keys[i] == key) {
+            *inserted = false;
+            return &map->values[i];
+        }
+    }
+    map->keys[i] = key;
+    map->values[i] = initial;
+    map->count++;
+    *inserted = true;
+    return &map->values[i];
+}
+
+// ============================================================================
+// Line parsers
+// ============================================================================
+
+typedef enum {
+    IMPORT_CSV_NODE,         // id, x, y, name
+    IMPORT_CSV_EDGE,         // id = from, ref = to, x = weight (NaN = distance), flags = oneway
+    IMPORT_OSM_NODE,         // id, x = longitude, y = latitude
+    IMPORT_OSM_WAY,          // Start of way id
+    IMPORT_OSM_ND,           // ref: next node of the current way
+    IMPORT_OSM_TAG,          // flags: IMPORT_TAG_* of the current way
+    IMPORT_OSM_WAY_END
+} ImportKind;
+
+#define IMPORT_KIND_BIT(kind) (1u << (kind))
+#define IMPORT_OSM_WAY_BITS (IMPORT_KIND_BIT(IMPORT_OSM_WAY) | IMPORT_KIND_BIT(IMPORT_OSM_ND) | \
+                             IMPORT_KIND_BIT(IMPORT_OSM_TAG) | IMPORT_KIND_BIT(IMPORT_OSM_WAY_END))
+
+#define IMPORT_TAG_ROAD 1        // highway=* (except roads yet to be built)
+#define IMPORT_TAG_ONEWAY 2      // Traffic only along the way
+#define IMPORT_TAG_REVERSE 4     // Traffic only against it (oneway=-1)
+
+// One parsed line; name points into the chunk and is valid until the next read
+typedef struct {
+    long long id;
+    long long ref;
+    double x;
+    double y;
+    const char* name;
+    int nameLength;
+    int kind;
+    int flags;               // IMPORT_TAG_* for tags, oneway (-1 = default) for CSV edges
+} ImportRecord;
+
+typedef enum {
+    IMPORT_LINE_RECORD,
+    IMPORT_LINE_IGNORED,     // No data here (header, comment, other element)
+    IMPORT_LINE_MALFORMED
+} ImportLineResult;
+
+// Parse the line [line, end) (newline stripped); only kinds in `wanted`
+// need to be produced
+typedef ImportLineResult (*ImportParser)(const char* line, const char* end, unsigned int wanted,
+                                         ImportRecord* record);
+
+// A span of a line. Lines in a chunk always end with '\n', so strtoll and
+// strtod stop inside the line even though the span is not terminated.
+typedef struct {
+    const char* begin;
+    const char* end;
+} ImportField;
+
+static bool import_is_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static void import_trim(ImportField* field) {
+    while (field->begin < field->end && import_is_space(*field->begin)) field->begin++;
+    while (field->end > field->begin && import_is_space(field->end[-1])) field->end--;
+}
+
+static bool import_field_equals(const ImportField* field, const char* text) {
+    size_t length = strlen(text);
+    return (size_t)(field->end - field->begin) == length && memcmp(field->begin, text, length) == 0;
+}
+
+static bool import_field_int(const ImportField* field, long long* value) {
+    if (field->begin == field->end) return false;
+    char* stop;
+    long long parsed = strtoll(field->begin, &stop, 10);
+    if (stop != field->end || parsed == IMPORT_ID_EMPTY) return false;
+    *value = parsed;
+    return true;
+}
+
+static bool import_field_double(const ImportField* field, double* value) {
+    if (field->begin == field->end) return false;
+    char* stop;
+    double parsed = strtod(field->begin, &stop);
+    if (stop != field->end || !isfinite(parsed)) return false;
+    *value = parsed;
+    return true;
+}
+
+// Split off the next comma-separated field; false once the line is used up
+static bool import_csv_field(const char** cursor, const char* end, ImportField* field) {
+    const char* p = *cursor;
+    if (!p) return false;
+    
+    const char* stop = p;
+    while (stop < end && *stop != ',') stop++;
+    field->begin = p;
+    field->end = stop;
+    import_trim(field);
+    *cursor = stop < end ? stop + 1 : NULL;
+    return true;
+}
+
+// `id,x,y[,name]`; the name is the rest of the line, so it may hold commas
+static ImportLineResult import_parse_csv_node(const char* line, const char* end, unsigned int wanted,
+                                              ImportRecord* record) {
+    (void)wanted;
+    const char* cursor = line;
+    ImportField field;
+    if (!import_csv_field(&cursor, end, &field) || !import_field_int(&field, &record->id)) {
+        return IMPORT_LINE_IGNORED;  // Header, comment or blank line
+    }
+    if (!import_csv_field(&cursor, end, &field) || !import_field_double(&field, &record->x) ||
+        !import_csv_field(&cursor, end, &field) || !import_field_double(&field, &record->y)) {
+        return IMPORT_LINE_MALFORMED;
+    }
+    
+    record->kind = IMPORT_CSV_NODE;
+    record->name = NULL;
+    record->nameLength = 0;
+    if (cursor) {
+        ImportField name = { cursor, end };
+        import_trim(&name);
+        if (name.end - name.begin >= 2 && *name.begin == '"' && name.end[-1] == '"') {
+            name.begin++;
+            name.end--;
+        }
+        record->name = name.begin;
+        record->nameLength = (int)(name.end - name.begin);
+    }
+    return IMPORT_LINE_RECORD;
+}
+
+// `from,to[,weight[,oneway]]`
+static ImportLineResult import_parse_csv_edge(const char* line, const char* end, unsigned int wanted,
+                                              ImportRecord* record) {
+    (void)wanted;
+    const char* cursor = line;
+    ImportField field;
+    if (!import_csv_field(&cursor, end, &field) || !import_field_int(&field, &record->id)) {
+        return IMPORT_LINE_IGNORED;
+    }
+    if (!import_csv_field(&cursor, end, &field) || !import_field_int(&field, &record->ref)) {
+        return IMPORT_LINE_MALFORMED;
+    }
+    
+    record->kind = IMPORT_CSV_EDGE;
+    record->x = NAN;
+    record->flags = -1;
+    if (import_csv_field(&cursor, end, &field) && field.begin != field.end) {
+        if (!import_field_double(&field, &record->x) || record->x < 0.0) return IMPORT_LINE_MALFORMED;
+    }
+    if (import_csv_field(&cursor, end, &field) && field.begin != field.end) {
+        if (import_field_equals(&field, "1")) record->flags = 1;
+        else if (import_field_equals(&field, "0")) record->flags = 0;
+        else return IMPORT_LINE_MALFORMED;
+    }
+    return IMPORT_LINE_RECORD;
+}
+
+// Does the element at p (just after '<') have this name?
+static bool import_xml_is(const char* p, const char* end, const char* name) {
+    size_t length = strlen(name);
+    if ((size_t)(end - p) < length || memcmp(p, name, length) != 0) return false;
+    return p + length == end || import_is_space(p[length]) || p[length] == '/' || p[length] == '>';
+}
+
+// Value of attribute `name` (single or double quoted) in [p, end)
+static bool import_xml_attr(const char* p, const char* end, const char* name, ImportField* value) {
+    size_t length = strlen(name);
+    for (const char* at = p + 1; at + length + 2 <= end; at++) {
+        if (!import_is_space(at[-1]) || memcmp(at, name, length) != 0 || at[length] != '=') continue;
+        char quote = at[length + 1];
+        if (quote != '"' && quote != '\'') continue;
+    
+        const char* begin = at + length + 2;
+        const char* close = begin;
+        while (close < end && *close != quote) close++;
+        if (close == end) return false;
+        value->begin = begin;
+        value->end = close;
+        return true;
+    }
+    return false;
+}
+
+static int import_osm_tag_flags(const ImportField* key, const ImportField* value) {
+    if (import_field_equals(key, "highway")) {
+        bool planned = import_field_equals(value, "proposed") || import_field_equals(value, "construction");
+        return planned ? 0 : IMPORT_TAG_ROAD;
+    }
+    if (import_field_equals(key, "oneway")) {
+        if (import_field_equals(value, "yes") || import_field_equals(value, "true") ||
+            import_field_equals(value, "1")) {
+            return IMPORT_TAG_ONEWAY;
+        }
+        if (import_field_equals(value, "-1") || import_field_equals(value, "reverse")) {
+            return IMPORT_TAG_REVERSE;
+        }
+        return 0;
+    }
+    if (import_field_equals(key, "junction") && import_field_equals(value, "roundabout")) {
+        return IMPORT_TAG_ONEWAY;
+    }
+    return 0;
+}
+
+static ImportLineResult import_parse_osm(const char* line, const char* end, unsigned int wanted,
+                                         ImportRecord* record) {
+    const char* p = line;
+    while (p < end && import_is_space(*p)) p++;
+    if (p == end || *p != '<') return IMPORT_LINE_IGNORED;
+    p++;
+    
+    ImportField field;
+    ImportField other;
+    if (import_xml_is(p, end, "nd")) {
+        if (!(wanted & IMPORT_KIND_BIT(IMPORT_OSM_ND))) return IMPORT_LINE_IGNORED;
+        if (!import_xml_attr(p, end, "ref", &field) || !import_field_int(&field, &record->ref)) {
+            return IMPORT_LINE_MALFORMED;
+        }
+        record->kind = IMPORT_OSM_ND;
+        return IMPORT_LINE_RECORD;
+    }
+    if (import_xml_is(p, end, "node")) {
+        if (!(wanted & IMPORT_KIND_BIT(IMPORT_OSM_NODE))) return IMPORT_LINE_IGNORED;
+        if (!import_xml_attr(p, end, "id", &field) || !import_field_int(&field, &record->id) ||
+            !import_xml_attr(p, end, "lon", &field) || !import_field_double(&field, &record->x) ||
+            !import_xml_attr(p, end, "lat", &field) || !import_field_double(&field, &record->y)) {
+            return IMPORT_LINE_MALFORMED;
+        }
+        record->kind = IMPORT_OSM_NODE;
+        return IMPORT_LINE_RECORD;
+    }
+    if (import_xml_is(p, end, "tag")) {
+        if (!(wanted & IMPORT_KIND_BIT(IMPORT_OSM_TAG))) return IMPORT_LINE_IGNORED;
+        if (!import_xml_attr(p, end, "k", &field) || !import_xml_attr(p, end, "v", &other)) {
+            return IMPORT_LINE_MALFORMED;
+        }
+        record->flags = import_osm_tag_flags(&field, &other);
+        if (!record->flags) return IMPORT_LINE_IGNORED;
+        record->kind = IMPORT_OSM_TAG;
+        return IMPORT_LINE_RECORD;
+    }
+    if (import_xml_is(p, end, "way")) {
+        if (!(wanted & IMPORT_KIND_BIT(IMPORT_OSM_WAY))) return IMPORT_LINE_IGNORED;
+        if (!import_xml_attr(p, end, "id", &field) || !import_field_int(&field, &record->id)) {
+            return IMPORT_LINE_MALFORMED;
+        }
+        record->kind = IMPORT_OSM_WAY;
+        return IMPORT_LINE_RECORD;
+    }
+    if (import_xml_is(p, end, "/way")) {
+        if (!(wanted & IMPORT_KIND_BIT(IMPORT_OSM_WAY_END))) return IMPORT_LINE_IGNORED;
+        record->kind = IMPORT_OSM_WAY_END;
+        return IMPORT_LINE_RECORD;
+    }
+    return IMPORT_LINE_IGNORED;
+}
+
+// ============================================================================
+// Chunked reading and parallel parsing
+// ============================================================================
+
+typedef struct {
+    FILE* file;
+    char* buffer;            // chunkBytes + 1, room for a final '\n'
+    size_t chunkBytes;
+    size_t length;           // Bytes in buffer
+    size_t lineBytes;        // Whole lines at the front (the current chunk)
+    bool eof;
+    unsigned long long bytesRead;
+} ImportReader;
+
+static bool import_reader_open(ImportReader* reader, const char* path, size_t chunkBytes) {
+    memset(reader, 0, sizeof(*reader));
+    reader->file = fopen(path, "rb");
+    if (!reader->file) return false;
+    reader->buffer = (char*)malloc(chunkBytes + 1);
+    if (!reader->buffer) {
+        fclose(reader->file);
+        return false;
+    }
+    reader->chunkBytes = chunkBytes;
+    return true;
+}
+
+static void import_reader_close(ImportReader* reader) {
+    if (reader->file) fclose(reader->file);
+    free(reader->buffer);
+    reader->file = NULL;
+    reader->buffer = NULL;
+}
+
+// Next chunk of whole lines, [buffer, buffer + *size). false at the end of
+// the file, or with *error set if reading fails or a line does not fit.
+static bool import_reader_next(ImportReader* reader, size_t* size, bool* error) {
+    // The partial line left after the last chunk starts the next one
+    size_t carry = reader->length - reader->lineBytes;
+    memmove(reader->buffer, reader->buffer + reader->lineBytes, carry);
+    reader->length = carry;
+    reader->lineBytes = 0;
+    
+    if (!reader->eof) {
+        size_t want = reader->chunkBytes - carry;
+        size_t got = fread(reader->buffer + carry, 1, want, reader->file);
+        reader->length += got;
+        reader->bytesRead += got;
+        if (got < want) {
+            if (ferror(reader->file)) {
+                *error = true;
+                return false;
+            }
+            reader->eof = true;
+        }
+    }
+    if (reader->length == 0) return false;
+    
+    size_t cut = reader->length;
+    while (cut > 0 && reader->buffer[cut - 1] != '\n') cut--;
+    if (reader->eof && cut < reader->length) {
+        // Last line without a newline
+        reader->buffer[reader->length++] = '\n';
+        cut = reader->length;
+    } else if (cut == 0) {
+        *error = true;  // Longer than a chunk
+        return false;
+    }
+    reader->lineBytes = cut;
+    *size = cut;
+    return true;
+}
+
+// Whole lines of a chunk parsed by one worker
+typedef struct {
+    const char* begin;
+    const char* end;
+    ImportParser parser;
+    unsigned int wanted;
+    ImportRecord* records;
+    int count;
+    int capacity;
+    int malformed;
+    bool failed;             // Out of memory
+    Thread thread;
+    bool started;
+} ImportSlice;
+
+static void import_parse_slice(void* arg) {
+    ImportSlice* slice = (ImportSlice*)arg;
+    slice->count = 0;
+    slice->malformed = 0;
+    slice->failed = false;
+    
+    const char* line = slice->begin;
+    while (line < slice->end) {
+        const char* newline = (const char*)memchr(line, '\n', (size_t)(slice->end - line));
+        const char* end = newline;
+        if (end > line && end[-1] == '\r') end--;
+    
+        if (slice->count == slice->capacity) {
+            int capacity = slice->capacity > 0 ? slice->capacity * 2 : IMPORT_SLICE_INITIAL_RECORDS;
+            ImportRecord* records = (ImportRecord*)realloc(slice->records, capacity * sizeof(ImportRecord));
+            if (!records) {
+                slice->failed = true;
+                return;
+            }
+            slice->records = records;
+            slice->capacity = capacity;
+        }
+    
+        ImportLineResult parsed = slice->parser(line, end, slice->wanted, &slice->records[slice->count]);
+        if (parsed == IMPORT_LINE_RECORD) slice->count++;
+        else if (parsed == IMPORT_LINE_MALFORMED) slice->malformed++;
+        line = newline + 1;
+    }
+}
+
+// ============================================================================
+// Building the graph
+// ============================================================================
+
+typedef struct ImportState ImportState;
+typedef bool (*ImportApply)(ImportState* state, const ImportRecord* record);
+
+struct ImportState {
+    Graph* graph;
+    ImportOptions options;
+    ImportStats* stats;
+    ImportIdMap ids;
+    
+    ImportSlice* slices;
+    int sliceCount;
+    
+    // Projection, fixed by the first geographic node
+    bool originSet;
+    double originLat;
+    double originLon;
+    double cosLat;
+    
+    // OSM way being read
+    long long* refs;
+    int refCount;
+    int refCapacity;
+    int wayFlags;
+    bool inWay;
+    bool collecting;         // First OSM pass: only record the nodes roads use
+                             // (its malformed lines are counted in the second)
+};
+
+// Parse one chunk across the workers, then apply its records in file order
+static bool import_run_chunk(ImportState* state, const char* chunk, size_t size,
+                             ImportParser parser, unsigned int wanted, ImportApply apply) {
+    int jobs = (int)(size / IMPORT_MIN_SLICE) + 1;
+    int workers = thread_worker_count(state->options.threadCount, jobs);
+    if (workers > state->sliceCount) workers = state->sliceCount;
+    
+    // Cut into even slices, each moved forward to just after a newline
+    const char* chunkEnd = chunk + size;
+    const char* begin = chunk;
+    for (int w = 0; w < workers; w++) {
+        const char* end = w == workers - 1 ? chunkEnd : chunk + size * (size_t)(w + 1) / (size_t)workers;
+        if (end < begin) end = begin;
+        while (end > begin && end < chunkEnd && end[-1] != '\n') end++;
+    
+        ImportSlice* slice = &state->slices[w];
+        slice->begin = begin;
+        slice->end = end;
+        slice->parser = parser;
+        slice->wanted = wanted;
+        begin = end;
+    }
+    
+    // The calling thread parses slice 0, and any slice whose thread did not start
+    for (int w = 1; w < workers; w++) {
+        ImportSlice* slice = &state->slices[w];
+        slice->started = thread_start(&slice->thread, import_parse_slice, slice);
+    }
+    import_parse_slice(&state->slices[0]);
+    for (int w = 1; w < workers; w++) {
+        ImportSlice* slice = &state->slices[w];
+        if (slice->started) thread_join(&slice->thread);
+        else import_parse_slice(slice);
+    }
+    
+    for (int w = 0; w < workers; w++) {
+        const ImportSlice* slice = &state->slices[w];
+        if (slice->failed) return false;
+        if (!state->collecting) state->stats->malformedLines += slice->malformed;
+        for (int i = 0; i < slice->count; i++) {
+            if (!apply(state, &slice->records[i])) return false;
+        }
+    }
+    state->stats->chunks++;
+    return true;
+}
+
+static bool import_run_file(ImportState* state, const char* path,
+                            ImportParser parser, unsigned int wanted, ImportApply apply) {
+    ImportReader reader;
+    if (!import_reader_open(&reader, path, state->options.chunkBytes)) return false;
+    
+    bool error = false;
+    size_t size;
+    while (import_reader_next(&reader, &size, &error)) {
+        if (!import_run_chunk(state, reader.buffer, size, parser, wanted, apply)) {
+            error = true;
+            break;
+        }
+    }
+    state->stats->bytesRead += reader.bytesRead;
+    import_reader_close(&reader);
+    return !error;
+}
+
+// Equirectangular projection around the origin, in metres times the scale
+static void import_project(ImportState* state, double lon, double lat, float* x, float* y) {
+    if (!state->originSet) {
+        state->originLat = isnan(state->options.originLat) ? lat : state->options.originLat;
+        state->originLon = isnan(state->options.originLon) ? lon : state->options.originLon;
+        state->cosLat = cos(state->originLat * IMPORT_DEG_TO_RAD);
+        state->originSet = true;
+    }
+    double unitsPerDegree = IMPORT_EARTH_RADIUS * IMPORT_DEG_TO_RAD * state->options.scale;
+    *x = (float)((lon - state->originLon) * state->cosLat * unitsPerDegree);
+    *y = (float)((state->originLat - lat) * unitsPerDegree);
+}
+
+// Add the node of external ID id and store its node ID in slot
+static bool import_add_node(ImportState* state, int* slot, long long id, float x, float y,
+                            const char* name, int nameLength) {
+    char buffer[MAX_NAME_LENGTH];
+    if (name && nameLength > 0) {
+        int length = nameLength < MAX_NAME_LENGTH - 1 ? nameLength : MAX_NAME_LENGTH - 1;
+        memcpy(buffer, name, length);
+        buffer[length] = '\0';
+    } else {
+        snprintf(buffer, sizeof(buffer), "%lld", id);
+    }
+    
+    int nodeId = graph_add_node(state->graph, buffer, x, y);
+    if (nodeId < 0) return false;
+    *slot = nodeId;
+    state->stats->nodes++;
+    return true;
+}
+
+static bool import_add_edge(ImportState* state, int from, int to, float weight) {
+    if (from == to) return true;
+    if (graph_has_edge(state->graph, from, to)) {
+        state->stats->duplicateEdges++;
+        return true;
+    }
+    if (!graph_add_edge(state->graph, from, to, weight)) return false;
+    state->stats->edges++;
+    return true;
+}
+
+// Road between two nodes (a negative weight means the distance)
+static bool import_add_road(ImportState* state, int from, int to, float weight, bool oneway) {
+    if (weight < 0.0f) {
+        weight = graph_calculate_distance(&state->graph->nodes[from], &state->graph->nodes[to]);
+    }
+    return import_add_edge(state, from, to, weight) && (oneway || import_add_edge(state, to, from, weight));
+}
+
+static bool import_apply_csv_node(ImportState* state, const ImportRecord* record) {
+    bool inserted;
+    int* slot = import_id_map_insert(&state->ids, record->id, -1, &inserted);
+    if (!slot) return false;
+    if (!inserted) {
+        state->stats->duplicateNodes++;
+        return true;
+    }
+    
+    float x = (float)record->x;
+    float y = (float)record->y;
+    if (state->options.geographic) import_project(state, record->x, record->y, &x, &y);
+    return import_add_node(state, slot, record->id, x, y, record->name, record->nameLength);
+}
+
+static bool import_apply_csv_edge(ImportState* state, const ImportRecord* record) {
+    const int* from = import_id_map_find(&state->ids, record->id);
+    const int* to = import_id_map_find(&state->ids, record->ref);
+    if (!from || !to) {
+        state->stats->missingNodes++;
+        return true;
+    }
+    float weight = isnan(record->x) ? -1.0f : (float)record->x;
+    bool oneway = record->flags < 0 ? state->options.directed : record->flags != 0;
+    return import_add_road(state, *from, *to, weight, oneway);
+}
+
+static bool import_finish_way(ImportState* state) {
+    state->inWay = false;
+    if (!(state->wayFlags & IMPORT_TAG_ROAD)) return true;
+    
+    if (state->collecting) {
+        for (int i = 0; i < state->refCount; i++) {
+            bool inserted;
+            if (!import_id_map_insert(&state->ids, state->refs[i], IMPORT_ID_UNPLACED, &inserted)) return false;
+        }
+        return true;
+    }
+    
+    bool reverse = (state->wayFlags & IMPORT_TAG_REVERSE) != 0;
+    bool oneway = reverse || (state->wayFlags & IMPORT_TAG_ONEWAY) != 0;
+    state->stats->ways++;
+    
+    // A reference outside the extract breaks the chain
+    int previous = -1;
+    for (int i = 0; i < state->refCount; i++) {
+        const int* slot = import_id_map_find(&state->ids, state->refs[i]);
+        int node = slot ? *slot : -1;
+        if (node < 0) {
+            state->stats->missingNodes++;
+            previous = -1;
+            continue;
+        }
+        if (previous >= 0) {
+            bool ok = reverse ? import_add_road(state, node, previous, -1.0f, oneway)
+                              : import_add_road(state, previous, node, -1.0f, oneway);
+            if (!ok) return false;
+        }
+        previous = node;
+    }
+    return true;
+}
+
+static bool import_apply_osm(ImportState* state, const ImportRecord* record) {
+    switch (record->kind) {
+        case IMPORT_OSM_NODE: {
+            int* slot = import_id_map_find(&state->ids, record->id);
+            if (!slot) return true;  // Not on a road
+            if (*slot != IMPORT_ID_UNPLACED) {
+                state->stats->duplicateNodes++;
+                return true;
+            }
+            float x, y;
+            import_project(state, record->x, record->y, &x, &y);
+            return import_add_node(state, slot, record->id, x, y, NULL, 0);
+        }
+    
+        case IMPORT_OSM_WAY:
+            if (state->inWay && !import_finish_way(state)) return false;
+            state->inWay = true;
+            state->refCount = 0;
+            state->wayFlags = 0;
+            return true;
+    
+        case IMPORT_OSM_ND:
+            if (!state->inWay) return true;
+            if (state->refCount == state->refCapacity) {
+                int capacity = state->refCapacity > 0 ? state->refCapacity * 2 : 64;
+                long long* refs = (long long*)realloc(state->refs, capacity * sizeof(long long));
+                if (!refs) return false;
+                state->refs = refs;
+                state->refCapacity = capacity;
+            }
+            state->refs[state->refCount++] = record->ref;
+            return true;
+    
+        case IMPORT_OSM_TAG:
+            if (state->inWay) state->wayFlags |= record->flags;
+            return true;
+    
+        case IMPORT_OSM_WAY_END:
+            return !state->inWay || import_finish_way(state);
+    
+        default:
+            return true;
+    }
+}
+
+// The graph is released first, so it ends up empty on every failure
+static bool import_begin(ImportState* state, Graph* graph, const ImportOptions* options, ImportStats* stats) {
+    graph_free(graph);
+    memset(state, 0, sizeof(*state));
+    memset(stats, 0, sizeof(*stats));
+    state->graph = graph;
+    state->stats = stats;
+    state->options = options ? *options : import_default_options();
+    if (state->options.chunkBytes == 0) state->options.chunkBytes = IMPORT_DEFAULT_CHUNK;
+    if (!(state->options.scale > 0.0)) state->options.scale = 1.0;
+    
+    state->sliceCount = thread_worker_count(state->options.threadCount,
+                                            (int)(state->options.chunkBytes / IMPORT_MIN_SLICE) + 1);
+    state->slices = (ImportSlice*)calloc(state->sliceCount, sizeof(ImportSlice));
+    if (!state->slices || !import_id_map_init(&state->ids, IMPORT_ID_INITIAL_CAPACITY)) {
+        free(state->slices);
+        return false;
+    }
+    return true;
+}
+
+static void import_end(ImportState* state) {
+    for (int w = 0; w < state->sliceCount; w++) free(state->slices[w].records);
+    free(state->slices);
+    free(state->refs);
+    import_id_map_free(&state->ids);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+ImportOptions import_default_options(void) {
+    ImportOptions options;
+    options.threadCount = 0;
+    options.chunkBytes = IMPORT_DEFAULT_CHUNK;
+    options.geographic = false;
+    options.directed = false;
+    options.originLat = NAN;
+    options.originLon = NAN;
+    options.scale = 1.0;
+    return options;
+}
+
+bool import_csv(Graph* graph, const char* nodesPath, const char* edgesPath,
+                const ImportOptions* options, ImportStats* stats) {
+    if (!graph || !nodesPath || !edgesPath) return false;
+    
+    ImportState state;
+    ImportStats localStats;
+    if (!import_begin(&state, graph, options, stats ? stats : &localStats)) return false;
+    
+    bool ok = import_run_file(&state, nodesPath, import_parse_csv_node,
+                              IMPORT_KIND_BIT(IMPORT_CSV_NODE), import_apply_csv_node) &&
+              import_run_file(&state, edgesPath, import_parse_csv_edge,
+                              IMPORT_KIND_BIT(IMPORT_CSV_EDGE), import_apply_csv_edge);
+    import_end(&state);
+    if (!ok) graph_free(graph);
+    return ok;
+}
+
+bool import_osm(Graph* graph, const char* path, const ImportOptions* options, ImportStats* stats) {
+    if (!graph || !path) return false;
+    
+    ImportState state;
+    ImportStats localStats;
+    if (!import_begin(&state, graph, options, stats ? stats : &localStats)) return false;
+    
+    // Pass 1 reads only the ways, pass 2 the nodes they use and the ways again
+    state.collecting = true;
+    bool ok = import_run_file(&state, path, import_parse_osm, IMPORT_OSM_WAY_BITS, import_apply_osm) &&
+              (!state.inWay || import_finish_way(&state));
+    state.collecting = false;
+    state.inWay = false;
+    ok = ok && import_run_file(&state, path, import_parse_osm,
+                               IMPORT_OSM_WAY_BITS | IMPORT_KIND_BIT(IMPORT_OSM_NODE), import_apply_osm) &&
+         (!state.inWay || import_finish_way(&state));
+    
+    import_end(&state);
+    if (!ok) graph_free(graph);
+    return ok;
+}
@@ -0,0 +1,87 @@
+/**
+ * import.h - Streaming import of external road networks
+ *
+ * Reads CSV node/edge lists and OpenStreetMap XML extracts into a Graph
+ * without holding the file in memory. The input is read in fixed-size
+ * chunks of whole lines; each chunk is split at line boundaries and the
+ * slices are parsed into compact records by one worker per CPU, then the
+ * records are applied to the graph in file order on the calling thread.
+ * Memory use is the chunk, its records and the graph being built.
+ *
+ * - CSV nodes: `id,x,y[,name]`. Edges: `from,to[,weight[,oneway]]`;
+ *   an empty or missing weight is the distance between the endpoints
+ *   (graph_calculate_distance), and oneway is 0 or 1 (missing uses
+ *   ImportOptions.directed). Lines whose first field is not a number
+ *   (headers, `#` comments) are skipped.
+ * - OSM XML: `<node>`, `<way>`, `<nd>` and `<tag>` elements, one per
+ *   line as written by osmium, osmosis and Overpass. Every way with a
+ *   highway tag becomes a chain of edges between consecutive nodes,
+ *   one-way for oneway=yes/1/true/-1 and roundabouts. The file is read
+ *   twice: first to collect the nodes the roads use, then to add those
+ *   nodes and the edges, so unused shape and POI nodes never take memory.
+ *
+ * Geographic coordinates are projected equirectangularly around an origin
+ * (the first node unless set) into metres times ImportOptions.scale, x
+ * east and y south like the screen. Both directions of an edge listed
+ * twice are only added once. To get an RCGRAPH2 file, pass the imported
+ * graph to graphfile_save.
+ */
+
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMPORT_DEFAULT_CHUNK (4u << 20)   // Bytes read per chunk
+#define IMPORT_MIN_SLICE (64u << 10)      // Smallest slice worth its own worker
+
+typedef struct {
+    int threadCount;         // Parser workers (0 = one per CPU)
+    size_t chunkBytes;       // Read size, also the longest line (0 = IMPORT_DEFAULT_CHUNK)
+    bool geographic;         // CSV x/y are longitude/latitude (OSM always is)
+    bool directed;           // CSV edges without a oneway field are one-way
+    double originLat;        // Projection origin in degrees (NaN = first node)
+    double originLon;
+    double scale;            // Map units per metre (0 = 1)
+} ImportOptions;
+
+typedef struct {
+    int nodes;               // Nodes added
+    int edges;               // Directed edges added
+    int ways;                // OSM ways turned into roads
+    int duplicateNodes;      // Node IDs seen before (the first one is kept)
+    int duplicateEdges;      // Edges already in the graph
+    int missingNodes;        // Edge endpoints or way references without a node
+    int malformedLines;      // Records that could not be parsed
+    int chunks;              // Chunks read, over all passes
+    unsigned long long bytesRead;  // Over all passes
+} ImportStats;
+
+ImportOptions import_default_options(void);
+
+/**
+ * Import a CSV node list and edge list
+ *
+ * @param graph      Output (previous contents are released; freed on failure)
+ * @param nodesPath  Node file
+ * @param edgesPath  Edge file
+ * @param options    NULL for defaults
+ * @param stats      Output counters (can be NULL)
+ * @return           false if a file cannot be read, a line is longer than
+ *                   the chunk, or memory runs out
+ */
+bool import_csv(Graph* graph, const char* nodesPath, const char* edgesPath,
+                const ImportOptions* options, ImportStats* stats);
+
+// Import the roads of an OSM XML extract (same contract as import_csv)
+bool import_osm(Graph* graph, const char* path, const ImportOptions* options, ImportStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMPORT_H
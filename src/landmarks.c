@@ -0,0 +1,258 @@
+/**
+ * landmarks.c - ALT landmark selection, distance tables and bounds
+ */
+
+#include "landmarks.h"
+#include "pqueue.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <float.h>
+
+// Full Dijkstra from source over the outgoing (or, with reverse set,
+// incoming) rows of the snapshot. dist is filled for every node.
+static void landmark_dijkstra(const GraphCSR* csr, int source, bool reverse,
+                              PriorityQueue* pq, float* dist) {
+    for (int i = 0; i < csr->nodeCount; i++) {
+        dist[i] = FLT_MAX;
+    }
+    pq_clear(pq);
+    
+    const int* offsets = reverse ? csr->inOffsets : csr->offsets;
+    const int* adjacent = reverse ? csr->inFrom : csr->to;
+    const float* weights = reverse ? csr->inWeight : csr->weight;
+    
+    dist[source] = 0.0f;
+    pq_push(pq, source, 0.0f);
+    
+    while (!pq_empty(pq)) {
+        int u;
+        float d;
+        pq_pop(pq, &u, &d);
+    
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+            int v = adjacent[e];
+            float tentative = d + weights[e];
+            if (tentative < dist[v]) {
+                dist[v] = tentative;
+                pq_update(pq, v, tentative);
+            }
+        }
+    }
+}
+
+bool landmarks_build(const GraphCSR* csr, int count, LandmarkTable* table) {
+    if (!csr || !table) return false;
+    memset(table, 0, sizeof(*table));
+    
+    int n = csr->nodeCount;
+    if (count < 1) count = 1;
+    if (count > LANDMARK_MAX_COUNT) count = LANDMARK_MAX_COUNT;
+    
+    // Only nodes with edges are useful landmarks
+    int candidates = 0;
+    for (int v = 0; v < n; v++) {
+        if (csr->offsets[v + 1] > csr->offsets[v] || csr->inOffsets[v + 1] > csr->inOffsets[v]) {
+            candidates++;
+        }
+    }
+    if (count > candidates) count = candidates;
+    
+    table->nodeCount = n;
+    table->signature = landmarks_signature(csr);
+    if (count == 0) return true;
+    
+    size_t cells = (size_t)count * n;
+    table->nodes = (int*)malloc(count * sizeof(int));
+    table->fromLandmark = (float*)malloc(cells * sizeof(float));
+    table->toLandmark = (float*)malloc(cells * sizeof(float));
+    float* nearest = (float*)malloc(n * sizeof(float));  // Distance to the closest landmark so far
+    bool* chosen = (bool*)calloc(n, sizeof(bool));
+    PriorityQueue pq;
+    bool queueReady = pq_init(&pq, PQ_INDEXED_HEAP, n);
+    
+    bool ok = queueReady && table->nodes && table->fromLandmark && table->toLandmark &&
+              nearest && chosen;
+    
+    if (ok) {
+        for (int v = 0; v < n; v++) {
+            nearest[v] = FLT_MAX;
+        }
+    
+        for (int i = 0; i < count; i++) {
+            // Farthest selection: the first candidate with the largest distance
+            // to the chosen set. Unreached nodes count as infinitely far, so
+            // every connected component gets a landmark before any gets two.
+            int landmark = -1;
+            for (int v = 0; v < n; v++) {
+                if (chosen[v]) continue;
+                if (csr->offsets[v + 1] == csr->offsets[v] && csr->inOffsets[v + 1] == csr->inOffsets[v]) {
+                    continue;
+                }
+                if (landmark < 0 || nearest[v] > nearest[landmark]) landmark = v;
+            }
+    
+            chosen[landmark] = true;
+            table->nodes[i] = landmark;
+    
+            float* from = table->fromLandmark + (size_t)i * n;
+            float* to = table->toLandmark + (size_t)i * n;
+            landmark_dijkstra(csr, landmark, false, &pq, from);
+            landmark_dijkstra(csr, landmark, true, &pq, to);
+    
+            for (int v = 0; v < n; v++) {
+                if (from[v] < nearest[v]) nearest[v] = from[v];
+            }
+        }
+        table->count = count;
+    }
+    
+    if (queueReady) pq_free(&pq);
+    free(nearest);
+    free(chosen);
+    
+    if (!ok) landmarks_free(table);
+    return ok;
+}
+
+void landmarks_free(LandmarkTable* table) {
+    if (!table) return;
+    free(table->nodes);
+    free(table->fromLandmark);
+    free(table->toLandmark);
+    memset(table, 0, sizeof(*table));
+}
+
+float landmarks_lower_bound(const LandmarkTable* table, int from, int to) {
+    if (!table || from < 0 || to < 0 || from >= table->nodeCount || to >= table->nodeCount) {
+        return 0.0f;
+    }
+    
+    int n = table->nodeCount;
+    float best = 0.0f;
+    for (int i = 0; i < table->count; i++) {
+        const float* fromL = table->fromLandmark + (size_t)i * n;
+        const float* toL = table->toLandmark + (size_t)i * n;
+    
+        // d(L, to) - d(L, from); skipped when L does not reach both
+        if (fromL[to] != FLT_MAX && fromL[from] != FLT_MAX) {
+            float bound = fromL[to] - fromL[from];
+            if (bound > best) best = bound;
+        }
+        // d(from, L) - d(to, L)
+        if (toL[from] != FLT_MAX && toL[to] != FLT_MAX) {
+            float bound = toL[from] - toL[to];
+            if (bound > best) best = bound;
+        }
+    }
+    return best;
+}
+
+// FNV-1a over the node count and every (target, weight) pair, row by row
+unsigned int landmarks_signature(const GraphCSR* csr) {
+    if (!csr) return 0;
+    
+    unsigned int hash = 2166136261u;
+    const unsigned char* bytes;
+    
+    bytes = (const unsigned char*)&csr->nodeCount;
+    for (size_t b = 0; b < sizeof(int); b++) hash = (hash ^ bytes[b]) * 16777619u;
+    
+    for (int u = 0; u < csr->nodeCount; u++) {
+        for (int e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int key[2] = { u, csr->to[e] };
+            float weight = csr->weight[e];
+    
+            bytes = (const unsigned char*)key;
+            for (size_t b = 0; b < sizeof(key); b++) hash = (hash ^ bytes[b]) * 16777619u;
+            bytes = (const unsigned char*)&weight;
+            for (size_t b = 0; b < sizeof(float); b++) hash = (hash ^ bytes[b]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+// File layout: "RCLMARK1", count, nodeCount, signature, landmark IDs,
+// then the from and to tables (count * nodeCount floats each)
+bool landmarks_save(const LandmarkTable* table, const char* filename) {
+    if (!table || !filename) return false;
+    
+    FILE* file = fopen(filename, "wb");
+    if (!file) return false;
+    
+    const char magic[] = "RCLMARK1";
+    fwrite(magic, 1, 8, file);
+    fwrite(&table->count, sizeof(int), 1, file);
+    fwrite(&table->nodeCount, sizeof(int), 1, file);
+    fwrite(&table->signature, sizeof(unsigned int), 1, file);
+    
+    size_t cells = (size_t)table->count * table->nodeCount;
+    if (table->count > 0) {
+        fwrite(table->nodes, sizeof(int), table->count, file);
+        fwrite(table->fromLandmark, sizeof(float), cells, file);
+        fwrite(table->toLandmark, sizeof(float), cells, file);
+    }
+    
+    bool ok = !ferror(file);
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+// The table's previous contents are released. Check table->signature
+// against the current graph before using the result.
+bool landmarks_load(LandmarkTable* table, const char* filename) {
+    if (!table || !filename) return false;
+    
+    FILE* file = fopen(filename, "rb");
+    if (!file) return false;
+    
+    landmarks_free(table);
+    
+    char magic[8];
+    int count, nodeCount;
+    unsigned int signature;
+    bool ok = fread(magic, 1, 8, file) == 8 && memcmp(magic, "RCLMARK1", 8) == 0 &&
+              fread(&count, sizeof(int), 1, file) == 1 &&
+              fread(&nodeCount, sizeof(int), 1, file) == 1 &&
+              fread(&signature, sizeof(unsigned int), 1, file) == 1 &&
+              count >= 0 && count <= LANDMARK_MAX_COUNT && nodeCount >= 0;
+    
+    if (ok && count > 0) {
+        size_t cells = (size_t)count * nodeCount;
+        table->nodes = (int*)malloc(count * sizeof(int));
+        table->fromLandmark = (float*)malloc((cells > 0 ? cells : 1) * sizeof(float));
+        table->toLandmark = (float*)malloc((cells > 0 ? cells : 1) * sizeof(float));
+        ok = table->nodes && table->fromLandmark && table->toLandmark &&
+             fread(table->nodes, sizeof(int), count, file) == (size_t)count &&
+             fread(table->fromLandmark, sizeof(float), cells, file) == cells &&
+             fread(table->toLandmark, sizeof(float), cells, file) == cells;
+    
+        for (int i = 0; i < count && ok; i++) {
+            ok = table->nodes[i] >= 0 && table->nodes[i] < nodeCount;
+        }
+    }
+    
+    fclose(file);
+    
+    if (!ok) {
+        landmarks_free(table);
+        return false;
+    }
+    table->count = count;
+    table->nodeCount = nodeCount;
+    table->signature = signature;
+    return true;
+}
+
+void landmarks_file_path(const char* graphFile, char* out, int outSize) {
+    if (!out || outSize <= 0) return;
+    if (!graphFile) {
+        out[0] = '\0';
+        return;
+    }
+    
+    // Replace a trailing ".rcg", otherwise append the extension
+    size_t len = strlen(graphFile);
+    if (len >= 4 && strcmp(graphFile + len - 4, ".rcg") == 0) len -= 4;
+    snprintf(out, outSize, "%.*s.rcl", (int)len, graphFile);
+}
@@ -0,0 +1,72 @@
+/**
+ * landmarks.h - ALT heuristic (A*, Landmarks, Triangle inequality)
+ *
+ * A handful of landmark nodes is chosen ahead of time, and the exact
+ * shortest-path distances from and to every landmark are stored. For any
+ * landmark L the triangle inequality gives two lower bounds on d(v, t):
+ *
+ *   d(v, t) >= d(L, t) - d(L, v)
+ *   d(v, t) >= d(v, L) - d(t, L)
+ *
+ * The heuristic is the largest bound over all landmarks. Unlike the
+ * coordinate heuristics it follows the actual edge weights, so it stays
+ * tight on graphs whose costs are far from straight-line distance.
+ *
+ * Landmarks are picked by farthest selection: each new landmark is the
+ * node farthest from the ones picked so far. The table can be saved next
+ * to the .rcg file it was built for (see landmarks_file_path).
+ */
+
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LANDMARK_DEFAULT_COUNT 8
+#define LANDMARK_MAX_COUNT 64
+
+// Precomputed landmark distances (FLT_MAX where unreachable)
+typedef struct LandmarkTable {
+    int count;
+    int nodeCount;
+    int* nodes;              // Landmark node IDs
+    float* fromLandmark;     // fromLandmark[i * nodeCount + v] = d(L_i, v)
+    float* toLandmark;       // toLandmark[i * nodeCount + v] = d(v, L_i)
+    unsigned int signature;  // landmarks_signature of the graph it was built for
+} LandmarkTable;
+
+/**
+ * Choose landmarks and compute their distance tables
+ *
+ * @param csr    Frozen graph (see graph_freeze); node IDs are preserved
+ * @param count  Number of landmarks (clamped to [1, LANDMARK_MAX_COUNT]
+ *               and to the number of nodes that have edges)
+ * @param table  Output table (call landmarks_free when done)
+ * @return       false on allocation failure
+ */
+bool landmarks_build(const GraphCSR* csr, int count, LandmarkTable* table);
+void landmarks_free(LandmarkTable* table);
+
+// Lower bound on the cost of travelling from -> to (0 without a table)
+float landmarks_lower_bound(const LandmarkTable* table, int from, int to);
+
+// Hash of the topology and weights; a table is only valid for graphs
+// with the same signature (a shorter edge anywhere breaks the bounds)
+unsigned int landmarks_signature(const GraphCSR* csr);
+
+// Serialization
+bool landmarks_save(const LandmarkTable* table, const char* filename);
+bool landmarks_load(LandmarkTable* table, const char* filename);
+
+// Table file name for a graph file: "map.rcg" -> "map.rcl"
+void landmarks_file_path(const char* graphFile, char* out, int outSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LANDMARKS_H
@@ -51,6 +51,10 @@
 #include "raylib.h"
 #include "graph.h"
 #include "astar.h"
+#include "landmarks.h"
+#include "routecache.h"
+#include "searchworker.h"
+#include "snapshot.h"
 #include "ui.h"
 
 #include <stdio.h>
@@ -63,6 +67,9 @@
 #define WINDOW_HEIGHT   720
 #define SIDEBAR_WIDTH   320
 #define MAP_FILE        "map.rcg"
+#define LANDMARK_FILE   "map.rcl"   // landmarks_file_path(MAP_FILE)
+#define SUGGESTION_COUNT 5
+#define SUGGESTION_HEIGHT 28
 
 // Application modes
 typedef enum {
@@ -73,10 +80,56 @@ typedef enum {
     MODE_SEARCH         // Path search mode
 } AppMode;
 
+// Type-ahead candidates for the focused search field
+typedef struct {
+    const InputField* field;    // NULL when no search field is focused
+    char query[256];            // Text the candidates were computed for
+    int nodes[SUGGESTION_COUNT];
+    int count;
+} Suggestions;
+
+// Undirected road as drawn on the map (a <-> b, one entry per pair)
+typedef struct {
+    int a;
+    int b;
+    float weight;
+    int pathStep;               // k if the route goes a<->b at step k, else -1
+    char label[8];              // Formatted weight
+    int labelWidth;
+} MapEdge;
+
+// Render data derived from the graph, rebuilt only when the map changes
+typedef struct {
+    bool valid;                 // False after any edit to the graph
+    bool pathValid;             // False after the route changes
+    
+    MapEdge* edges;
+    int edgeCount;
+    int* incidentOffsets;       // Edges touching node i: [offsets[i], offsets[i + 1])
+    int* incident;
+    int* nameWidths;            // MeasureText of each node name
+    int nodeCount;
+    float maxEdgeLength;        // World units, bounds how far off-screen an edge can start
+    int maxNameWidth;
+    int maxLabelWidth;
+    bool* pathNodes;
+    
+    // Per-frame scratch
+    int* visible;
+    int visibleCapacity;
+    int* drawn;                 // Visible edges this frame
+    unsigned int* edgeFrame;    // Frame an edge was last collected in
+    unsigned int frame;
+} MapRenderCache;
+
 // Application state
 typedef struct {
     Graph graph;
     AppMode mode;
+    GraphStore* store;          // Snapshots of graph for the background searches
+    SearchWorker* search;       // Background searches (owns the ALT table)
+    bool searchPending;         // A posted search whose result is still wanted
+    RouteCache routeCache;      // Results of recent searches
     
     // Selection
     int hoveredNode;
@@ -91,12 +144,14 @@ typedef struct {
     bool pathAnimating;
     float pathAnimProgress;
     
-    // Exploration visualization
-    int* exploredNodes;
-    int exploredCount;
+    // Exploration visualization (settle events live in the search worker)
+    int exploredCount;          // Events ready so far, grows while searching
     float explorationAnimProgress;
     bool showExploration;
     
+    // Culling and batching state for app_draw_map
+    MapRenderCache mapCache;
+    
     // Camera/pan
     Vector2 offset;
     float zoom;
@@ -108,6 +163,7 @@ typedef struct {
     InputField nodeNameInput;
     InputField searchFromInput;
     InputField searchToInput;
+    Suggestions suggestions;
     Button addNodeBtn;
     Button addEdgeBtn;
     Button deleteBtn;
@@ -131,10 +187,17 @@ void app_update(void);
 void app_draw(void);
 void app_draw_sidebar(void);
 void app_draw_map(void);
+void app_draw_suggestions(void);
 void app_handle_map_input(void);
+bool app_update_suggestions(void);
 void app_perform_search(void);
+void app_poll_search(void);
 void app_clear_path(void);
 void app_generate_sample_map(void);
+void app_invalidate_map(void);
+static void map_cache_free(MapRenderCache* cache);
+static void app_compact_graph(void);
+static void app_show_route(PathResult path, int fromId, int toId, bool cached);
 Vector2 world_to_screen(float x, float y);
 Vector2 screen_to_world(float x, float y);
 
@@ -167,12 +230,18 @@ int main(void) {
 void app_init(void) {
     // Initialize graph
     graph_init(&app.graph);
+    app.store = graph_store_create();
     
     // Try to load existing map
     if (!graph_load(&app.graph, MAP_FILE)) {
         // Generate sample map if no saved map exists
         app_generate_sample_map();
     }
+    graph_store_publish(app.store, &app.graph);
+    app.search = search_worker_create();
+    LandmarkTable* landmarks = search_worker_landmarks(app.search);
+    if (landmarks) landmarks_load(landmarks, LANDMARK_FILE);
+    route_cache_init(&app.routeCache, ROUTE_CACHE_DEFAULT_CAPACITY);
     
     // Initialize state
     app.mode = MODE_VIEW;
@@ -182,7 +251,6 @@ void app_init(void) {
     app.searchStartNode = -1;
     app.searchEndNode = -1;
     app.currentPath = path_result_create();
-    app.exploredNodes = (int*)malloc(MAX_NODES * sizeof(int));
     app.exploredCount = 0;
     
     // Camera
@@ -228,7 +296,10 @@ void app_init(void) {
 
 void app_cleanup(void) {
     path_result_free(&app.currentPath);
-    free(app.exploredNodes);
+    search_worker_free(app.search);
+    graph_store_free(app.store);
+    map_cache_free(&app.mapCache);
+    route_cache_free(&app.routeCache);
     graph_free(&app.graph);
     ui_cleanup();
 }
@@ -248,11 +319,20 @@ void app_update(void) {
         }
     }
     
+    // Pick up a finished search, and the frontier of a running one
+    app_poll_search();
+    if (app.showExploration) {
+        search_worker_explored(app.search, &app.exploredCount);
+    }
+    
     // Update exploration animation
     if (app.showExploration && app.explorationAnimProgress < (float)app.exploredCount) {
         app.explorationAnimProgress += dt * 30.0f;  // Show 30 nodes per second
     }
     
+    // A click on a suggestion must not fall through to the buttons below it
+    if (app_update_suggestions()) return;
+    
     // Update buttons
     if (ui_button_update(&app.addNodeBtn)) {
         app.mode = (app.mode == MODE_ADD_NODE) ? MODE_VIEW : MODE_ADD_NODE;
@@ -281,6 +361,12 @@ void app_update(void) {
     
     if (ui_button_update(&app.saveBtn)) {
         if (graph_save(&app.graph, MAP_FILE)) {
+            // A table left over from an older map is rebuilt after loading
+            // (its signature will not match), so saving it is harmless
+            LandmarkTable* landmarks = search_worker_landmarks(app.search);
+            if (landmarks && landmarks->count > 0) {
+                landmarks_save(landmarks, LANDMARK_FILE);
+            }
             ui_notify("Map saved successfully!", NOTIFY_SUCCESS);
         } else {
             ui_notify("Failed to save map", NOTIFY_ERROR);
@@ -288,7 +374,13 @@ void app_update(void) {
     }
     
     if (ui_button_update(&app.loadBtn)) {
+        // The worker's landmark table is replaced too, so let a running
+        // search finish first (its result is dropped with the old map)
+        search_worker_wait(app.search);
         if (graph_load(&app.graph, MAP_FILE)) {
+            app_invalidate_map();
+            LandmarkTable* landmarks = search_worker_landmarks(app.search);
+            if (landmarks) landmarks_load(landmarks, LANDMARK_FILE);
             app_clear_path();
             ui_notify("Map loaded successfully!", NOTIFY_SUCCESS);
         } else {
@@ -313,6 +405,46 @@ void app_update(void) {
     app_handle_map_input();
 }
 
+// Screen rectangle of suggestion row i below its field
+static Rectangle suggestion_bounds(int i) {
+    Rectangle field = app.suggestions.field->bounds;
+    return (Rectangle){field.x, field.y + field.height + 2 + i * SUGGESTION_HEIGHT,
+                       field.width, SUGGESTION_HEIGHT};
+}
+
+// Refresh the candidates when the query changes; returns true if a click
+// picked one
+bool app_update_suggestions(void) {
+    Suggestions* s = &app.suggestions;
+    InputField* field = app.searchFromInput.focused ? &app.searchFromInput :
+                        app.searchToInput.focused ? &app.searchToInput : NULL;
+    if (!field || field->text[0] == '\0') {
+        s->field = NULL;
+        s->count = 0;
+        return false;
+    }
+    
+    if (s->field != field || strcmp(s->query, field->text) != 0) {
+        s->field = field;
+        strcpy(s->query, field->text);
+        s->count = graph_find_nodes_by_name(&app.graph, field->text, s->nodes, SUGGESTION_COUNT);
+    }
+    
+    if (!IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) return false;
+    Vector2 mouse = GetMousePosition();
+    for (int i = 0; i < s->count; i++) {
+        const Node* node = graph_get_node(&app.graph, s->nodes[i]);
+        if (node && ui_point_in_rect(mouse, suggestion_bounds(i))) {
+            ui_input_set_text(field, node->name);
+            field->focused = false;
+            s->field = NULL;
+            s->count = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
 void app_handle_map_input(void) {
     Vector2 mouse = GetMousePosition();
     
@@ -374,6 +506,7 @@ void app_handle_map_input(void) {
                 
                 int id = graph_add_node(&app.graph, nodeName, worldPos.x, worldPos.y);
                 if (id >= 0) {
+                    app_invalidate_map();
                     ui_notify("Location added!", NOTIFY_SUCCESS);
                     ui_input_clear(&app.nodeNameInput);
                 }
@@ -392,6 +525,7 @@ void app_handle_map_input(void) {
                         float distance = graph_calculate_distance(from, to);
                         
                         if (graph_add_edge_bidirectional(&app.graph, app.edgeStartNode, app.hoveredNode, distance)) {
+                            app_invalidate_map();
                             ui_notify("Road created!", NOTIFY_SUCCESS);
                         } else {
                             ui_notify("Road already exists", NOTIFY_WARNING);
@@ -404,8 +538,10 @@ void app_handle_map_input(void) {
             case MODE_DELETE:
                 if (app.hoveredNode >= 0) {
                     graph_remove_node(&app.graph, app.hoveredNode);
+                    app_invalidate_map();
                     ui_notify("Location deleted", NOTIFY_INFO);
                     app_clear_path();
+                    app_compact_graph();
                 }
                 break;
                 
@@ -423,6 +559,20 @@ void app_handle_map_input(void) {
     }
 }
 
+// A location is a node name, or "x, y" map coordinates snapped to the
+// nearest node
+static int app_resolve_location(const char* text) {
+    int id = graph_find_node_by_name(&app.graph, text);
+    if (id >= 0) return id;
+    
+    float x, y;
+    char rest;
+    if (sscanf(text, " %f , %f %c", &x, &y, &rest) == 2) {
+        return graph_find_nearest_node(&app.graph, x, y);
+    }
+    return -1;
+}
+
 void app_perform_search(void) {
     const char* fromName = app.searchFromInput.text;
     const char* toName = app.searchToInput.text;
@@ -432,8 +582,8 @@ void app_perform_search(void) {
         return;
     }
     
-    int fromId = graph_find_node_by_name(&app.graph, fromName);
-    int toId = graph_find_node_by_name(&app.graph, toName);
+    int fromId = app_resolve_location(fromName);
+    int toId = app_resolve_location(toName);
     
     if (fromId < 0) {
         ui_notify("Origin location not found", NOTIFY_ERROR);
@@ -444,28 +594,83 @@ void app_perform_search(void) {
         return;
     }
     
+    if (search_worker_phase(app.search) != SEARCH_PHASE_IDLE) {
+        ui_notify("Still searching for the last route", NOTIFY_WARNING);
+        return;
+    }
+    
     // Clear previous path
     app_clear_path();
     
-    // Get exploration order for visualization
-    app.exploredCount = astar_get_exploration_order(&app.graph, fromId, toId, 
-                                                     app.exploredNodes, MAX_NODES);
+    // Guided by landmark bounds; the worker rebuilds its table on the
+    // search thread when the map has changed
+    AStarConfig config = astar_default_config();
+    config.heuristic = HEURISTIC_LANDMARKS;
+    config.landmarks = search_worker_landmarks(app.search);
+    
+    // Repeated queries on an unchanged map come from the cache (and have
+    // no exploration to show)
+    PathResult cached;
+    if (route_cache_lookup(&app.routeCache, &app.graph, fromId, toId, &config, &cached, &app.pathStats)) {
+        app_show_route(cached, fromId, toId, true);
+        return;
+    }
+    
+    // Anything else searches in the background, on a snapshot of the
+    // current version (publishing again is a no-op unless an earlier
+    // publish failed), so the map keeps drawing and stays editable;
+    // app_poll_search picks up the result
+    if (!graph_store_publish(app.store, &app.graph) ||
+        !search_worker_post(app.search, app.store, fromId, toId, &config)) {
+        ui_notify("Could not start the search", NOTIFY_ERROR);
+        return;
+    }
+    app.searchPending = true;
+    app.exploredCount = 0;
     app.explorationAnimProgress = 0.0f;
     app.showExploration = true;
+}
     
-    // Find path
-    AStarConfig config = astar_default_config();
-    app.currentPath = astar_find_path(&app.graph, fromId, toId, &config, &app.pathStats);
+void app_poll_search(void) {
+    SearchResult result;
+    if (!search_worker_poll(app.search, &result)) return;
     
+    // Cleared or superseded while it ran
+    if (!app.searchPending) {
+        path_result_free(&result.path);
+        return;
+    }
+    app.searchPending = false;
+    
+    // Node IDs of a result for an older map may no longer mean the same
+    // places, so neither show nor cache it
+    if (result.graphVersion != app.graph.version) {
+        path_result_free(&result.path);
+        app.showExploration = false;
+        app.exploredCount = 0;
+        ui_notify("The map changed during the search, please search again", NOTIFY_WARNING);
+        return;
+    }
+    
+    route_cache_store(&app.routeCache, &app.graph, result.startId, result.goalId,
+                      &result.config, &result.path, &result.stats);
+    app.pathStats = result.stats;
+    app_show_route(result.path, result.startId, result.goalId, false);
+}
+
+// Take ownership of a search result and start its animation
+static void app_show_route(PathResult path, int fromId, int toId, bool cached) {
+    app.currentPath = path;
     if (app.currentPath.found) {
         app.searchStartNode = fromId;
         app.searchEndNode = toId;
         app.pathAnimating = true;
         app.pathAnimProgress = 0.0f;
+        app.mapCache.pathValid = false;
         
         char msg[128];
-        snprintf(msg, sizeof(msg), "Route found! Distance: %.1f, Nodes explored: %d", 
-                 app.currentPath.totalCost, app.pathStats.nodesExplored);
+        snprintf(msg, sizeof(msg), "Route found%s! Distance: %.1f, Nodes explored: %d", 
+                 cached ? " (cached)" : "", app.currentPath.totalCost, app.pathStats.nodesExplored);
         ui_notify(msg, NOTIFY_SUCCESS);
     } else {
         ui_notify("No route found between these locations", NOTIFY_ERROR);
@@ -482,10 +687,32 @@ void app_clear_path(void) {
     app.exploredCount = 0;
     app.explorationAnimProgress = 0.0f;
     app.showExploration = false;
+    app.searchPending = false;
+    app.mapCache.pathValid = false;
+}
+
+// Drop tombstones once deletions pile up, translating the node IDs the
+// app still holds (call with the path already cleared)
+static void app_compact_graph(void) {
+    if (!graph_needs_compaction(&app.graph)) return;
+    
+    int oldCount = app.graph.nodeCount;
+    int* map = (int*)malloc((oldCount > 0 ? oldCount : 1) * sizeof(int));
+    if (!map) return;
+    
+    if (graph_compact(&app.graph, map, NULL)) {
+        if (app.selectedNode >= 0) app.selectedNode = map[app.selectedNode];
+        if (app.edgeStartNode >= 0) app.edgeStartNode = map[app.edgeStartNode];
+        app.hoveredNode = -1;
+        app.suggestions.field = NULL;
+        app.suggestions.count = 0;
+        app_invalidate_map();
+    }
+    free(map);
 }
 
 void app_generate_sample_map(void) {
-    graph_init(&app.graph);
+    graph_free(&app.graph);
     
     // Create a sample city-like map
     // Central area
@@ -561,6 +788,7 @@ void app_generate_sample_map(void) {
     CONNECT(harbor, mainStation);
     
     #undef CONNECT
+    app_invalidate_map();
 }
 
 Vector2 world_to_screen(float x, float y) {
@@ -626,8 +854,22 @@ void app_draw_sidebar(void) {
     ui_button_draw(&app.searchBtn);
     ui_button_draw(&app.clearPathBtn);
     
-    // Path info
-    if (app.currentPath.found) {
+    // Progress of a background search, or the info of the route found
+    SearchPhase phase = search_worker_phase(app.search);
+    if (app.searchPending && phase != SEARCH_PHASE_IDLE) {
+        int y = 400;
+        DrawText("Route Info", 20, y, UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
+        y += 25;
+        
+        ui_draw_spinner(28, y + 7, 8, (float)GetTime(), UI_COLOR_SECONDARY);
+        DrawText(phase == SEARCH_PHASE_LANDMARKS ? "Preparing landmarks..." : "Searching...",
+                 44, y, UI_FONT_SIZE_SMALL, UI_COLOR_SECONDARY);
+        y += 20;
+        
+        char info[128];
+        snprintf(info, sizeof(info), "Nodes explored: %d", app.exploredCount);
+        DrawText(info, 20, y, UI_FONT_SIZE_SMALL, UI_COLOR_TEXT);
+    } else if (app.currentPath.found) {
         int y = 400;
         DrawText("Route Info", 20, y, UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
         y += 25;
@@ -656,15 +898,195 @@ void app_draw_sidebar(void) {
     ui_button_draw(&app.generateSampleBtn);
     
     // Stats at bottom
-    char statsText[64];
-    snprintf(statsText, sizeof(statsText), "Locations: %d", app.graph.nodeCount);
+    char statsText[96];
+    snprintf(statsText, sizeof(statsText), "Locations: %d | Cached routes: %d/%d hits",
+             app.graph.nodeCount, app.routeCache.stats.hits,
+             app.routeCache.stats.hits + app.routeCache.stats.misses);
     DrawText(statsText, 20, WINDOW_HEIGHT - 60, UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
     
     // Instructions
     DrawText("RMB: Pan | Scroll: Zoom", 20, WINDOW_HEIGHT - 35, UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
+    
+    // Type-ahead dropdown over everything below the search fields
+    app_draw_suggestions();
+}
+
+void app_draw_suggestions(void) {
+    const Suggestions* s = &app.suggestions;
+    if (!s->field || s->count == 0) return;
+    
+    Vector2 mouse = GetMousePosition();
+    for (int i = 0; i < s->count; i++) {
+        const Node* node = graph_get_node(&app.graph, s->nodes[i]);
+        if (!node) continue;
+        
+        Rectangle row = suggestion_bounds(i);
+        DrawRectangleRec(row, ui_point_in_rect(mouse, row) ? UI_COLOR_BG_LIGHTER : UI_COLOR_BG);
+        DrawRectangleLinesEx(row, 1, UI_COLOR_BORDER);
+        DrawText(node->name, (int)(row.x + UI_PADDING), (int)(row.y + (row.height - UI_FONT_SIZE_SMALL) / 2),
+                 UI_FONT_SIZE_SMALL, UI_COLOR_TEXT);
+    }
+}
+
+// ============ Map rendering ============
+
+// Called after every edit, load and compaction: redraw the map and
+// publish the new version for the background searches
+void app_invalidate_map(void) {
+    app.mapCache.valid = false;
+    graph_store_publish(app.store, &app.graph);
+}
+
+static void map_cache_free(MapRenderCache* cache) {
+    free(cache->edges);
+    free(cache->incidentOffsets);
+    free(cache->incident);
+    free(cache->nameWidths);
+    free(cache->pathNodes);
+    free(cache->visible);
+    free(cache->drawn);
+    free(cache->edgeFrame);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Flag the route's nodes and note at which step each road is traversed
+static void map_cache_mark_path(MapRenderCache* cache) {
+    for (int e = 0; e < cache->edgeCount; e++) {
+        cache->edges[e].pathStep = -1;
+    }
+    memset(cache->pathNodes, 0, cache->nodeCount * sizeof(bool));
+    
+    if (app.currentPath.found) {
+        for (int k = 0; k < app.currentPath.length; k++) {
+            int u = app.currentPath.nodes[k];
+            if (u < 0 || u >= cache->nodeCount) continue;
+            cache->pathNodes[u] = true;
+            if (k + 1 >= app.currentPath.length) continue;
+            
+            int v = app.currentPath.nodes[k + 1];
+            for (int i = cache->incidentOffsets[u]; i < cache->incidentOffsets[u + 1]; i++) {
+                MapEdge* edge = &cache->edges[cache->incident[i]];
+                if ((edge->a == u && edge->b == v) || (edge->a == v && edge->b == u)) {
+                    edge->pathStep = k;
+                    break;
+                }
+            }
+        }
+    }
+    cache->pathValid = true;
+}
+
+// Collect the undirected edge list, per-node incidence and text widths
+static bool map_cache_rebuild(MapRenderCache* cache) {
+    const Graph* graph = &app.graph;
+    int nodeCount = graph->nodeCount;
+    map_cache_free(cache);
+    
+    // Each road is kept once: a one-way edge always, a two-way pair from
+    // its lower endpoint
+    int edgeCount = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        if (!graph->nodes[i].active) continue;
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            const Edge* edge = &graph->edges[i][j];
+            if (!edge->active || !graph->nodes[edge->to].active) continue;
+            if (edge->to < i && graph_has_edge(graph, edge->to, i)) continue;
+            edgeCount++;
+        }
+    }
+    
+    cache->edges = (MapEdge*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(MapEdge));
+    cache->incidentOffsets = (int*)calloc(nodeCount + 1, sizeof(int));
+    cache->incident = (int*)malloc((edgeCount > 0 ? edgeCount * 2 : 1) * sizeof(int));
+    cache->nameWidths = (int*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(int));
+    cache->pathNodes = (bool*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(bool));
+    cache->drawn = (int*)malloc((edgeCount > 0 ? edgeCount : 1) * sizeof(int));
+    cache->edgeFrame = (unsigned int*)calloc(edgeCount > 0 ? edgeCount : 1, sizeof(unsigned int));
+    if (!cache->edges || !cache->incidentOffsets || !cache->incident || !cache->nameWidths ||
+        !cache->pathNodes || !cache->drawn || !cache->edgeFrame) {
+        map_cache_free(cache);
+        return false;
+    }
+    
+    int e = 0;
+    for (int i = 0; i < nodeCount; i++) {
+        const Node* from = &graph->nodes[i];
+        cache->nameWidths[i] = from->active ? MeasureText(from->name, UI_FONT_SIZE_SMALL) : 0;
+        if (cache->nameWidths[i] > cache->maxNameWidth) cache->maxNameWidth = cache->nameWidths[i];
+        if (!from->active) continue;
+        
+        for (int j = 0; j < graph->edgeCounts[i]; j++) {
+            const Edge* edge = &graph->edges[i][j];
+            if (!edge->active || !graph->nodes[edge->to].active) continue;
+            if (edge->to < i && graph_has_edge(graph, edge->to, i)) continue;
+            
+            MapEdge* m = &cache->edges[e++];
+            m->a = i;
+            m->b = edge->to;
+            m->weight = edge->weight;
+            m->pathStep = -1;
+            snprintf(m->label, sizeof(m->label), "%.0f", edge->weight);
+            m->labelWidth = MeasureText(m->label, UI_FONT_SIZE_SMALL);
+            if (m->labelWidth > cache->maxLabelWidth) cache->maxLabelWidth = m->labelWidth;
+            
+            float length = graph_calculate_distance(from, &graph->nodes[edge->to]);
+            if (length > cache->maxEdgeLength) cache->maxEdgeLength = length;
+            cache->incidentOffsets[m->a + 1]++;
+            cache->incidentOffsets[m->b + 1]++;
+        }
+    }
+    cache->edgeCount = edgeCount;
+    cache->nodeCount = nodeCount;
+    
+    // Counts to row starts, then scatter (offsets[v + 1] is v's cursor)
+    for (int i = 0; i < nodeCount; i++) {
+        cache->incidentOffsets[i + 1] += cache->incidentOffsets[i];
+    }
+    for (int k = 0; k < edgeCount; k++) {
+        cache->incident[cache->incidentOffsets[cache->edges[k].a]++] = k;
+        cache->incident[cache->incidentOffsets[cache->edges[k].b]++] = k;
+    }
+    for (int i = nodeCount; i > 0; i--) {
+        cache->incidentOffsets[i] = cache->incidentOffsets[i - 1];
+    }
+    cache->incidentOffsets[0] = 0;
+    
+    cache->valid = true;
+    map_cache_mark_path(cache);
+    return true;
+}
+
+static int compare_ids(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Active nodes inside a world rectangle; sorted by ID on request, so that
+// overlapping nodes stack the same way every frame
+static int map_cache_query(MapRenderCache* cache, float minX, float minY, float maxX, float maxY, bool sorted) {
+    int count = graph_find_nodes_in_rect(&app.graph, minX, minY, maxX, maxY,
+                                         cache->visible, cache->visibleCapacity);
+    if (count > cache->visibleCapacity) {
+        int* visible = (int*)realloc(cache->visible, count * sizeof(int));
+        if (!visible) return 0;
+        cache->visible = visible;
+        cache->visibleCapacity = count;
+        count = graph_find_nodes_in_rect(&app.graph, minX, minY, maxX, maxY,
+                                         cache->visible, cache->visibleCapacity);
+    }
+    if (sorted) qsort(cache->visible, count, sizeof(int), compare_ids);
+    return count;
 }
 
 void app_draw_map(void) {
+    MapRenderCache* cache = &app.mapCache;
+    if (!cache->valid || cache->nodeCount != app.graph.nodeCount) {
+        if (!map_cache_rebuild(cache)) return;
+    } else if (!cache->pathValid) {
+        map_cache_mark_path(cache);
+    }
+    
     // Set scissor to map area
     BeginScissorMode(SIDEBAR_WIDTH, 0, WINDOW_WIDTH - SIDEBAR_WIDTH, WINDOW_HEIGHT);
     
@@ -681,14 +1103,25 @@ void app_draw_map(void) {
         DrawLineV((Vector2){SIDEBAR_WIDTH, y}, (Vector2){WINDOW_WIDTH, y}, gridColor);
     }
     
+    // Visible world rectangle, and how far outside it a node can still
+    // put pixels on screen (hover size, glow, name label)
+    Vector2 viewMin = screen_to_world(SIDEBAR_WIDTH, 0);
+    Vector2 viewMax = screen_to_world(WINDOW_WIDTH, WINDOW_HEIGHT);
+    float nodeRadius = UI_NODE_RADIUS * app.zoom;
+    float pad = (nodeRadius * 1.3f + 8 + UI_FONT_SIZE_SMALL + 12 + cache->maxNameWidth / 2) / app.zoom;
+    
     // Draw explored nodes (A* visualization)
-    if (app.showExploration && app.exploredCount > 0) {
+    const AStarTraceEvent* explored = search_worker_explored(app.search, NULL);
+    if (app.showExploration && app.exploredCount > 0 && explored) {
         int nodesToShow = (int)app.explorationAnimProgress;
         if (nodesToShow > app.exploredCount) nodesToShow = app.exploredCount;
+        float glow = UI_NODE_RADIUS * 2.5f;
         
         for (int i = 0; i < nodesToShow; i++) {
-            Node* node = graph_get_node(&app.graph, app.exploredNodes[i]);
+            Node* node = graph_get_node(&app.graph, explored[i].node);
             if (!node) continue;
+            if (node->x < viewMin.x - glow || node->x > viewMax.x + glow ||
+                node->y < viewMin.y - glow || node->y > viewMax.y + glow) continue;
             
             Vector2 pos = world_to_screen(node->x, node->y);
             float alpha = 0.3f - (float)i / (float)app.exploredCount * 0.2f;
@@ -698,49 +1131,64 @@ void app_draw_map(void) {
         }
     }
     
-    // Draw edges
-    for (int i = 0; i < app.graph.nodeCount; i++) {
-        Node* from = graph_get_node(&app.graph, i);
-        if (!from) continue;
-        
-        for (int j = 0; j < app.graph.edgeCounts[i]; j++) {
-            Edge* edge = &app.graph.edges[i][j];
-            if (!edge->active) continue;
-            
-            Node* to = graph_get_node(&app.graph, edge->to);
-            if (!to) continue;
-            
-            // Only draw edge once (when from < to for bidirectional)
-            if (edge->to < i && graph_has_edge(&app.graph, edge->to, i)) continue;
-            
-            Vector2 p1 = world_to_screen(from->x, from->y);
-            Vector2 p2 = world_to_screen(to->x, to->y);
-            
-            float thickness = 2.0f * app.zoom;
-            Color color = UI_COLOR_EDGE;
-            
-            // Highlight edge if part of path
-            if (app.currentPath.found) {
-                for (int k = 0; k < app.currentPath.length - 1; k++) {
-                    if ((app.currentPath.nodes[k] == i && app.currentPath.nodes[k+1] == edge->to) ||
-                        (app.currentPath.nodes[k] == edge->to && app.currentPath.nodes[k+1] == i)) {
-                        // Skip, will be drawn as path
-                        break;
-                    }
-                }
-            }
-            
-            ui_draw_edge(p1.x, p1.y, p2.x, p2.y, thickness, color);
+    // Collect visible roads: an on-screen road (or its label) has both
+    // endpoints within the longest road's length of the view, so the
+    // incident edges of the nodes there cover it; the bounding-box test
+    // then drops the rest
+    if (++cache->frame == 0) {
+        memset(cache->edgeFrame, 0, (cache->edgeCount > 0 ? cache->edgeCount : 1) * sizeof(unsigned int));
+        cache->frame = 1;
+    }
+    bool showLabels = app.zoom > 0.6f;
+    float labelPad = showLabels ? (float)UI_FONT_SIZE_SMALL / app.zoom : 0.0f;
+    float reach = cache->maxEdgeLength + (showLabels ? (cache->maxLabelWidth / 2 + 4) / app.zoom : 0.0f);
+    int drawnCount = 0;
+    int candidates = map_cache_query(cache, viewMin.x - reach, viewMin.y - reach,
+                                     viewMax.x + reach, viewMax.y + reach, false);
+    
+    for (int c = 0; c < candidates; c++) {
+        int u = cache->visible[c];
+        for (int i = cache->incidentOffsets[u]; i < cache->incidentOffsets[u + 1]; i++) {
+            int e = cache->incident[i];
+            if (cache->edgeFrame[e] == cache->frame) continue;
+            cache->edgeFrame[e] = cache->frame;
             
-            // Draw distance label
-            if (app.zoom > 0.6f) {
-                char distLabel[16];
-                snprintf(distLabel, sizeof(distLabel), "%.0f", edge->weight);
-                Vector2 mid = {(p1.x + p2.x) / 2, (p1.y + p2.y) / 2};
-                int textW = MeasureText(distLabel, UI_FONT_SIZE_SMALL);
-                DrawRectangle((int)(mid.x - textW/2 - 4), (int)(mid.y - 8), textW + 8, 16, UI_COLOR_BG);
-                DrawText(distLabel, (int)(mid.x - textW/2), (int)(mid.y - 6), UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
-            }
+            const Node* a = &app.graph.nodes[cache->edges[e].a];
+            const Node* b = &app.graph.nodes[cache->edges[e].b];
+            float halfLabel = showLabels ? (cache->edges[e].labelWidth / 2 + 4) / app.zoom : 0.0f;
+            if (fminf(a->x, b->x) > viewMax.x + halfLabel || fmaxf(a->x, b->x) < viewMin.x - halfLabel ||
+                fminf(a->y, b->y) > viewMax.y + labelPad || fmaxf(a->y, b->y) < viewMin.y - labelPad) continue;
+            cache->drawn[drawnCount++] = e;
+        }
+    }
+    
+    // Draw edges in one pass of lines, then one pass of labels, so the
+    // line batch is not broken up by text
+    float thickness = 2.0f * app.zoom;
+    for (int k = 0; k < drawnCount; k++) {
+        const MapEdge* edge = &cache->edges[cache->drawn[k]];
+        
+        // Fully animated route steps are covered by the route line
+        if (edge->pathStep >= 0 && app.pathAnimProgress >= edge->pathStep + 1) continue;
+        
+        const Node* a = &app.graph.nodes[edge->a];
+        const Node* b = &app.graph.nodes[edge->b];
+        Vector2 p1 = world_to_screen(a->x, a->y);
+        Vector2 p2 = world_to_screen(b->x, b->y);
+        ui_draw_edge(p1.x, p1.y, p2.x, p2.y, thickness, UI_COLOR_EDGE);
+    }
+    
+    if (showLabels) {
+        for (int k = 0; k < drawnCount; k++) {
+            const MapEdge* edge = &cache->edges[cache->drawn[k]];
+            const Node* a = &app.graph.nodes[edge->a];
+            const Node* b = &app.graph.nodes[edge->b];
+            Vector2 p1 = world_to_screen(a->x, a->y);
+            Vector2 p2 = world_to_screen(b->x, b->y);
+            Vector2 mid = {(p1.x + p2.x) / 2, (p1.y + p2.y) / 2};
+            int textW = edge->labelWidth;
+            DrawRectangle((int)(mid.x - textW/2 - 4), (int)(mid.y - 8), textW + 8, 16, UI_COLOR_BG);
+            DrawText(edge->label, (int)(mid.x - textW/2), (int)(mid.y - 6), UI_FONT_SIZE_SMALL, UI_COLOR_TEXT_DIM);
         }
     }
     
@@ -773,42 +1221,32 @@ void app_draw_map(void) {
     }
     
     // Draw nodes
-    for (int i = 0; i < app.graph.nodeCount; i++) {
-        Node* node = graph_get_node(&app.graph, i);
-        if (!node) continue;
-        
+    int visibleCount = map_cache_query(cache, viewMin.x - pad, viewMin.y - pad,
+                                       viewMax.x + pad, viewMax.y + pad, true);
+    for (int v = 0; v < visibleCount; v++) {
+        int i = cache->visible[v];
+        const Node* node = &app.graph.nodes[i];
         Vector2 pos = world_to_screen(node->x, node->y);
         
         bool isHovered = (i == app.hoveredNode);
         bool isSelected = (i == app.selectedNode);
-        bool isPathNode = false;
+        bool isPathNode = cache->pathNodes[i];
         bool isStart = (i == app.searchStartNode);
         bool isEnd = (i == app.searchEndNode);
         
-        // Check if node is in path
-        if (app.currentPath.found) {
-            for (int j = 0; j < app.currentPath.length; j++) {
-                if (app.currentPath.nodes[j] == i) {
-                    isPathNode = true;
-                    break;
-                }
-            }
-        }
-        
         Color nodeColor = UI_COLOR_NODE;
         if (isStart) nodeColor = UI_COLOR_SECONDARY;
         else if (isEnd) nodeColor = UI_COLOR_DANGER;
         else if (isPathNode) nodeColor = UI_COLOR_PATH;
         else if (isSelected) nodeColor = UI_COLOR_NODE_SELECTED;
         
-        float radius = UI_NODE_RADIUS * app.zoom;
-        ui_draw_node(pos.x, pos.y, radius, nodeColor, isSelected || isPathNode, isHovered);
+        ui_draw_node(pos.x, pos.y, nodeRadius, nodeColor, isSelected || isPathNode, isHovered);
         
         // Draw node name
         if (app.zoom > 0.5f) {
-            int textW = MeasureText(node->name, UI_FONT_SIZE_SMALL);
+            int textW = cache->nameWidths[i];
             float textX = pos.x - textW / 2;
-            float textY = pos.y + radius + 8;
+            float textY = pos.y + nodeRadius + 8;
             
             // Background for text
             DrawRectangle((int)(textX - 4), (int)(textY - 2), textW + 8, UI_FONT_SIZE_SMALL + 4, 
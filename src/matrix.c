@@ -0,0 +1,446 @@
+/**
+ * matrix.c - Many-to-many cost matrix implementation
+ */
+
+#include "matrix.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <stdatomic.h>
+
+// Node -> output columns, as CSR (a node may be listed as several targets)
+typedef struct {
+    int* offsets;
+    int* columns;
+    int distinct;            // Number of nodes with at least one column
+} TargetIndex;
+
+// CH buckets: entries (column, distance to the target) per hierarchy node
+typedef struct {
+    int* offsets;
+    int* columns;
+    float* dist;
+    int count;
+    int capacity;
+    int* nodes;              // Node of each entry before sorting
+} BucketTable;
+
+// State shared by the workers of one matrix call
+typedef struct {
+    const Graph* graph;      // Graph engine
+    const GraphCSR* csr;
+    const TargetIndex* targetIndex;
+    const ContractionHierarchy* ch;  // CH engine
+    const BucketTable* buckets;
+    
+    const int* sources;
+    int nSources;
+    int nTargets;
+    float* out;
+    
+    atomic_int nextSource;   // Rows are claimed one at a time
+    atomic_bool failed;
+} MatrixJob;
+
+// Per-worker state
+typedef struct {
+    MatrixJob* job;
+    Thread thread;
+    void (*row)(MatrixJob* job, AStarContext* ctx, int i);
+} MatrixWorker;
+
+static void matrix_worker_run(void* arg) {
+    MatrixWorker* worker = (MatrixWorker*)arg;
+    MatrixJob* job = worker->job;
+    
+    AStarContext* ctx = astar_context_create(job->csr ? job->csr->nodeCount : job->ch->nodeCount);
+    if (!ctx) {
+        atomic_store(&job->failed, true);
+        return;
+    }
+    
+    while (true) {
+        int i = atomic_fetch_add(&job->nextSource, 1);
+        if (i >= job->nSources) break;
+        worker->row(job, ctx, i);
+    }
+    astar_context_free(ctx);
+}
+
+// Run row() for every source on up to threadCount workers. The calling
+// thread is worker 0; if a thread fails to start, the others pick up its rows.
+static bool matrix_run(MatrixJob* job, int threadCount,
+                       void (*row)(MatrixJob* job, AStarContext* ctx, int i)) {
+    atomic_init(&job->nextSource, 0);
+    atomic_init(&job->failed, false);
+    
+    int workerCount = thread_worker_count(threadCount, job->nSources);
+    MatrixWorker* workers = (MatrixWorker*)calloc(workerCount, sizeof(MatrixWorker));
+    bool* started = (bool*)calloc(workerCount, sizeof(bool));
+    if (!workers || !started) {
+        free(workers);
+        free(started);
+        return false;
+    }
+    
+    for (int w = 0; w < workerCount; w++) {
+        workers[w].job = job;
+        workers[w].row = row;
+    }
+    for (int w = 1; w < workerCount; w++) {
+        started[w] = thread_start(&workers[w].thread, matrix_worker_run, &workers[w]);
+    }
+    matrix_worker_run(&workers[0]);
+    for (int w = 1; w < workerCount; w++) {
+        if (started[w]) thread_join(&workers[w].thread);
+    }
+    
+    free(workers);
+    free(started);
+    return !atomic_load(&job->failed);
+}
+
+// ============================================================================
+// One-to-many Dijkstra
+// ============================================================================
+
+static bool target_index_build(const Graph* graph, const int* targets, int nTargets, TargetIndex* index) {
+    int n = graph->nodeCount;
+    index->offsets = (int*)calloc(n + 1, sizeof(int));
+    index->columns = (int*)malloc((nTargets > 0 ? nTargets : 1) * sizeof(int));
+    index->distinct = 0;
+    if (!index->offsets || !index->columns) return false;
+    
+    // Counting sort of the valid columns by target node
+    for (int j = 0; j < nTargets; j++) {
+        int t = targets[j];
+        if (t < 0 || t >= n || !graph->nodes[t].active) continue;
+        if (index->offsets[t + 1]++ == 0) index->distinct++;
+    }
+    for (int v = 0; v < n; v++) {
+        index->offsets[v + 1] += index->offsets[v];
+    }
+    int* fill = (int*)malloc((n > 0 ? n : 1) * sizeof(int));
+    if (!fill) return false;
+    memcpy(fill, index->offsets, n * sizeof(int));
+    for (int j = 0; j < nTargets; j++) {
+        int t = targets[j];
+        if (t < 0 || t >= n || !graph->nodes[t].active) continue;
+        index->columns[fill[t]++] = j;
+    }
+    free(fill);
+    return true;
+}
+
+// Dijkstra from sources[i], stopping once every target node is settled
+static void dijkstra_row(MatrixJob* job, AStarContext* ctx, int i) {
+    const GraphCSR* csr = job->csr;
+    const TargetIndex* index = job->targetIndex;
+    float* row = job->out + (size_t)i * job->nTargets;
+    for (int j = 0; j < job->nTargets; j++) {
+        row[j] = MATRIX_UNREACHABLE;
+    }
+    
+    int source = job->sources[i];
+    if (source < 0 || source >= csr->nodeCount || !job->graph->nodes[source].active) return;
+    if (!astar_context_reset(ctx, csr->nodeCount, PQ_INDEXED_HEAP, false)) {
+        atomic_store(&job->failed, true);
+        return;
+    }
+    
+    AStarFrontier* f = &ctx->forward;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    
+    f->gScore[source] = 0.0f;
+    f->mark[source] = reached;
+    pq_push(&f->openSet, source, 0.0f);
+    
+    int remaining = index->distinct;
+    while (remaining > 0 && !pq_empty(&f->openSet)) {
+        int u;
+        float g;
+        pq_pop(&f->openSet, &u, &g);
+        f->mark[u] = settled;
+    
+        if (index->offsets[u + 1] > index->offsets[u]) {
+            for (int k = index->offsets[u]; k < index->offsets[u + 1]; k++) {
+                row[index->columns[k]] = g;
+            }
+            remaining--;
+        }
+    
+        for (int e = csr->offsets[u]; e < csr->offsets[u + 1]; e++) {
+            int v = csr->to[e];
+            if (f->mark[v] == settled) continue;
+    
+            float tentative = g + csr->weight[e];
+            if (f->mark[v] != reached || tentative < f->gScore[v]) {
+                f->gScore[v] = tentative;
+                f->mark[v] = reached;
+                pq_update(&f->openSet, v, tentative);
+            }
+        }
+    }
+}
+
+bool graph_distance_matrix(
+    const Graph* graph,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out
+) {
+    return graph_distance_matrix_threads(graph, sources, nSources, targets, nTargets,
+                                         out, MATRIX_AUTO_THREADS);
+}
+
+bool graph_distance_matrix_threads(
+    const Graph* graph,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out,
+    int threadCount
+) {
+    if (!graph || nSources < 0 || nTargets < 0) return false;
+    if (nSources == 0 || nTargets == 0) return true;
+    if (!sources || !targets || !out) return false;
+    
+    // Freeze once so every row runs on the contiguous arrays
+    GraphCSR csr;
+    if (!graph_freeze(graph, &csr)) return false;
+    
+    TargetIndex index = {0};
+    bool ok = target_index_build(graph, targets, nTargets, &index);
+    
+    if (ok) {
+        MatrixJob job = {0};
+        job.graph = graph;
+        job.csr = &csr;
+        job.targetIndex = &index;
+        job.sources = sources;
+        job.nSources = nSources;
+        job.nTargets = nTargets;
+        job.out = out;
+        ok = matrix_run(&job, threadCount, dijkstra_row);
+    }
+    
+    free(index.offsets);
+    free(index.columns);
+    graph_csr_free(&csr);
+    return ok;
+}
+
+// ============================================================================
+// CH bucket many-to-many
+// ============================================================================
+
+// Upward Dijkstra from source with stall-on-demand. The forward search
+// climbs upward edges, the backward one climbs downward edges reversed.
+// visit() is called for every settled, unstalled node.
+static bool ch_upward_search(
+    AStarContext* ctx,
+    const ContractionHierarchy* ch,
+    int source,
+    bool backward,
+    void (*visit)(void* user, int node, float dist),
+    void* user
+) {
+    if (!astar_context_reset(ctx, ch->nodeCount, PQ_INDEXED_HEAP, false)) return false;
+    
+    AStarFrontier* f = &ctx->forward;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    
+    const int* offsets = backward ? ch->downOffsets : ch->upOffsets;
+    const int* adjacent = backward ? ch->downFrom : ch->upTo;
+    const float* weights = backward ? ch->downWeight : ch->upWeight;
+    const int* stallOffsets = backward ? ch->upOffsets : ch->downOffsets;
+    const int* stallAdjacent = backward ? ch->upTo : ch->downFrom;
+    const float* stallWeights = backward ? ch->upWeight : ch->downWeight;
+    
+    f->gScore[source] = 0.0f;
+    f->mark[source] = reached;
+    pq_push(&f->openSet, source, 0.0f);
+    
+    while (!pq_empty(&f->openSet)) {
+        int u;
+        float g;
+        pq_pop(&f->openSet, &u, &g);
+        f->mark[u] = settled;
+    
+        bool stalled = false;
+        for (int e = stallOffsets[u]; e < stallOffsets[u + 1]; e++) {
+            int w = stallAdjacent[e];
+            if (f->mark[w] >= reached && f->gScore[w] + stallWeights[e] < g) {
+                stalled = true;
+                break;
+            }
+        }
+        if (stalled) continue;
+    
+        visit(user, u, g);
+    
+        for (int e = offsets[u]; e < offsets[u + 1]; e++) {
+            int v = adjacent[e];
+            if (f->mark[v] == settled) continue;
+    
+            float tentative = g + weights[e];
+            if (f->mark[v] != reached || tentative < f->gScore[v]) {
+                f->gScore[v] = tentative;
+                f->mark[v] = reached;
+                pq_update(&f->openSet, v, tentative);
+            }
+        }
+    }
+    return true;
+}
+
+// Backward-search visitor: remember (column, distance) at the node
+typedef struct {
+    BucketTable* buckets;
+    int column;
+    bool ok;
+} BucketFill;
+
+static void bucket_add(void* user, int node, float dist) {
+    BucketFill* fill = (BucketFill*)user;
+    BucketTable* buckets = fill->buckets;
+    if (!fill->ok) return;
+    
+    if (buckets->count >= buckets->capacity) {
+        int capacity = buckets->capacity > 0 ? buckets->capacity * 2 : 256;
+        int* nodes = (int*)realloc(buckets->nodes, capacity * sizeof(int));
+        if (nodes) buckets->nodes = nodes;
+        int* columns = (int*)realloc(buckets->columns, capacity * sizeof(int));
+        if (columns) buckets->columns = columns;
+        float* dist = (float*)realloc(buckets->dist, capacity * sizeof(float));
+        if (dist) buckets->dist = dist;
+        if (!nodes || !columns || !dist) {
+            fill->ok = false;
+            return;
+        }
+        buckets->capacity = capacity;
+    }
+    buckets->nodes[buckets->count] = node;
+    buckets->columns[buckets->count] = fill->column;
+    buckets->dist[buckets->count] = dist;
+    buckets->count++;
+}
+
+// Group the collected entries by node (stable counting sort)
+static bool bucket_table_sort(BucketTable* buckets, int nodeCount) {
+    int count = buckets->count;
+    buckets->offsets = (int*)calloc(nodeCount + 1, sizeof(int));
+    int* columns = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    float* dist = (float*)malloc((count > 0 ? count : 1) * sizeof(float));
+    int* fill = (int*)malloc((nodeCount > 0 ? nodeCount : 1) * sizeof(int));
+    if (!buckets->offsets || !columns || !dist || !fill) {
+        free(columns);
+        free(dist);
+        free(fill);
+        return false;
+    }
+    
+    for (int k = 0; k < count; k++) {
+        buckets->offsets[buckets->nodes[k] + 1]++;
+    }
+    for (int v = 0; v < nodeCount; v++) {
+        buckets->offsets[v + 1] += buckets->offsets[v];
+    }
+    memcpy(fill, buckets->offsets, nodeCount * sizeof(int));
+    for (int k = 0; k < count; k++) {
+        int slot = fill[buckets->nodes[k]]++;
+        columns[slot] = buckets->columns[k];
+        dist[slot] = buckets->dist[k];
+    }
+    
+    free(fill);
+    free(buckets->columns);
+    free(buckets->dist);
+    buckets->columns = columns;
+    buckets->dist = dist;
+    return true;
+}
+
+// Forward-search visitor: relax the row through the node's bucket
+typedef struct {
+    const BucketTable* buckets;
+    float* row;
+} BucketScan;
+
+static void bucket_scan(void* user, int node, float dist) {
+    BucketScan* scan = (BucketScan*)user;
+    const BucketTable* buckets = scan->buckets;
+    for (int k = buckets->offsets[node]; k < buckets->offsets[node + 1]; k++) {
+        float cost = dist + buckets->dist[k];
+        float* cell = &scan->row[buckets->columns[k]];
+        if (*cell == MATRIX_UNREACHABLE || cost < *cell) *cell = cost;
+    }
+}
+
+static void ch_bucket_row(MatrixJob* job, AStarContext* ctx, int i) {
+    float* row = job->out + (size_t)i * job->nTargets;
+    for (int j = 0; j < job->nTargets; j++) {
+        row[j] = MATRIX_UNREACHABLE;
+    }
+    
+    int source = job->sources[i];
+    if (source < 0 || source >= job->ch->nodeCount) return;
+    
+    BucketScan scan = { job->buckets, row };
+    if (!ch_upward_search(ctx, job->ch, source, false, bucket_scan, &scan)) {
+        atomic_store(&job->failed, true);
+    }
+}
+
+bool ch_distance_matrix(
+    const ContractionHierarchy* ch,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out,
+    int threadCount
+) {
+    if (!ch || nSources < 0 || nTargets < 0) return false;
+    if (nSources == 0 || nTargets == 0) return true;
+    if (!sources || !targets || !out) return false;
+    
+    BucketTable buckets = {0};
+    AStarContext* ctx = astar_context_create(ch->nodeCount);
+    bool ok = ctx != NULL;
+    
+    // Backward upward search from every target fills the buckets
+    for (int j = 0; j < nTargets && ok; j++) {
+        int t = targets[j];
+        if (t < 0 || t >= ch->nodeCount) continue;
+    
+        BucketFill fill = { &buckets, j, true };
+        ok = ch_upward_search(ctx, ch, t, true, bucket_add, &fill) && fill.ok;
+    }
+    astar_context_free(ctx);
+    
+    if (ok) ok = bucket_table_sort(&buckets, ch->nodeCount);
+    
+    if (ok) {
+        MatrixJob job = {0};
+        job.ch = ch;
+        job.buckets = &buckets;
+        job.sources = sources;
+        job.nSources = nSources;
+        job.nTargets = nTargets;
+        job.out = out;
+        ok = matrix_run(&job, threadCount, ch_bucket_row);
+    }
+    
+    free(buckets.offsets);
+    free(buckets.columns);
+    free(buckets.dist);
+    free(buckets.nodes);
+    return ok;
+}
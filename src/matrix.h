@@ -0,0 +1,77 @@
+/**
+ * matrix.h - Many-to-many travel cost matrices
+ *
+ * Computes the full sources x targets cost table in one call instead of
+ * one point-to-point search per cell. Two engines share the same layout:
+ *
+ * - graph_distance_matrix: one Dijkstra per source over a frozen copy of
+ *   the graph, stopping as soon as every target is settled.
+ * - ch_distance_matrix: bucket-based many-to-many on a contraction
+ *   hierarchy. One backward upward search per target fills per-node
+ *   buckets, then one forward upward search per source scans them.
+ *
+ * Rows (sources) are handed out to worker threads, each with its own
+ * search context. The output is row-major: out[i * nTargets + j] is the
+ * cost from sources[i] to targets[j], or MATRIX_UNREACHABLE.
+ */
+
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "graph.h"
+#include "ch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MATRIX_UNREACHABLE (-1.0f)
+#define MATRIX_AUTO_THREADS 0    // One worker per CPU
+
+/**
+ * Cost matrix by one-to-many Dijkstra
+ *
+ * @param graph     The graph to search (read-only during the call)
+ * @param sources   Source node IDs (may repeat; invalid IDs give unreachable rows)
+ * @param nSources  Number of sources
+ * @param targets   Target node IDs (may repeat)
+ * @param nTargets  Number of targets
+ * @param out       Output, nSources * nTargets floats
+ * @return          false on invalid arguments or allocation failure
+ */
+bool graph_distance_matrix(
+    const Graph* graph,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out
+);
+
+// Same, with an explicit worker count (MATRIX_AUTO_THREADS for one per CPU)
+bool graph_distance_matrix_threads(
+    const Graph* graph,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out,
+    int threadCount
+);
+
+// Cost matrix by CH buckets; same arguments and output as above
+bool ch_distance_matrix(
+    const ContractionHierarchy* ch,
+    const int* sources,
+    int nSources,
+    const int* targets,
+    int nTargets,
+    float* out,
+    int threadCount
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MATRIX_H
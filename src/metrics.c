@@ -0,0 +1,228 @@
+/**
+ * metrics.c - Search counters aggregated over many queries
+ */
+
+#include "metrics.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define METRICS_WORDS (sizeof(SearchMetrics) / sizeof(unsigned long long))
+
+_Static_assert(sizeof(SearchMetrics) % sizeof(unsigned long long) == 0,
+               "SearchMetrics must only hold unsigned long long fields");
+
+static const char* const METRICS_ENGINE_NAMES[METRICS_ENGINE_COUNT] = {
+    "astar", "csr", "ch", "dstar", "crp"
+};
+
+// One SearchMetrics per engine, word by word
+static atomic_ullong metricsGlobal[METRICS_ENGINE_COUNT][METRICS_WORDS];
+
+// ============================================================================
+// Local aggregates
+// ============================================================================
+
+// Bucket with values up to 2^i: 0 for 0 and 1, else the bit length of v - 1
+static int metrics_bucket(unsigned long long value) {
+    int bucket = 0;
+    if (value > 1) {
+        unsigned long long v = value - 1;
+        while (v) {
+            bucket++;
+            v >>= 1;
+        }
+    }
+    return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+static unsigned long long metrics_ns(float ms) {
+    return ms > 0.0f ? (unsigned long long)((double)ms * 1e6) : 0;
+}
+
+static unsigned long long metrics_count(int value) {
+    return value > 0 ? (unsigned long long)value : 0;
+}
+
+void metrics_reset(SearchMetrics* metrics) {
+    if (!metrics) return;
+    memset(metrics, 0, sizeof(*metrics));
+}
+
+void metrics_record(SearchMetrics* metrics, const AStarStats* stats, bool found) {
+    if (!metrics || !stats) return;
+    
+    unsigned long long totalNs = metrics_ns(stats->searchTimeMs);
+    metrics->queries++;
+    metrics->found += found ? 1 : 0;
+    metrics->nodesExplored += metrics_count(stats->nodesExplored);
+    metrics->edgesRelaxed += metrics_count(stats->edgesRelaxed);
+    metrics->edgesSkipped += metrics_count(stats->edgesSkipped);
+    metrics->stalePops += metrics_count(stats->stalePops);
+    metrics->decreaseKeys += metrics_count(stats->decreaseKeys);
+    metrics->siftSteps += metrics_count(stats->siftSteps);
+    metrics->bytesAllocated += metrics_count(stats->bytesAllocated);
+    metrics->setupNs += metrics_ns(stats->setupMs);
+    metrics->searchNs += metrics_ns(stats->searchMs);
+    metrics->reconstructNs += metrics_ns(stats->reconstructMs);
+    metrics->totalNs += totalNs;
+    metrics->latency[metrics_bucket(totalNs / 1000)]++;
+    metrics->explored[metrics_bucket(metrics_count(stats->nodesExplored))]++;
+}
+
+void metrics_merge(SearchMetrics* into, const SearchMetrics* from) {
+    if (!into || !from) return;
+    unsigned long long* dst = (unsigned long long*)into;
+    const unsigned long long* src = (const unsigned long long*)from;
+    for (size_t i = 0; i < METRICS_WORDS; i++) dst[i] += src[i];
+}
+
+double metrics_latency_percentile(const SearchMetrics* metrics, double percentile) {
+    if (!metrics || metrics->queries == 0) return 0.0;
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+    
+    // Rank of the query we want, 1-based
+    unsigned long long rank = (unsigned long long)(percentile / 100.0 * (double)metrics->queries);
+    if (rank < 1) rank = 1;
+    
+    unsigned long long seen = 0;
+    for (int i = 0; i < METRICS_BUCKETS; i++) {
+        seen += metrics->latency[i];
+        if (seen >= rank) return (double)(1ull << i);
+    }
+    return (double)(1ull << (METRICS_BUCKETS - 1));
+}
+
+// ============================================================================
+// Process-wide aggregates
+// ============================================================================
+
+void metrics_record_global(MetricsEngine engine, const AStarStats* stats, bool found) {
+    if ((int)engine < 0 || engine >= METRICS_ENGINE_COUNT || !stats) return;
+    
+    SearchMetrics one;
+    metrics_reset(&one);
+    metrics_record(&one, stats, found);
+    
+    // Most words of a single query are zero (all but two buckets)
+    const unsigned long long* words = (const unsigned long long*)&one;
+    for (size_t i = 0; i < METRICS_WORDS; i++) {
+        if (words[i]) atomic_fetch_add_explicit(&metricsGlobal[engine][i], words[i], memory_order_relaxed);
+    }
+}
+
+void metrics_snapshot_global(MetricsEngine engine, SearchMetrics* out) {
+    if (!out) return;
+    metrics_reset(out);
+    if ((int)engine < 0 || engine >= METRICS_ENGINE_COUNT) return;
+    
+    unsigned long long* words = (unsigned long long*)out;
+    for (size_t i = 0; i < METRICS_WORDS; i++) {
+        words[i] = atomic_load_explicit(&metricsGlobal[engine][i], memory_order_relaxed);
+    }
+}
+
+void metrics_reset_global(void) {
+    for (int e = 0; e < METRICS_ENGINE_COUNT; e++) {
+        for (size_t i = 0; i < METRICS_WORDS; i++) {
+            atomic_store_explicit(&metricsGlobal[e][i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+// ============================================================================
+// Prometheus text format
+// ============================================================================
+
+typedef struct {
+    char* buffer;
+    int size;
+    int length;              // Full length, even past size
+} MetricsWriter;
+
+static void metrics_write(MetricsWriter* writer, const char* format, ...) {
+    int room = writer->size - writer->length;
+    char* at = room > 0 ? writer->buffer + writer->length : NULL;
+    
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(at, room > 0 ? (size_t)room : 0, format, args);
+    va_end(args);
+    if (written > 0) writer->length += written;
+}
+
+// sumOffset names the field holding the sum, reported divided by sumScale
+static void metrics_write_histogram(MetricsWriter* writer, const SearchMetrics* all,
+                                    const char* name, const char* help, size_t bucketsOffset,
+                                    size_t sumOffset, unsigned long long sumScale) {
+    metrics_write(writer, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for (int e = 0; e < METRICS_ENGINE_COUNT; e++) {
+        const SearchMetrics* m = &all[e];
+        const unsigned long long* buckets =
+            (const unsigned long long*)((const char*)m + bucketsOffset);
+        const char* engine = METRICS_ENGINE_NAMES[e];
+    
+        unsigned long long cumulative = 0;
+        for (int i = 0; i < METRICS_BUCKETS - 1; i++) {
+            cumulative += buckets[i];
+            metrics_write(writer, "%s_bucket{engine=\"%s\",le=\"%llu\"} %llu\n",
+                          name, engine, 1ull << i, cumulative);
+        }
+        metrics_write(writer, "%s_bucket{engine=\"%s\",le=\"+Inf\"} %llu\n", name, engine, m->queries);
+        metrics_write(writer, "%s_sum{engine=\"%s\"} %llu\n", name, engine,
+                      *(const unsigned long long*)((const char*)m + sumOffset) / sumScale);
+        metrics_write(writer, "%s_count{engine=\"%s\"} %llu\n", name, engine, m->queries);
+    }
+}
+
+static void metrics_write_counter(MetricsWriter* writer, const SearchMetrics* all,
+                                  const char* name, const char* help, size_t offset) {
+    metrics_write(writer, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for (int e = 0; e < METRICS_ENGINE_COUNT; e++) {
+        metrics_write(writer, "%s{engine=\"%s\"} %llu\n", name, METRICS_ENGINE_NAMES[e],
+                      *(const unsigned long long*)((const char*)&all[e] + offset));
+    }
+}
+
+int metrics_format_global(char* buffer, int size) {
+    MetricsWriter writer = { buffer, buffer ? size : 0, 0 };
+    if (writer.size > 0) buffer[0] = '\0';
+    
+    SearchMetrics all[METRICS_ENGINE_COUNT];
+    for (int e = 0; e < METRICS_ENGINE_COUNT; e++) {
+        metrics_snapshot_global((MetricsEngine)e, &all[e]);
+    }
+    
+    metrics_write_histogram(&writer, all, "routecraft_search_latency_us",
+                            "Search latency in microseconds",
+                            offsetof(SearchMetrics, latency), offsetof(SearchMetrics, totalNs), 1000);
+    metrics_write_histogram(&writer, all, "routecraft_search_nodes_explored",
+                            "Nodes settled per search",
+                            offsetof(SearchMetrics, explored), offsetof(SearchMetrics, nodesExplored), 1);
+    
+    metrics_write_counter(&writer, all, "routecraft_search_found_total",
+                          "Searches that found a route", offsetof(SearchMetrics, found));
+    metrics_write_counter(&writer, all, "routecraft_search_edges_relaxed_total",
+                          "Edges scanned towards unsettled nodes", offsetof(SearchMetrics, edgesRelaxed));
+    metrics_write_counter(&writer, all, "routecraft_search_edges_skipped_total",
+                          "Inactive edges skipped", offsetof(SearchMetrics, edgesSkipped));
+    metrics_write_counter(&writer, all, "routecraft_search_stale_pops_total",
+                          "Open set pops of settled nodes", offsetof(SearchMetrics, stalePops));
+    metrics_write_counter(&writer, all, "routecraft_search_decrease_keys_total",
+                          "Key decreases of queued nodes", offsetof(SearchMetrics, decreaseKeys));
+    metrics_write_counter(&writer, all, "routecraft_search_sift_steps_total",
+                          "Heap levels moved by the open sets", offsetof(SearchMetrics, siftSteps));
+    metrics_write_counter(&writer, all, "routecraft_search_allocated_bytes_total",
+                          "Bytes allocated by searches", offsetof(SearchMetrics, bytesAllocated));
+    metrics_write_counter(&writer, all, "routecraft_search_setup_ns_total",
+                          "Time spent resetting search state", offsetof(SearchMetrics, setupNs));
+    metrics_write_counter(&writer, all, "routecraft_search_loop_ns_total",
+                          "Time spent in search loops", offsetof(SearchMetrics, searchNs));
+    metrics_write_counter(&writer, all, "routecraft_search_reconstruct_ns_total",
+                          "Time spent extracting paths", offsetof(SearchMetrics, reconstructNs));
+    
+    return writer.length;
+}
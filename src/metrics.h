@@ -0,0 +1,92 @@
+/**
+ * metrics.h - Search counters aggregated over many queries
+ *
+ * SearchMetrics sums the AStarStats of any number of queries and keeps
+ * log2 histograms of latency and nodes explored, so percentiles and the
+ * hot-path breakdown can be read for a whole workload rather than one
+ * search. Aggregates built per thread can be merged.
+ *
+ * In builds with ASTAR_COUNTERS every search also records itself into a
+ * process-wide set of aggregates, one per engine, updated with atomic
+ * adds so any thread may search. metrics_format_global renders them in
+ * the Prometheus text format for scraping. Without ASTAR_COUNTERS nothing
+ * records into them and they stay empty.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_BUCKETS 24   // Bucket i holds values up to 2^i (the last one is open)
+
+// Engines with their own process-wide aggregates
+typedef enum {
+    METRICS_ENGINE_ASTAR,    // astar_find_path* on a Graph
+    METRICS_ENGINE_CSR,      // astar_find_path_csr*
+    METRICS_ENGINE_CH,       // ch_find_path*
+    METRICS_ENGINE_DSTAR,    // dstar_find_path
+    METRICS_ENGINE_CRP,      // crp_find_path*
+    METRICS_ENGINE_COUNT
+} MetricsEngine;
+
+// Totals over a set of queries (every field is an unsigned long long, so
+// the global copy can be kept as an array of atomic words)
+typedef struct {
+    unsigned long long queries;
+    unsigned long long found;
+    unsigned long long nodesExplored;
+    unsigned long long edgesRelaxed;
+    unsigned long long edgesSkipped;
+    unsigned long long stalePops;
+    unsigned long long decreaseKeys;
+    unsigned long long siftSteps;
+    unsigned long long bytesAllocated;
+
+    // Time in nanoseconds (phases are often well under a microsecond)
+    unsigned long long setupNs;
+    unsigned long long searchNs;
+    unsigned long long reconstructNs;
+    unsigned long long totalNs;
+
+    unsigned long long latency[METRICS_BUCKETS];   // Queries by searchTimeMs in microseconds
+    unsigned long long explored[METRICS_BUCKETS];  // Queries by nodesExplored
+} SearchMetrics;
+
+// Local aggregates
+void metrics_reset(SearchMetrics* metrics);
+void metrics_record(SearchMetrics* metrics, const AStarStats* stats, bool found);
+void metrics_merge(SearchMetrics* into, const SearchMetrics* from);
+
+/**
+ * Approximate percentile of the latency histogram
+ *
+ * @param percentile  In [0, 100]
+ * @return            Upper bound of the bucket holding it, in microseconds
+ *                    (0 without queries)
+ */
+double metrics_latency_percentile(const SearchMetrics* metrics, double percentile);
+
+// Process-wide aggregates (thread-safe)
+void metrics_record_global(MetricsEngine engine, const AStarStats* stats, bool found);
+void metrics_snapshot_global(MetricsEngine engine, SearchMetrics* out);
+void metrics_reset_global(void);
+
+/**
+ * Render the process-wide aggregates of every engine in the Prometheus
+ * text exposition format
+ *
+ * @return  Length of the full text (like snprintf; the output is
+ *          truncated but terminated when it is >= size)
+ */
+int metrics_format_global(char* buffer, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
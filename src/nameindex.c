@@ -0,0 +1,434 @@
+/**
+ * nameindex.c - Hashed exact and trigram substring name index
+ */
+
+#include "nameindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_INDEX_INITIAL_SLOTS 64
+#define NAME_INDEX_INITIAL_TRIGRAMS 256
+#define NAME_INDEX_BOUNDARY 1    // Pads the start of every name
+
+#define SLOT_EMPTY -1
+#define SLOT_DELETED -2
+
+// Match ranks for name_index_search
+#define RANK_EXACT 0
+#define RANK_PREFIX 1
+#define RANK_SUBSTRING 2
+
+static unsigned char fold_char(char c) {
+    unsigned char u = (unsigned char)c;
+    return (u >= 'A' && u <= 'Z') ? (unsigned char)(u + 32) : u;
+}
+
+// FNV-1a over the case-folded name
+static unsigned int fold_hash(const char* s) {
+    unsigned int h = 2166136261u;
+    for (; *s; s++) {
+        h ^= fold_char(*s);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static bool fold_equal(const char* a, const char* b) {
+    for (; *a && *b; a++, b++) {
+        if (fold_char(*a) != fold_char(*b)) return false;
+    }
+    return *a == *b;
+}
+
+// Rank of name as a match for query, or -1 if it does not contain it
+static int match_rank(const char* name, const char* query, size_t queryLen) {
+    size_t nameLen = strlen(name);
+    if (queryLen > nameLen) return -1;
+    
+    for (size_t j = 0; j + queryLen <= nameLen; j++) {
+        size_t k = 0;
+        while (k < queryLen && fold_char(name[j + k]) == fold_char(query[k])) k++;
+        if (k == queryLen) {
+            if (j > 0) return RANK_SUBSTRING;
+            return queryLen == nameLen ? RANK_EXACT : RANK_PREFIX;
+        }
+    }
+    return -1;
+}
+
+static unsigned int trigram_key(unsigned char a, unsigned char b, unsigned char c) {
+    return ((unsigned int)a << 16) | ((unsigned int)b << 8) | c;
+}
+
+static unsigned int trigram_slot(unsigned int key, int capacity) {
+    return (key * 2654435761u) & (unsigned int)(capacity - 1);
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+NameIndex* name_index_create(void) {
+    NameIndex* index = (NameIndex*)calloc(1, sizeof(NameIndex));
+    if (!index) return NULL;
+    
+    index->slots = (NameSlot*)malloc(NAME_INDEX_INITIAL_SLOTS * sizeof(NameSlot));
+    index->trigrams = (TrigramList*)calloc(NAME_INDEX_INITIAL_TRIGRAMS, sizeof(TrigramList));
+    if (!index->slots || !index->trigrams) {
+        name_index_free(index);
+        return NULL;
+    }
+    
+    for (int i = 0; i < NAME_INDEX_INITIAL_SLOTS; i++) {
+        index->slots[i].nodeId = SLOT_EMPTY;
+    }
+    index->slotCapacity = NAME_INDEX_INITIAL_SLOTS;
+    index->trigramCapacity = NAME_INDEX_INITIAL_TRIGRAMS;
+    return index;
+}
+
+void name_index_free(NameIndex* index) {
+    if (!index) return;
+    if (index->trigrams) {
+        for (int i = 0; i < index->trigramCapacity; i++) {
+            free(index->trigrams[i].ids);
+        }
+    }
+    free(index->trigrams);
+    free(index->slots);
+    free(index);
+}
+
+// ============================================================================
+// Exact-match table
+// ============================================================================
+
+// Rehash the live entries into a table with room for twice as many
+static bool slots_grow(NameIndex* index) {
+    int live = 0;
+    for (int i = 0; i < index->slotCapacity; i++) {
+        if (index->slots[i].nodeId >= 0) live++;
+    }
+    
+    int capacity = NAME_INDEX_INITIAL_SLOTS;
+    while (capacity < live * 4) capacity *= 2;
+    
+    NameSlot* slots = (NameSlot*)malloc(capacity * sizeof(NameSlot));
+    if (!slots) return false;
+    for (int i = 0; i < capacity; i++) {
+        slots[i].nodeId = SLOT_EMPTY;
+    }
+    
+    unsigned int mask = (unsigned int)capacity - 1;
+    for (int i = 0; i < index->slotCapacity; i++) {
+        NameSlot slot = index->slots[i];
+        if (slot.nodeId < 0) continue;
+        unsigned int s = slot.hash & mask;
+        while (slots[s].nodeId != SLOT_EMPTY) s = (s + 1) & mask;
+        slots[s] = slot;
+    }
+    
+    free(index->slots);
+    index->slots = slots;
+    index->slotCapacity = capacity;
+    index->slotUsed = live;
+    return true;
+}
+
+static bool slots_insert(NameIndex* index, unsigned int hash, int nodeId) {
+    // Keep at most half the table used (deleted slots count as used)
+    if ((index->slotUsed + 1) * 2 > index->slotCapacity && !slots_grow(index)) return false;
+    
+    unsigned int mask = (unsigned int)index->slotCapacity - 1;
+    unsigned int s = hash & mask;
+    while (index->slots[s].nodeId != SLOT_EMPTY) s = (s + 1) & mask;
+    
+    index->slots[s].hash = hash;
+    index->slots[s].nodeId = nodeId;
+    index->slotUsed++;
+    return true;
+}
+
+// ============================================================================
+// Trigram lists
+// ============================================================================
+
+static const TrigramList* trigrams_find(const NameIndex* index, unsigned int key) {
+    unsigned int mask = (unsigned int)index->trigramCapacity - 1;
+    unsigned int s = trigram_slot(key, index->trigramCapacity);
+    while (index->trigrams[s].key != 0) {
+        if (index->trigrams[s].key == key) return &index->trigrams[s];
+        s = (s + 1) & mask;
+    }
+    return NULL;
+}
+
+static bool trigrams_grow(NameIndex* index) {
+    int capacity = index->trigramCapacity * 2;
+    TrigramList* lists = (TrigramList*)calloc(capacity, sizeof(TrigramList));
+    if (!lists) return false;
+    
+    unsigned int mask = (unsigned int)capacity - 1;
+    for (int i = 0; i < index->trigramCapacity; i++) {
+        if (index->trigrams[i].key == 0) continue;
+        unsigned int s = trigram_slot(index->trigrams[i].key, capacity);
+        while (lists[s].key != 0) s = (s + 1) & mask;
+        lists[s] = index->trigrams[i];
+    }
+    
+    free(index->trigrams);
+    index->trigrams = lists;
+    index->trigramCapacity = capacity;
+    return true;
+}
+
+static bool trigrams_append(NameIndex* index, unsigned int key, int nodeId) {
+    if ((index->trigramCount + 1) * 2 > index->trigramCapacity && !trigrams_grow(index)) return false;
+    
+    unsigned int mask = (unsigned int)index->trigramCapacity - 1;
+    unsigned int s = trigram_slot(key, index->trigramCapacity);
+    while (index->trigrams[s].key != 0 && index->trigrams[s].key != key) s = (s + 1) & mask;
+    
+    TrigramList* list = &index->trigrams[s];
+    if (list->key == 0) {
+        list->key = key;
+        index->trigramCount++;
+    }
+    
+    // A trigram repeated within one name is only listed once
+    if (list->count > 0 && list->ids[list->count - 1] == nodeId) return true;
+    
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+        int* ids = (int*)realloc(list->ids, capacity * sizeof(int));
+        if (!ids) return false;
+        list->ids = ids;
+        list->capacity = capacity;
+    }
+    list->ids[list->count++] = nodeId;
+    return true;
+}
+
+// ============================================================================
+// Maintenance
+// ============================================================================
+
+bool name_index_add(NameIndex* index, const char* name, int nodeId) {
+    if (!index || !name || nodeId < 0) return false;
+    if (!slots_insert(index, fold_hash(name), nodeId)) return false;
+    
+    // Windows over the boundary-padded folded name
+    unsigned char a = NAME_INDEX_BOUNDARY;
+    unsigned char b = NAME_INDEX_BOUNDARY;
+    for (const char* p = name; *p; p++) {
+        unsigned char c = fold_char(*p);
+        if (!trigrams_append(index, trigram_key(a, b, c), nodeId)) return false;
+        a = b;
+        b = c;
+    }
+    return true;
+}
+
+void name_index_remove(NameIndex* index, const char* name, int nodeId) {
+    if (!index || !name) return;
+    
+    unsigned int hash = fold_hash(name);
+    unsigned int mask = (unsigned int)index->slotCapacity - 1;
+    unsigned int s = hash & mask;
+    while (index->slots[s].nodeId != SLOT_EMPTY) {
+        if (index->slots[s].nodeId == nodeId) {
+            index->slots[s].nodeId = SLOT_DELETED;
+            return;
+        }
+        s = (s + 1) & mask;
+    }
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+static bool node_live(const Graph* graph, int nodeId) {
+    return nodeId >= 0 && nodeId < graph->nodeCount && graph->nodes[nodeId].active;
+}
+
+int name_index_find_exact(const NameIndex* index, const Graph* graph, const char* name) {
+    if (!graph || !name) return -1;
+    
+    if (!index) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            if (graph->nodes[i].active && fold_equal(graph->nodes[i].name, name)) return i;
+        }
+        return -1;
+    }
+    
+    unsigned int hash = fold_hash(name);
+    unsigned int mask = (unsigned int)index->slotCapacity - 1;
+    unsigned int s = hash & mask;
+    int best = -1;
+    
+    // Duplicate names are allowed, so probe the whole cluster
+    while (index->slots[s].nodeId != SLOT_EMPTY) {
+        const NameSlot* slot = &index->slots[s];
+        if (slot->nodeId >= 0 && slot->hash == hash && (best < 0 || slot->nodeId < best) &&
+            node_live(graph, slot->nodeId) && fold_equal(graph->nodes[slot->nodeId].name, name)) {
+            best = slot->nodeId;
+        }
+        s = (s + 1) & mask;
+    }
+    return best;
+}
+
+/**
+ * Shortest posting list that every match must appear on
+ *
+ * Queries of three or more characters use their own trigrams. Shorter
+ * queries can only be narrowed to prefix matches, so *prefixOnly is set
+ * and the caller decides whether that is enough.
+ */
+static const TrigramList* candidate_list(const NameIndex* index, const char* query,
+                                         size_t queryLen, bool* prefixOnly, bool* none) {
+    const TrigramList* best = NULL;
+    *none = false;
+    *prefixOnly = queryLen < 3;
+    
+    if (*prefixOnly) {
+        unsigned char b = fold_char(query[0]);
+        unsigned int key = queryLen == 1 ?
+                           trigram_key(NAME_INDEX_BOUNDARY, NAME_INDEX_BOUNDARY, b) :
+                           trigram_key(NAME_INDEX_BOUNDARY, b, fold_char(query[1]));
+        best = trigrams_find(index, key);
+        *none = best == NULL;
+        return best;
+    }
+    
+    for (size_t i = 0; i + 2 < queryLen; i++) {
+        const TrigramList* list = trigrams_find(index, trigram_key(
+            fold_char(query[i]), fold_char(query[i + 1]), fold_char(query[i + 2])));
+        if (!list) {
+            *none = true;
+            return NULL;
+        }
+        if (!best || list->count < best->count) best = list;
+    }
+    return best;
+}
+
+int name_index_find_partial(const NameIndex* index, const Graph* graph, const char* query) {
+    if (!graph || !query) return -1;
+    
+    size_t queryLen = strlen(query);
+    if (queryLen == 0) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            if (graph->nodes[i].active) return i;
+        }
+        return -1;
+    }
+    
+    if (index && queryLen >= 3) {
+        bool prefixOnly, none;
+        const TrigramList* list = candidate_list(index, query, queryLen, &prefixOnly, &none);
+        if (none) return -1;
+    
+        // Lists are in ID order, so the first hit is the lowest ID
+        for (int i = 0; i < list->count; i++) {
+            int id = list->ids[i];
+            if (node_live(graph, id) && match_rank(graph->nodes[id].name, query, queryLen) >= 0) {
+                return id;
+            }
+        }
+        return -1;
+    }
+    
+    // One or two characters can occur anywhere; scanning is cheap enough
+    // (and the only option without an index)
+    for (int i = 0; i < graph->nodeCount; i++) {
+        if (graph->nodes[i].active && match_rank(graph->nodes[i].name, query, queryLen) >= 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Candidate ordering for name_index_search
+typedef struct {
+    int rank;
+    int length;
+    int nodeId;
+} NameMatch;
+
+static bool match_before(const NameMatch* a, const NameMatch* b) {
+    if (a->rank != b->rank) return a->rank < b->rank;
+    if (a->length != b->length) return a->length < b->length;
+    return a->nodeId < b->nodeId;
+}
+
+// Insert into the sorted top list if it makes the cut
+static void top_insert(NameMatch* top, int* count, int maxResults, NameMatch match) {
+    if (*count == maxResults && !match_before(&match, &top[*count - 1])) return;
+    
+    int i = *count < maxResults ? (*count)++ : *count - 1;
+    while (i > 0 && match_before(&match, &top[i - 1])) {
+        top[i] = top[i - 1];
+        i--;
+    }
+    top[i] = match;
+}
+
+static void top_consider(const Graph* graph, int nodeId, const char* query, size_t queryLen,
+                         NameMatch* top, int* count, int maxResults) {
+    if (!graph->nodes[nodeId].active) return;
+    
+    const char* name = graph->nodes[nodeId].name;
+    int rank = match_rank(name, query, queryLen);
+    if (rank < 0) return;
+    
+    NameMatch match = { rank, (int)strlen(name), nodeId };
+    top_insert(top, count, maxResults, match);
+}
+
+int name_index_search(const NameIndex* index, const Graph* graph, const char* query,
+                      int* results, int maxResults) {
+    if (!graph || !query || !results || maxResults <= 0) return 0;
+    
+    size_t queryLen = strlen(query);
+    if (queryLen == 0) return 0;
+    
+    NameMatch* top = (NameMatch*)malloc(maxResults * sizeof(NameMatch));
+    if (!top) return 0;
+    int count = 0;
+    
+    if (!index) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            top_consider(graph, i, query, queryLen, top, &count, maxResults);
+        }
+    } else {
+        bool prefixOnly, none;
+        const TrigramList* list = candidate_list(index, query, queryLen, &prefixOnly, &none);
+        if (list) {
+            for (int i = 0; i < list->count; i++) {
+                int id = list->ids[i];
+                if (id < graph->nodeCount) top_consider(graph, id, query, queryLen, top, &count, maxResults);
+            }
+        }
+    
+        // Short queries: substring matches rank below every prefix match, so
+        // they are only needed (and scanned for) when prefixes do not fill up
+        if (prefixOnly && count < maxResults) {
+            for (int i = 0; i < graph->nodeCount; i++) {
+                const char* name = graph->nodes[i].name;
+                if (fold_char(name[0]) == fold_char(query[0]) &&
+                    (queryLen == 1 || (name[0] && fold_char(name[1]) == fold_char(query[1])))) {
+                    continue;  // A prefix match, already considered
+                }
+                top_consider(graph, i, query, queryLen, top, &count, maxResults);
+            }
+        }
+    }
+    
+    for (int i = 0; i < count; i++) {
+        results[i] = top[i].nodeId;
+    }
+    free(top);
+    return count;
+}
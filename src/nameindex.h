@@ -0,0 +1,84 @@
+/**
+ * nameindex.h - Case-insensitive name index for graph nodes
+ *
+ * Two structures kept in sync with graph_add_node / graph_remove_node:
+ *
+ * - An open-addressing hash table over case-folded names, for exact
+ *   lookups in O(1) expected time.
+ * - A trigram index: every name is split into overlapping 3-character
+ *   windows (prefixed with two boundary marks, so prefixes of any length
+ *   have trigrams too), each mapping to the IDs of the nodes containing
+ *   it. A substring query only verifies the nodes on the shortest posting
+ *   list among its trigrams.
+ *
+ * Names are not copied; the index reads them from the graph. Removed
+ * nodes leave stale posting entries, which are skipped by checking the
+ * node's active flag.
+ *
+ * The query functions accept a NULL index and fall back to scanning all
+ * nodes, so a graph whose index could not be allocated still works.
+ */
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Exact-match hash slot
+typedef struct {
+    unsigned int hash;
+    int nodeId;              // -1 = empty, -2 = deleted
+} NameSlot;
+
+// Nodes whose folded name contains one trigram, in insertion (ID) order
+typedef struct {
+    unsigned int key;        // Packed trigram, 0 = empty slot
+    int* ids;
+    int count;
+    int capacity;
+} TrigramList;
+
+struct NameIndex {
+    NameSlot* slots;
+    int slotCapacity;        // Power of two
+    int slotUsed;            // Live + deleted slots
+    
+    TrigramList* trigrams;
+    int trigramCapacity;     // Power of two
+    int trigramCount;
+};
+
+// Lifecycle
+NameIndex* name_index_create(void);
+void name_index_free(NameIndex* index);
+
+// Maintenance (name is the node's current name)
+bool name_index_add(NameIndex* index, const char* name, int nodeId);
+void name_index_remove(NameIndex* index, const char* name, int nodeId);
+
+// Lowest active node ID whose name equals name (ignoring case), or -1
+int name_index_find_exact(const NameIndex* index, const Graph* graph, const char* name);
+
+// Lowest active node ID whose name contains query (ignoring case), or -1
+int name_index_find_partial(const NameIndex* index, const Graph* graph, const char* query);
+
+/**
+ * Best matches for a (partial) name, for type-ahead
+ *
+ * Ranked exact matches first, then prefix matches, then other substring
+ * matches; ties go to shorter names, then lower IDs.
+ *
+ * @return  Number of IDs written to results (at most maxResults)
+ */
+int name_index_search(const NameIndex* index, const Graph* graph, const char* query,
+                      int* results, int maxResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NAMEINDEX_H
@@ -0,0 +1,351 @@
+/**
+ * pqueue.c - Priority queue implementation
+ */
+
+#include "pqueue.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// Counter updates; the sifts run either way
+#ifdef ASTAR_COUNTERS
+#define PQ_COUNT_SIFT(pq, steps) ((pq)->siftSteps += (unsigned long long)(steps))
+#define PQ_COUNT_BYTES(pq, bytes) ((pq)->bytesAllocated += (unsigned long long)(bytes))
+#else
+#define PQ_COUNT_SIFT(pq, steps) ((void)(steps))
+#define PQ_COUNT_BYTES(pq, bytes) ((void)(pq))
+#endif
+
+// Lifecycle
+bool pq_init(PriorityQueue* pq, PQType type, int indexCapacity) {
+    if (!pq) return false;
+
+    pq->nodes = NULL;
+    pq->size = 0;
+    pq->capacity = 0;
+    pq->position = NULL;
+    pq->indexCapacity = 0;
+    pq->type = type;
+    pq->buckets = NULL;
+    pq->bucketCount = 0;
+    pq->bucketsUsed = 0;
+    pq->current = 0;
+    pq->bucketWidth = PQ_BUCKET_DEFAULT_WIDTH;
+    pq->bucketOrigin = 0.0f;
+    pq->siftSteps = 0;
+    pq->bytesAllocated = 0;
+
+    return pq_reserve_index(pq, indexCapacity);
+}
+
+void pq_free(PriorityQueue* pq) {
+    if (!pq) return;
+    free(pq->nodes);
+    free(pq->position);
+    for (int i = 0; i < pq->bucketCount; i++) {
+        free(pq->buckets[i].entries);
+    }
+    free(pq->buckets);
+    pq->nodes = NULL;
+    pq->position = NULL;
+    pq->buckets = NULL;
+    pq->bucketCount = 0;
+    pq->bucketsUsed = 0;
+    pq->current = 0;
+    pq->size = 0;
+    pq->capacity = 0;
+    pq->indexCapacity = 0;
+}
+
+// Grow the node ID -> slot index (no-op for lazy heaps and bucket queues)
+bool pq_reserve_index(PriorityQueue* pq, int indexCapacity) {
+    if (!pq) return false;
+    if (pq->type != PQ_INDEXED_HEAP || indexCapacity <= pq->indexCapacity) return true;
+
+    int* position = (int*)realloc(pq->position, indexCapacity * sizeof(int));
+    if (!position) return false;
+
+    for (int i = pq->indexCapacity; i < indexCapacity; i++) {
+        position[i] = -1;
+    }
+    PQ_COUNT_BYTES(pq, (indexCapacity - pq->indexCapacity) * sizeof(int));
+    pq->position = position;
+    pq->indexCapacity = indexCapacity;
+    return true;
+}
+
+// Empty the queue in O(size), leaving the index ready for reuse
+void pq_clear(PriorityQueue* pq) {
+    if (!pq) return;
+    if (pq->type == PQ_INDEXED_HEAP) {
+        for (int i = 0; i < pq->size; i++) {
+            pq->position[pq->nodes[i].nodeId] = -1;
+        }
+    }
+    for (int i = 0; i < pq->bucketsUsed; i++) {
+        pq->buckets[i].size = 0;
+    }
+    pq->bucketsUsed = 0;
+    pq->current = 0;
+    pq->size = 0;
+}
+
+void pq_set_bucket_width(PriorityQueue* pq, float width) {
+    if (!pq || pq->size > 0) return;
+    pq->bucketWidth = (width > 0.0f && width < INFINITY) ? width : PQ_BUCKET_DEFAULT_WIDTH;
+}
+
+static bool pq_grow(PriorityQueue* pq) {
+    int capacity = pq->capacity > 0 ? pq->capacity * 2 : 64;
+    PQNode* nodes = (PQNode*)realloc(pq->nodes, capacity * sizeof(PQNode));
+    if (!nodes) return false;
+    PQ_COUNT_BYTES(pq, (capacity - pq->capacity) * sizeof(PQNode));
+    pq->nodes = nodes;
+    pq->capacity = capacity;
+    return true;
+}
+
+// Place an entry in slot idx, keeping the position index (if any) in sync
+static void pq_place(PQNode* heap, int* position, int idx, PQNode entry) {
+    heap[idx] = entry;
+    if (position) position[entry.nodeId] = idx;
+}
+
+// Move the entry at idx towards the root (hole-based, one write per level);
+// returns the number of levels moved
+static int pq_sift_up(PQNode* heap, int* position, int idx) {
+    PQNode entry = heap[idx];
+    int steps = 0;
+    while (idx > 0) {
+        int parent = (idx - 1) / 2;
+        if (entry.key < heap[parent].key) {
+            pq_place(heap, position, idx, heap[parent]);
+            idx = parent;
+            steps++;
+        } else {
+            break;
+        }
+    }
+    pq_place(heap, position, idx, entry);
+    return steps;
+}
+
+// Move the entry at idx towards the leaves
+static int pq_sift_down(PQNode* heap, int size, int* position, int idx) {
+    PQNode entry = heap[idx];
+    int steps = 0;
+    while (true) {
+        int smallest = 2 * idx + 1;
+        if (smallest >= size) break;
+
+        int right = smallest + 1;
+        if (right < size && heap[right].key < heap[smallest].key) {
+            smallest = right;
+        }
+        if (heap[smallest].key < entry.key) {
+            pq_place(heap, position, idx, heap[smallest]);
+            idx = smallest;
+            steps++;
+        } else {
+            break;
+        }
+    }
+    pq_place(heap, position, idx, entry);
+    return steps;
+}
+
+static void pq_heapify_up(PriorityQueue* pq, int idx) {
+    PQ_COUNT_SIFT(pq, pq_sift_up(pq->nodes, pq->position, idx));
+}
+
+static void pq_heapify_down(PriorityQueue* pq, int idx) {
+    PQ_COUNT_SIFT(pq, pq_sift_down(pq->nodes, pq->size, pq->position, idx));
+}
+
+// Bucket queue: only the bucket being drained is heap-ordered; later
+// buckets collect unordered appends until the queue reaches them
+static bool pq_bucket_append(PriorityQueue* pq, PQBucket* bucket, PQNode entry) {
+    if (bucket->size >= bucket->capacity) {
+        int capacity = bucket->capacity > 0 ? bucket->capacity * 2 : 16;
+        PQNode* entries = (PQNode*)realloc(bucket->entries, capacity * sizeof(PQNode));
+        if (!entries) return false;
+        PQ_COUNT_BYTES(pq, (capacity - bucket->capacity) * sizeof(PQNode));
+        bucket->entries = entries;
+        bucket->capacity = capacity;
+    }
+    bucket->entries[bucket->size++] = entry;
+    return true;
+}
+
+// Bucket of a key, never before the current one
+static int pq_bucket_index(const PriorityQueue* pq, float key) {
+    float offset = (key - pq->bucketOrigin) / pq->bucketWidth;
+    if (!(offset >= (float)pq->current)) return pq->current;  // Also catches NaN
+    if (offset >= (float)(PQ_BUCKET_LIMIT - 1)) return PQ_BUCKET_LIMIT - 1;
+    return (int)offset;
+}
+
+static bool pq_bucket_reserve(PriorityQueue* pq, int index) {
+    if (index < pq->bucketCount) return true;
+
+    int count = pq->bucketCount > 0 ? pq->bucketCount : 64;
+    while (count <= index) count *= 2;
+    if (count > PQ_BUCKET_LIMIT) count = PQ_BUCKET_LIMIT;
+
+    PQBucket* buckets = (PQBucket*)realloc(pq->buckets, count * sizeof(PQBucket));
+    if (!buckets) return false;
+    memset(buckets + pq->bucketCount, 0, (count - pq->bucketCount) * sizeof(PQBucket));
+    PQ_COUNT_BYTES(pq, (count - pq->bucketCount) * sizeof(PQBucket));
+    pq->buckets = buckets;
+    pq->bucketCount = count;
+    return true;
+}
+
+static bool pq_bucket_push(PriorityQueue* pq, int nodeId, float key) {
+    // An empty queue starts over at the new key
+    if (pq->size == 0) {
+        for (int i = 0; i < pq->bucketsUsed; i++) pq->buckets[i].size = 0;
+        pq->bucketsUsed = 0;
+        pq->current = 0;
+        pq->bucketOrigin = key;
+    }
+
+    int index = pq_bucket_index(pq, key);
+    if (!pq_bucket_reserve(pq, index)) return false;
+
+    PQBucket* bucket = &pq->buckets[index];
+    PQNode entry = { nodeId, key };
+    if (!pq_bucket_append(pq, bucket, entry)) return false;
+    if (index == pq->current) PQ_COUNT_SIFT(pq, pq_sift_up(bucket->entries, NULL, bucket->size - 1));
+    if (index >= pq->bucketsUsed) pq->bucketsUsed = index + 1;
+    pq->size++;
+    return true;
+}
+
+// Move to the next non-empty bucket and heap-order it (bottom-up, O(n))
+static void pq_bucket_advance(PriorityQueue* pq) {
+    while (pq->buckets[pq->current].size == 0) pq->current++;
+
+    PQBucket* bucket = &pq->buckets[pq->current];
+    for (int i = bucket->size / 2 - 1; i >= 0; i--) {
+        PQ_COUNT_SIFT(pq, pq_sift_down(bucket->entries, bucket->size, NULL, i));
+    }
+}
+
+static bool pq_bucket_pop(PriorityQueue* pq, int* nodeId, float* key) {
+    PQBucket* bucket = &pq->buckets[pq->current];
+    if (bucket->size == 0) {
+        pq_bucket_advance(pq);
+        bucket = &pq->buckets[pq->current];
+    }
+
+    *nodeId = bucket->entries[0].nodeId;
+    *key = bucket->entries[0].key;
+    bucket->size--;
+    if (bucket->size > 0) {
+        bucket->entries[0] = bucket->entries[bucket->size];
+        PQ_COUNT_SIFT(pq, pq_sift_down(bucket->entries, bucket->size, NULL, 0));
+    }
+    pq->size--;
+    return true;
+}
+
+// Minimum without advancing: the current heap's root, or a scan of the
+// next non-empty bucket
+static PQNode pq_bucket_peek(const PriorityQueue* pq) {
+    int index = pq->current;
+    while (pq->buckets[index].size == 0) index++;
+
+    const PQBucket* bucket = &pq->buckets[index];
+    PQNode best = bucket->entries[0];
+    if (index == pq->current) return best;
+
+    for (int i = 1; i < bucket->size; i++) {
+        if (bucket->entries[i].key < best.key) best = bucket->entries[i];
+    }
+    return best;
+}
+
+// Insert a new entry. In indexed mode the node must not already be queued.
+bool pq_push(PriorityQueue* pq, int nodeId, float key) {
+    if (pq->type == PQ_BUCKET_QUEUE) return pq_bucket_push(pq, nodeId, key);
+    if (pq->size >= pq->capacity && !pq_grow(pq)) return false;
+    if (pq->type == PQ_INDEXED_HEAP && nodeId >= pq->indexCapacity) return false;
+
+    pq->nodes[pq->size].nodeId = nodeId;
+    pq->nodes[pq->size].key = key;
+    pq->size++;
+    pq_heapify_up(pq, pq->size - 1);
+    return true;
+}
+
+// Insert the node, or lower its key if it is already queued.
+// Lazy heaps and bucket queues simply push a duplicate; the older entry
+// becomes stale.
+bool pq_update(PriorityQueue* pq, int nodeId, float key) {
+    if (pq->type == PQ_INDEXED_HEAP && nodeId < pq->indexCapacity) {
+        int idx = pq->position[nodeId];
+        if (idx >= 0) {
+            if (key < pq->nodes[idx].key) {
+                pq->nodes[idx].key = key;
+                pq_heapify_up(pq, idx);
+            }
+            return true;
+        }
+    }
+    return pq_push(pq, nodeId, key);
+}
+
+// Move a queued node to an arbitrary new key. Returns false if the node is
+// not queued or the heap is not indexed.
+bool pq_set_key(PriorityQueue* pq, int nodeId, float key) {
+    if (!pq_contains(pq, nodeId)) return false;
+
+    int idx = pq->position[nodeId];
+    float old = pq->nodes[idx].key;
+    pq->nodes[idx].key = key;
+    if (key < old) {
+        pq_heapify_up(pq, idx);
+    } else {
+        pq_heapify_down(pq, idx);
+    }
+    return true;
+}
+
+bool pq_pop(PriorityQueue* pq, int* nodeId, float* key) {
+    if (pq->size == 0) return false;
+    if (pq->type == PQ_BUCKET_QUEUE) return pq_bucket_pop(pq, nodeId, key);
+
+    *nodeId = pq->nodes[0].nodeId;
+    *key = pq->nodes[0].key;
+    if (pq->position) pq->position[*nodeId] = -1;
+
+    pq->size--;
+    if (pq->size > 0) {
+        pq->nodes[0] = pq->nodes[pq->size];
+        pq_heapify_down(pq, 0);
+    }
+    return true;
+}
+
+bool pq_peek(const PriorityQueue* pq, int* nodeId, float* key) {
+    if (pq->size == 0) return false;
+    if (pq->type == PQ_BUCKET_QUEUE) {
+        PQNode top = pq_bucket_peek(pq);
+        *nodeId = top.nodeId;
+        *key = top.key;
+        return true;
+    }
+    *nodeId = pq->nodes[0].nodeId;
+    *key = pq->nodes[0].key;
+    return true;
+}
+
+bool pq_contains(const PriorityQueue* pq, int nodeId) {
+    return pq->type == PQ_INDEXED_HEAP && nodeId >= 0 && nodeId < pq->indexCapacity &&
+           pq->position[nodeId] >= 0;
+}
+
+bool pq_empty(const PriorityQueue* pq) {
+    return pq->size == 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * pqueue.h - Priority queues for graph search
+ *
+ * A binary min-heap of (node ID, key) entries with two decrease-key
+ * strategies, so search loops can pick (and benchmark) either one:
+ *
+ * - PQ_INDEXED_HEAP: every node is queued at most once. A position index
+ *   maps node IDs to heap slots, making decrease-key an O(log n) sift-up.
+ * - PQ_LAZY_HEAP: decrease-key pushes a duplicate entry instead. The heap
+ *   may hold stale entries, which the caller skips when they are popped.
+ *
+ * PQ_BUCKET_QUEUE is a Dial-style bucket queue for searches whose keys
+ * grow steadily (Dijkstra, A* with a consistent heuristic). Keys are
+ * bucketed by floor((key - first key) / bucketWidth); pushes into later
+ * buckets are O(1) appends, and only the bucket being drained is kept as
+ * a small binary heap, built when the queue reaches it. Pops are exact
+ * for any keys: one below the current bucket simply joins its heap. The
+ * queue is fastest when each bucket holds only a few entries; the default
+ * width of 1 suits integer-like road lengths. Decrease-key pushes
+ * duplicates as in lazy mode.
+ *
+ * The heap grows on demand. The position index is sized for node IDs in
+ * [0, indexCapacity) and is only allocated in indexed mode.
+ *
+ * Builds with ASTAR_COUNTERS keep running totals of sift steps and bytes
+ * allocated (see AStarStats); otherwise they stay 0.
+ */
+
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decrease-key strategy
+typedef enum {
+    PQ_INDEXED_HEAP,         // Position-indexed heap, one entry per node
+    PQ_LAZY_HEAP,            // Duplicates on decrease-key, stale pops skipped
+    PQ_BUCKET_QUEUE          // Bucket queue, duplicates like PQ_LAZY_HEAP
+} PQType;
+
+#define PQ_BUCKET_DEFAULT_WIDTH 1.0f   // Key range per bucket
+#define PQ_BUCKET_LIMIT (1 << 20)      // Keys past the last bucket share it
+
+// Heap entry
+typedef struct {
+    int nodeId;
+    float key;               // Priority (f = g + h for A*)
+} PQNode;
+
+// One bucket of a bucket queue (a heap once it is being drained)
+typedef struct {
+    PQNode* entries;
+    int size;
+    int capacity;
+} PQBucket;
+
+// Min-heap priority queue
+typedef struct {
+    PQNode* nodes;
+    int size;                // Entries queued (in all buckets for bucket queues)
+    int capacity;
+
+    int* position;           // Node ID -> heap slot, -1 when not queued
+    int indexCapacity;
+    PQType type;
+
+    // Bucket queue state (PQ_BUCKET_QUEUE only)
+    PQBucket* buckets;
+    int bucketCount;         // Buckets allocated
+    int bucketsUsed;         // One past the highest bucket touched since the last clear
+    int current;             // Bucket being drained (its entries form a heap)
+    float bucketWidth;
+    float bucketOrigin;      // Key at the start of bucket 0
+
+    // Running totals since pq_init (ASTAR_COUNTERS builds only)
+    unsigned long long siftSteps;       // Levels entries moved while sifting
+    unsigned long long bytesAllocated;  // Bytes requested by growth
+} PriorityQueue;
+
+// Lifecycle
+bool pq_init(PriorityQueue* pq, PQType type, int indexCapacity);
+void pq_free(PriorityQueue* pq);
+bool pq_reserve_index(PriorityQueue* pq, int indexCapacity);
+void pq_clear(PriorityQueue* pq);
+void pq_set_bucket_width(PriorityQueue* pq, float width);  // Empty queues only (<= 0: default)
+
+// Operations
+bool pq_push(PriorityQueue* pq, int nodeId, float key);
+bool pq_update(PriorityQueue* pq, int nodeId, float key);  // Push or decrease-key
+bool pq_set_key(PriorityQueue* pq, int nodeId, float key); // Raise or lower (indexed only)
+bool pq_pop(PriorityQueue* pq, int* nodeId, float* key);
+bool pq_peek(const PriorityQueue* pq, int* nodeId, float* key);
+bool pq_contains(const PriorityQueue* pq, int nodeId);     // Indexed mode only
+bool pq_empty(const PriorityQueue* pq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PQUEUE_H
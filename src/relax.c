@@ -0,0 +1,215 @@
+/**
+ * relax.c - Vectorized edge relaxation kernel for CSR searches
+ */
+
+#include "relax.h"
+#include <math.h>
+
+#if !defined(RELAX_NO_SIMD) && defined(__AVX2__)
+#define RELAX_AVX2
+#include <immintrin.h>
+#elif !defined(RELAX_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || \
+                                  (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define RELAX_SSE2
+#include <emmintrin.h>
+#elif !defined(RELAX_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#define RELAX_NEON
+#include <arm_neon.h>
+#endif
+
+// ============================================================================
+// Scalar heuristics (tails and the fallback kernels)
+// ============================================================================
+
+// Same operations, in the same order, as heuristic_xy in astar.c, so the
+// kernels produce the keys the plain loop would
+static float relax_euclidean(float dx, float dy) {
+    return sqrtf(dx * dx + dy * dy);
+}
+
+static float relax_manhattan(float dx, float dy) {
+    return fabsf(dx) + fabsf(dy);
+}
+
+static float relax_chebyshev(float dx, float dy) {
+    return fmaxf(fabsf(dx), fabsf(dy));
+}
+
+#define RELAX_SCALAR_LOOP(start, combine) \
+    for (int i = (start); i < count; i++) { \
+        int v = to[i]; \
+        float h = combine(kernel->goalX - kernel->x[v], kernel->goalY - kernel->y[v]); \
+        g[i] = baseG + weight[i]; \
+        f[i] = g[i] + h * kernel->weight; \
+    }
+
+// ============================================================================
+// Vector kernels
+// ============================================================================
+
+// Each target provides VEC, the lane count and the handful of operations
+// the heuristics need; RELAX_DEFINE_KERNEL then stamps out one function
+// per heuristic
+#if defined(RELAX_AVX2)
+
+#define RELAX_ISA "avx2"
+#define RELAX_LANES 8
+typedef __m256 RelaxVec;
+#define VEC_SET1(v) _mm256_set1_ps(v)
+#define VEC_LOAD(p) _mm256_loadu_ps(p)
+#define VEC_STORE(p, v) _mm256_storeu_ps((p), (v))
+#define VEC_ADD(a, b) _mm256_add_ps((a), (b))
+#define VEC_SUB(a, b) _mm256_sub_ps((a), (b))
+#define VEC_MUL(a, b) _mm256_mul_ps((a), (b))
+#define VEC_MAX(a, b) _mm256_max_ps((a), (b))
+#define VEC_SQRT(a) _mm256_sqrt_ps(a)
+#define VEC_ABS(a) _mm256_andnot_ps(_mm256_set1_ps(-0.0f), (a))
+
+static RelaxVec relax_gather(const float* base, const int* index) {
+    return _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)index), 4);
+}
+
+#elif defined(RELAX_SSE2)
+
+#define RELAX_ISA "sse2"
+#define RELAX_LANES 4
+typedef __m128 RelaxVec;
+#define VEC_SET1(v) _mm_set1_ps(v)
+#define VEC_LOAD(p) _mm_loadu_ps(p)
+#define VEC_STORE(p, v) _mm_storeu_ps((p), (v))
+#define VEC_ADD(a, b) _mm_add_ps((a), (b))
+#define VEC_SUB(a, b) _mm_sub_ps((a), (b))
+#define VEC_MUL(a, b) _mm_mul_ps((a), (b))
+#define VEC_MAX(a, b) _mm_max_ps((a), (b))
+#define VEC_SQRT(a) _mm_sqrt_ps(a)
+#define VEC_ABS(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+
+// No gather instruction; the lanes are loaded one by one
+static RelaxVec relax_gather(const float* base, const int* index) {
+    return _mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]]);
+}
+
+#elif defined(RELAX_NEON)
+
+#define RELAX_ISA "neon"
+#define RELAX_LANES 4
+typedef float32x4_t RelaxVec;
+#define VEC_SET1(v) vdupq_n_f32(v)
+#define VEC_LOAD(p) vld1q_f32(p)
+#define VEC_STORE(p, v) vst1q_f32((p), (v))
+#define VEC_ADD(a, b) vaddq_f32((a), (b))
+#define VEC_SUB(a, b) vsubq_f32((a), (b))
+#define VEC_MUL(a, b) vmulq_f32((a), (b))
+#define VEC_MAX(a, b) vmaxq_f32((a), (b))
+#define VEC_SQRT(a) vsqrtq_f32(a)
+#define VEC_ABS(a) vabsq_f32(a)
+
+static RelaxVec relax_gather(const float* base, const int* index) {
+    float lanes[4] = { base[index[0]], base[index[1]], base[index[2]], base[index[3]] };
+    return vld1q_f32(lanes);
+}
+
+#else
+
+#define RELAX_ISA "scalar"
+#define RELAX_LANES 0
+
+#endif
+
+#if RELAX_LANES > 0
+
+#define VEC_EUCLIDEAN(dx, dy) VEC_SQRT(VEC_ADD(VEC_MUL(dx, dx), VEC_MUL(dy, dy)))
+#define VEC_MANHATTAN(dx, dy) VEC_ADD(VEC_ABS(dx), VEC_ABS(dy))
+#define VEC_CHEBYSHEV(dx, dy) VEC_MAX(VEC_ABS(dx), VEC_ABS(dy))
+
+#define RELAX_DEFINE_KERNEL(name, vectorCombine, scalarCombine) \
+    static void name(const RelaxKernel* kernel, const int* to, const float* weight, \
+                     int count, float baseG, float* g, float* f) { \
+        RelaxVec goalX = VEC_SET1(kernel->goalX); \
+        RelaxVec goalY = VEC_SET1(kernel->goalY); \
+        RelaxVec scale = VEC_SET1(kernel->weight); \
+        RelaxVec base = VEC_SET1(baseG); \
+        int i = 0; \
+        for (; i + RELAX_LANES <= count; i += RELAX_LANES) { \
+            RelaxVec dx = VEC_SUB(goalX, relax_gather(kernel->x, to + i)); \
+            RelaxVec dy = VEC_SUB(goalY, relax_gather(kernel->y, to + i)); \
+            RelaxVec h = vectorCombine(dx, dy); \
+            RelaxVec tentative = VEC_ADD(base, VEC_LOAD(weight + i)); \
+            VEC_STORE(g + i, tentative); \
+            VEC_STORE(f + i, VEC_ADD(tentative, VEC_MUL(h, scale))); \
+        } \
+        RELAX_SCALAR_LOOP(i, scalarCombine) \
+    }
+
+#else
+
+#define RELAX_DEFINE_KERNEL(name, vectorCombine, scalarCombine) \
+    static void name(const RelaxKernel* kernel, const int* to, const float* weight, \
+                     int count, float baseG, float* g, float* f) { \
+        RELAX_SCALAR_LOOP(0, scalarCombine) \
+    }
+
+#endif
+
+RELAX_DEFINE_KERNEL(relax_run_euclidean, VEC_EUCLIDEAN, relax_euclidean)
+RELAX_DEFINE_KERNEL(relax_run_manhattan, VEC_MANHATTAN, relax_manhattan)
+RELAX_DEFINE_KERNEL(relax_run_chebyshev, VEC_CHEBYSHEV, relax_chebyshev)
+
+// Dijkstra: the key is just g
+static void relax_run_zero(const RelaxKernel* kernel, const int* to, const float* weight,
+                           int count, float baseG, float* g, float* f) {
+    (void)kernel;
+    (void)to;
+    for (int i = 0; i < count; i++) {
+        g[i] = baseG + weight[i];
+        f[i] = g[i];
+    }
+}
+
+// ALT bounds are per-node table lookups; nothing to vectorize
+static void relax_run_landmarks(const RelaxKernel* kernel, const int* to, const float* weight,
+                                int count, float baseG, float* g, float* f) {
+    for (int i = 0; i < count; i++) {
+        float h = landmarks_lower_bound(kernel->landmarks, to[i], kernel->goalId);
+        g[i] = baseG + weight[i];
+        f[i] = g[i] + h * kernel->weight;
+    }
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void relax_kernel_init(RelaxKernel* kernel, const AStarConfig* config,
+                       const float* x, const float* y, int goalId) {
+    kernel->x = x;
+    kernel->y = y;
+    kernel->goalX = x[goalId];
+    kernel->goalY = y[goalId];
+    kernel->weight = config->heuristicWeight;
+    kernel->goalId = goalId;
+    kernel->landmarks = config->landmarks;
+    
+    switch (config->heuristic) {
+        case HEURISTIC_EUCLIDEAN:
+            kernel->run = relax_run_euclidean;
+            break;
+        case HEURISTIC_MANHATTAN:
+            kernel->run = relax_run_manhattan;
+            break;
+        case HEURISTIC_CHEBYSHEV:
+            kernel->run = relax_run_chebyshev;
+            break;
+        case HEURISTIC_LANDMARKS:
+            kernel->run = relax_run_landmarks;
+            break;
+        case HEURISTIC_ZERO:
+        default:
+            kernel->run = relax_run_zero;
+            break;
+    }
+}
+
+const char* relax_kernel_isa(void) {
+    return RELAX_ISA;
+}
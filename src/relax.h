@@ -0,0 +1,66 @@
+/**
+ * relax.h - Vectorized edge relaxation kernel for CSR searches
+ *
+ * Scores a run of edges out of one node in a single call: for each edge
+ * i it writes the tentative g = baseG + weight[i] and the open-set key
+ * f = g + w * h(to[i], goal). Neighbour coordinates are gathered from the
+ * dense x/y arrays and 4 (SSE2, NEON) or 8 (AVX2) edges are evaluated per
+ * instruction; a scalar loop handles the tail and other targets.
+ *
+ * The heuristic is resolved once, when the kernel is set up for a query,
+ * instead of being switched on for every edge. Landmark bounds are table
+ * lookups and always take the scalar path.
+ *
+ * The instruction set is chosen at compile time from the target flags
+ * (e.g. build with NATIVE=1 for AVX2 on machines that have it). Define
+ * RELAX_NO_SIMD to force the scalar kernel.
+ */
+
+#ifndef RELAX_H
+#define RELAX_H
+
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RELAX_BLOCK 64               // Most edges scored per kernel call
+#define RELAX_MIN_EDGES 8            // Shorter rows are cheaper to score inline
+
+typedef struct RelaxKernel RelaxKernel;
+
+typedef void (*RelaxFunction)(const RelaxKernel* kernel, const int* to, const float* weight,
+                              int count, float baseG, float* g, float* f);
+
+// Per-query kernel state
+struct RelaxKernel {
+    RelaxFunction run;
+    const float* x;                  // Node coordinates, indexed by node ID
+    const float* y;
+    float goalX;
+    float goalY;
+    float weight;                    // AStarConfig.heuristicWeight
+    int goalId;
+    const LandmarkTable* landmarks;
+};
+
+/**
+ * Pick the kernel for config's heuristic towards goalId
+ *
+ * Then call kernel->run(kernel, to, weight, count, baseG, g, f) per row
+ * chunk of at most RELAX_BLOCK edges: to/weight are the edges' targets and
+ * weights, baseG the g of the node being expanded, and g/f receive the
+ * tentative g and the open-set key of each edge.
+ */
+void relax_kernel_init(RelaxKernel* kernel, const AStarConfig* config,
+                       const float* x, const float* y, int goalId);
+
+// Instruction set the kernels were built for ("avx2", "sse2", "neon" or "scalar")
+const char* relax_kernel_isa(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RELAX_H
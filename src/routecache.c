@@ -0,0 +1,276 @@
+/**
+ * routecache.c - LRU cache of route results
+ */
+
+#include "routecache.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ============================================================================
+// Keys
+// ============================================================================
+
+// Landmarks only matter for the heuristic that reads them
+static const LandmarkTable* route_cache_landmarks(const AStarConfig* config) {
+    return config->heuristic == HEURISTIC_LANDMARKS ? config->landmarks : NULL;
+}
+
+// Ties between equal-cost routes can break differently per bucket width
+static float route_cache_bucket_width(const AStarConfig* config) {
+    return config->openSet == PQ_BUCKET_QUEUE ? config->bucketWidth : 0.0f;
+}
+
+static unsigned int route_cache_hash(const Graph* graph, int startId, int goalId,
+                                     const AStarConfig* config) {
+    uint32_t weightBits;
+    memcpy(&weightBits, &config->heuristicWeight, sizeof(weightBits));
+    
+    uint64_t h = (uint64_t)(uintptr_t)graph;
+    h = h * 0x9E3779B97F4A7C15ull + (uint32_t)startId;
+    h = h * 0x9E3779B97F4A7C15ull + (uint32_t)goalId;
+    h = h * 0x9E3779B97F4A7C15ull + weightBits;
+    h = h * 0x9E3779B97F4A7C15ull + (uint32_t)config->heuristic * 4u +
+        (uint32_t)config->openSet * 2u + (config->bidirectional ? 1u : 0u);
+    h = h * 0x9E3779B97F4A7C15ull + (uint64_t)(uintptr_t)route_cache_landmarks(config);
+    return (unsigned int)(h ^ (h >> 29) ^ (h >> 47));
+}
+
+static bool route_cache_matches(const RouteCacheEntry* entry, const Graph* graph,
+                                int startId, int goalId, const AStarConfig* config) {
+    return entry->graph == graph &&
+           entry->startId == startId &&
+           entry->goalId == goalId &&
+           entry->heuristic == config->heuristic &&
+           entry->heuristicWeight == config->heuristicWeight &&
+           entry->openSet == config->openSet &&
+           entry->bucketWidth == route_cache_bucket_width(config) &&
+           entry->bidirectional == config->bidirectional &&
+           entry->landmarks == route_cache_landmarks(config);
+}
+
+// ============================================================================
+// LRU list and buckets
+// ============================================================================
+
+static void route_cache_unlink(RouteCache* cache, int index) {
+    RouteCacheEntry* entry = &cache->entries[index];
+    if (entry->prev >= 0) cache->entries[entry->prev].next = entry->next;
+    else cache->head = entry->next;
+    if (entry->next >= 0) cache->entries[entry->next].prev = entry->prev;
+    else cache->tail = entry->prev;
+    entry->prev = -1;
+    entry->next = -1;
+}
+
+static void route_cache_push_front(RouteCache* cache, int index) {
+    RouteCacheEntry* entry = &cache->entries[index];
+    entry->prev = -1;
+    entry->next = cache->head;
+    if (cache->head >= 0) cache->entries[cache->head].prev = index;
+    cache->head = index;
+    if (cache->tail < 0) cache->tail = index;
+}
+
+static void route_cache_touch(RouteCache* cache, int index) {
+    if (cache->head == index) return;
+    route_cache_unlink(cache, index);
+    route_cache_push_front(cache, index);
+}
+
+// Remove an entry from its bucket chain
+static void route_cache_unhash(RouteCache* cache, int index) {
+    int* link = &cache->buckets[cache->entries[index].hash & cache->bucketMask];
+    while (*link != index) link = &cache->entries[*link].hashNext;
+    *link = cache->entries[index].hashNext;
+}
+
+static int route_cache_find(const RouteCache* cache, unsigned int hash, const Graph* graph,
+                            int startId, int goalId, const AStarConfig* config) {
+    int index = cache->buckets[hash & cache->bucketMask];
+    while (index >= 0) {
+        if (route_cache_matches(&cache->entries[index], graph, startId, goalId, config)) {
+            return index;
+        }
+        index = cache->entries[index].hashNext;
+    }
+    return -1;
+}
+
+static bool route_cache_copy_path(const PathResult* source, PathResult* dest) {
+    *dest = *source;
+    dest->nodes = NULL;
+    dest->inArena = false;
+    if (source->length > 0 && source->nodes) {
+        dest->nodes = (int*)malloc(source->length * sizeof(int));
+        if (!dest->nodes) {
+            *dest = path_result_create();
+            return false;
+        }
+        memcpy(dest->nodes, source->nodes, source->length * sizeof(int));
+    }
+    return true;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+bool route_cache_init(RouteCache* cache, int capacity) {
+    if (!cache) return false;
+    memset(cache, 0, sizeof(*cache));
+    cache->head = -1;
+    cache->tail = -1;
+    
+    if (capacity <= 0) capacity = ROUTE_CACHE_DEFAULT_CAPACITY;
+    int bucketCount = 1;
+    while (bucketCount < capacity * 2) bucketCount *= 2;
+    
+    cache->entries = (RouteCacheEntry*)malloc(capacity * sizeof(RouteCacheEntry));
+    cache->buckets = (int*)malloc(bucketCount * sizeof(int));
+    if (!cache->entries || !cache->buckets) {
+        free(cache->entries);
+        free(cache->buckets);
+        cache->entries = NULL;
+        cache->buckets = NULL;
+        return false;
+    }
+    
+    cache->capacity = capacity;
+    cache->bucketMask = bucketCount - 1;
+    for (int i = 0; i < bucketCount; i++) cache->buckets[i] = -1;
+    return true;
+}
+
+void route_cache_free(RouteCache* cache) {
+    if (!cache) return;
+    for (int i = 0; i < cache->count; i++) {
+        path_result_free(&cache->entries[i].path);
+    }
+    free(cache->entries);
+    free(cache->buckets);
+    memset(cache, 0, sizeof(*cache));
+    cache->head = -1;
+    cache->tail = -1;
+}
+
+void route_cache_clear(RouteCache* cache) {
+    if (!cache) return;
+    for (int i = 0; i < cache->count; i++) {
+        path_result_free(&cache->entries[i].path);
+    }
+    if (cache->buckets) {
+        for (int i = 0; i <= cache->bucketMask; i++) cache->buckets[i] = -1;
+    }
+    cache->count = 0;
+    cache->head = -1;
+    cache->tail = -1;
+    memset(&cache->stats, 0, sizeof(cache->stats));
+}
+
+bool route_cache_lookup(RouteCache* cache, const Graph* graph, int startId, int goalId,
+                        const AStarConfig* config, PathResult* path, AStarStats* stats) {
+    if (!cache || !graph || !path) return false;
+    
+    double startTime = astar_time_ms();
+    AStarConfig cfg = config ? *config : astar_default_config();
+    
+    int index = -1;
+    if (cache->count > 0) {
+        index = route_cache_find(cache, route_cache_hash(graph, startId, goalId, &cfg),
+                                 graph, startId, goalId, &cfg);
+    }
+    if (index >= 0 && cache->entries[index].version != graph->version) {
+        cache->stats.stale++;
+        index = -1;
+    }
+    if (index < 0 || !route_cache_copy_path(&cache->entries[index].path, path)) {
+        cache->stats.misses++;
+        return false;
+    }
+    
+    cache->stats.hits++;
+    route_cache_touch(cache, index);
+    if (stats) {
+        *stats = cache->entries[index].stats;
+        stats->searchTimeMs = (float)(astar_time_ms() - startTime);
+    }
+    return true;
+}
+
+void route_cache_store(RouteCache* cache, const Graph* graph, int startId, int goalId,
+                       const AStarConfig* config, const PathResult* path, const AStarStats* stats) {
+    if (!cache || !graph || !path || cache->capacity == 0) return;
+    
+    AStarConfig cfg = config ? *config : astar_default_config();
+    unsigned int hash = route_cache_hash(graph, startId, goalId, &cfg);
+    
+    // Copy first, so a failed allocation leaves the cache as it was
+    PathResult copy;
+    if (!route_cache_copy_path(path, &copy)) return;
+    
+    // Reuse the entry of the same key (stale or not), then a free slot,
+    // then the least recently used one
+    int index = route_cache_find(cache, hash, graph, startId, goalId, &cfg);
+    if (index >= 0) {
+        path_result_free(&cache->entries[index].path);
+        route_cache_unhash(cache, index);
+        route_cache_unlink(cache, index);
+    } else if (cache->count < cache->capacity) {
+        index = cache->count++;
+    } else {
+        index = cache->tail;
+        path_result_free(&cache->entries[index].path);
+        route_cache_unhash(cache, index);
+        route_cache_unlink(cache, index);
+        cache->stats.evictions++;
+    }
+    
+    RouteCacheEntry* entry = &cache->entries[index];
+    entry->graph = graph;
+    entry->startId = startId;
+    entry->goalId = goalId;
+    entry->heuristic = cfg.heuristic;
+    entry->heuristicWeight = cfg.heuristicWeight;
+    entry->openSet = cfg.openSet;
+    entry->bucketWidth = route_cache_bucket_width(&cfg);
+    entry->bidirectional = cfg.bidirectional;
+    entry->landmarks = route_cache_landmarks(&cfg);
+    entry->version = graph->version;
+    entry->path = copy;
+    if (stats) entry->stats = *stats;
+    else memset(&entry->stats, 0, sizeof(entry->stats));
+    
+    entry->hash = hash;
+    entry->hashNext = cache->buckets[hash & cache->bucketMask];
+    cache->buckets[hash & cache->bucketMask] = index;
+    route_cache_push_front(cache, index);
+}
+
+PathResult route_cache_find_path(RouteCache* cache, AStarContext* ctx, const Graph* graph,
+                                 int startId, int goalId, const AStarConfig* config,
+                                 AStarStats* stats) {
+    PathResult result = path_result_create();
+    if (route_cache_lookup(cache, graph, startId, goalId, config, &result, stats)) {
+        AStarTrace* trace = config ? config->trace : NULL;
+        if (trace) {
+            trace->count = 0;
+            trace->total = 0;
+        }
+        return result;
+    }
+    
+    AStarStats localStats = {0};
+    if (ctx) {
+        result = astar_find_path_ctx(ctx, graph, startId, goalId, config, &localStats);
+    } else {
+        result = astar_find_path(graph, startId, goalId, config, &localStats);
+    }
+    
+    // An empty result without any search means bad IDs or no memory
+    if (result.found || localStats.nodesExplored > 0) {
+        route_cache_store(cache, graph, startId, goalId, config, &result, &localStats);
+    }
+    if (stats) *stats = localStats;
+    return result;
+}
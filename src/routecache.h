@@ -0,0 +1,125 @@
+/**
+ * routecache.h - LRU cache of route results
+ *
+ * Requests tend to repeat a small set of origin/destination pairs; the
+ * cache answers those from memory instead of searching again. Entries are
+ * keyed on the graph, start, goal and the AStarConfig fields that change
+ * the result (heuristic, weight, open set, direction, landmark table),
+ * and remember the graph's version when they were computed. Any graph_*
+ * call that edits the graph bumps its version, so a lookup after an
+ * edit misses and the entry is recomputed; nothing has to be flushed by
+ * hand.
+ *
+ * Rebuilding a landmark table in place without changing the graph, or
+ * reusing the address of a freed Graph for a new one, is not detected:
+ * call route_cache_clear in those cases.
+ *
+ * A cache is not thread-safe; use one per thread or guard it.
+ */
+
+#ifndef ROUTECACHE_H
+#define ROUTECACHE_H
+
+#include "graph.h"
+#include "astar.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ROUTE_CACHE_DEFAULT_CAPACITY 256
+
+// Lookup counters (kept since the cache was created or cleared)
+typedef struct {
+    int hits;
+    int misses;              // Includes the stale lookups
+    int stale;               // Misses on an entry from an older graph version
+    int evictions;           // Least recently used entries dropped for new ones
+} RouteCacheStats;
+
+// One cached query
+typedef struct {
+    // Key
+    const Graph* graph;
+    int startId;
+    int goalId;
+    HeuristicType heuristic;
+    float heuristicWeight;
+    PQType openSet;
+    float bucketWidth;       // Only set for PQ_BUCKET_QUEUE
+    bool bidirectional;
+    const LandmarkTable* landmarks;  // Only set for HEURISTIC_LANDMARKS
+    
+    unsigned int version;    // graph->version the result was computed for
+    PathResult path;         // Owned copy
+    AStarStats stats;        // Of the search that produced the path
+    
+    unsigned int hash;       // Of the key
+    int prev;                // LRU list neighbours (-1 at the ends)
+    int next;
+    int hashNext;            // Next entry in the same bucket (-1 ends)
+} RouteCacheEntry;
+
+typedef struct {
+    RouteCacheEntry* entries;
+    int capacity;
+    int count;
+    
+    int* buckets;            // Hash -> first entry, -1 if empty
+    int bucketMask;          // Bucket count - 1 (a power of two)
+    
+    int head;                // Most recently used entry (-1 if empty)
+    int tail;                // Least recently used entry
+    
+    RouteCacheStats stats;
+} RouteCache;
+
+/**
+ * Create a cache holding up to capacity routes
+ *
+ * @param capacity  Number of entries (ROUTE_CACHE_DEFAULT_CAPACITY if <= 0)
+ * @return          false on allocation failure (the cache is then empty
+ *                  and every query misses)
+ */
+bool route_cache_init(RouteCache* cache, int capacity);
+void route_cache_free(RouteCache* cache);
+
+// Drop every entry and reset the counters
+void route_cache_clear(RouteCache* cache);
+
+/**
+ * Copy the cached route for a query into path, if there is a fresh one
+ *
+ * @param stats     Receives the stats of the original search, with
+ *                  searchTimeMs set to the lookup time (can be NULL)
+ * @return          true on a hit; path is then a copy the caller frees
+ */
+bool route_cache_lookup(RouteCache* cache, const Graph* graph, int startId, int goalId,
+                        const AStarConfig* config, PathResult* path, AStarStats* stats);
+
+/**
+ * Remember the result of a query (replacing a stale entry for the same
+ * key, or evicting the least recently used one when full). Unfound routes
+ * are cached too.
+ */
+void route_cache_store(RouteCache* cache, const Graph* graph, int startId, int goalId,
+                       const AStarConfig* config, const PathResult* path, const AStarStats* stats);
+
+/**
+ * astar_find_path_ctx behind the cache: a hit returns a copy of the stored
+ * route, a miss searches and stores the result. A hit runs no search, so
+ * a trace in config is left empty and stats->nodesExplored reports the
+ * original search.
+ *
+ * @param ctx       Search context for misses (NULL to allocate one per miss)
+ * @return          PathResult containing the path (call path_result_free when done)
+ */
+PathResult route_cache_find_path(RouteCache* cache, AStarContext* ctx, const Graph* graph,
+                                 int startId, int goalId, const AStarConfig* config,
+                                 AStarStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ROUTECACHE_H
@@ -0,0 +1,236 @@
+/**
+ * searchworker.c - Background search thread and result slot
+ */
+
+#include "searchworker.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+struct SearchWorker {
+    // Main thread only
+    Thread thread;
+    bool running;                // Started and not joined yet
+    
+    // Set by search_worker_post before the thread starts, then read by it
+    GraphSnapshot* snapshot;     // Graph of the current (or last) search, held
+    int startId;
+    int goalId;
+    unsigned int graphVersion;
+    AStarConfig config;
+    AStarTraceEvent* events;     // Settle trace (grown by post, never while running)
+    int eventCapacity;
+    
+    // Used by the search thread while running, by the main thread when idle
+    AStarContext* ctx;
+    GraphCSR csr;                // Frozen from csrSnapshot
+    GraphSnapshot* csrSnapshot;  // Held, so its address is not reused while compared
+    AStarTrace trace;
+    LandmarkTable landmarks;
+    bool landmarksChecked;       // The table was compared with a snapshot of landmarksVersion
+    unsigned int landmarksVersion;
+    SearchResult result;
+    
+    // Shared
+    atomic_int phase;            // SearchPhase; SEARCH_PHASE_DONE publishes result
+    atomic_int progress;         // events[0 .. progress) are final
+};
+
+SearchWorker* search_worker_create(void) {
+    SearchWorker* worker = (SearchWorker*)calloc(1, sizeof(SearchWorker));
+    if (!worker) return NULL;
+    atomic_init(&worker->phase, SEARCH_PHASE_IDLE);
+    atomic_init(&worker->progress, 0);
+    worker->result.path = path_result_create();
+    return worker;
+}
+
+static void search_worker_join(SearchWorker* worker) {
+    if (!worker->running) return;
+    thread_join(&worker->thread);
+    worker->running = false;
+}
+
+void search_worker_free(SearchWorker* worker) {
+    if (!worker) return;
+    search_worker_join(worker);
+    path_result_free(&worker->result.path);  // A result nobody polled
+    graph_csr_free(&worker->csr);
+    graph_snapshot_release(worker->csrSnapshot);
+    graph_snapshot_release(worker->snapshot);
+    astar_context_free(worker->ctx);
+    landmarks_free(&worker->landmarks);
+    free(worker->events);
+    free(worker);
+}
+
+// Runs on the search thread after every stored settle event
+static void search_worker_publish(void* user, int count) {
+    SearchWorker* worker = (SearchWorker*)user;
+    atomic_store_explicit(&worker->progress, count, memory_order_release);
+}
+
+// Make the landmark table match the snapshot (once per graph version)
+static bool search_worker_check_landmarks(SearchWorker* worker) {
+    if (worker->landmarksChecked && worker->landmarksVersion == worker->graphVersion) {
+        return worker->landmarks.count > 0;
+    }
+    worker->landmarksChecked = true;
+    worker->landmarksVersion = worker->graphVersion;
+    
+    if (worker->landmarks.count > 0 && worker->landmarks.signature == landmarks_signature(&worker->csr)) {
+        return true;
+    }
+    LandmarkTable fresh;
+    bool built = landmarks_build(&worker->csr, LANDMARK_DEFAULT_COUNT, &fresh);
+    landmarks_free(&worker->landmarks);
+    if (built) worker->landmarks = fresh;
+    return worker->landmarks.count > 0;
+}
+
+// Freeze the posted snapshot, unless the CSR already holds it; the
+// snapshot never changes, so one freeze serves every search on it
+static bool search_worker_freeze(SearchWorker* worker) {
+    if (worker->csrSnapshot == worker->snapshot) return true;
+    graph_csr_free(&worker->csr);
+    graph_snapshot_release(worker->csrSnapshot);
+    worker->csrSnapshot = NULL;
+    if (!graph_freeze(graph_snapshot_graph(worker->snapshot), &worker->csr)) return false;
+    worker->csrSnapshot = graph_snapshot_retain(worker->snapshot);
+    return true;
+}
+
+static void search_worker_run(void* arg) {
+    SearchWorker* worker = (SearchWorker*)arg;
+    AStarConfig config = worker->config;
+    SearchResult* result = &worker->result;
+    memset(&result->stats, 0, sizeof(result->stats));
+    result->startId = worker->startId;
+    result->goalId = worker->goalId;
+    result->graphVersion = worker->graphVersion;
+    
+    // A snapshot that cannot be frozen leaves the path not found
+    if (!search_worker_freeze(worker)) {
+        result->path = path_result_create();
+        result->config = config;
+        result->exploredCount = 0;
+        atomic_store_explicit(&worker->phase, SEARCH_PHASE_DONE, memory_order_release);
+        return;
+    }
+    
+    if (config.heuristic == HEURISTIC_LANDMARKS) {
+        atomic_store_explicit(&worker->phase, SEARCH_PHASE_LANDMARKS, memory_order_relaxed);
+        if (search_worker_check_landmarks(worker)) {
+            config.landmarks = &worker->landmarks;
+        } else {
+            config.heuristic = HEURISTIC_EUCLIDEAN;
+            config.landmarks = NULL;
+        }
+    }
+    atomic_store_explicit(&worker->phase, SEARCH_PHASE_SEARCHING, memory_order_relaxed);
+    
+    memset(&worker->trace, 0, sizeof(worker->trace));
+    worker->trace.events = worker->events;
+    worker->trace.capacity = worker->eventCapacity;
+    worker->trace.kinds = ASTAR_TRACE_MASK(ASTAR_TRACE_SETTLE);
+    worker->trace.onRecord = search_worker_publish;
+    worker->trace.user = worker;
+    config.trace = &worker->trace;
+    config.arena = NULL;
+    
+    // A failed context leaves the path not found
+    if (!worker->ctx) worker->ctx = astar_context_create(worker->csr.nodeCount);
+    result->path = worker->ctx
+        ? astar_find_path_csr_ctx(worker->ctx, &worker->csr, worker->startId, worker->goalId,
+                                  &config, &result->stats)
+        : path_result_create();
+    
+    config.trace = NULL;
+    result->config = config;
+    result->exploredCount = worker->trace.count;
+    atomic_store_explicit(&worker->progress, worker->trace.count, memory_order_release);
+    atomic_store_explicit(&worker->phase, SEARCH_PHASE_DONE, memory_order_release);
+}
+
+bool search_worker_post(SearchWorker* worker, GraphStore* store, int startId, int goalId,
+                        const AStarConfig* config) {
+    if (!worker || !store) return false;
+    if (atomic_load_explicit(&worker->phase, memory_order_acquire) != SEARCH_PHASE_IDLE) return false;
+    search_worker_join(worker);
+    
+    GraphSnapshot* snapshot = graph_store_acquire(store);
+    if (!snapshot) return false;
+    const Graph* graph = graph_snapshot_graph(snapshot);
+    
+    // Each node settles at most once per direction
+    AStarConfig cfg = config ? *config : astar_default_config();
+    int capacity = graph->nodeCount * (cfg.bidirectional ? 2 : 1);
+    if (capacity > worker->eventCapacity) {
+        AStarTraceEvent* events = (AStarTraceEvent*)realloc(worker->events, capacity * sizeof(AStarTraceEvent));
+        if (!events) {
+            graph_snapshot_release(snapshot);
+            return false;
+        }
+        worker->events = events;
+        worker->eventCapacity = capacity;
+    }
+    
+    graph_snapshot_release(worker->snapshot);
+    worker->snapshot = snapshot;
+    worker->startId = startId;
+    worker->goalId = goalId;
+    worker->graphVersion = graph->version;
+    worker->config = cfg;
+    atomic_store_explicit(&worker->progress, 0, memory_order_relaxed);
+    atomic_store_explicit(&worker->phase, SEARCH_PHASE_SEARCHING, memory_order_relaxed);
+    
+    // Thread creation publishes everything written above
+    worker->running = thread_start(&worker->thread, search_worker_run, worker);
+    if (!worker->running) {
+        atomic_store_explicit(&worker->phase, SEARCH_PHASE_IDLE, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+SearchPhase search_worker_phase(const SearchWorker* worker) {
+    if (!worker) return SEARCH_PHASE_IDLE;
+    return (SearchPhase)atomic_load_explicit(&worker->phase, memory_order_acquire);
+}
+
+const AStarTraceEvent* search_worker_explored(const SearchWorker* worker, int* count) {
+    if (!worker) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    if (count) *count = atomic_load_explicit(&worker->progress, memory_order_acquire);
+    return worker->events;
+}
+
+bool search_worker_poll(SearchWorker* worker, SearchResult* result) {
+    if (!worker || atomic_load_explicit(&worker->phase, memory_order_acquire) != SEARCH_PHASE_DONE) {
+        return false;
+    }
+    search_worker_join(worker);
+    
+    if (result) {
+        *result = worker->result;
+    } else {
+        path_result_free(&worker->result.path);
+    }
+    worker->result.path = path_result_create();
+    atomic_store_explicit(&worker->phase, SEARCH_PHASE_IDLE, memory_order_relaxed);
+    return true;
+}
+
+void search_worker_wait(SearchWorker* worker) {
+    if (worker) search_worker_join(worker);
+}
+
+LandmarkTable* search_worker_landmarks(SearchWorker* worker) {
+    if (!worker) return NULL;
+    SearchPhase phase = (SearchPhase)atomic_load_explicit(&worker->phase, memory_order_acquire);
+    if (phase != SEARCH_PHASE_IDLE && phase != SEARCH_PHASE_DONE) return NULL;
+    return &worker->landmarks;
+}
@@ -0,0 +1,106 @@
+/**
+ * searchworker.h - Route searches off the calling thread
+ *
+ * Runs one traced A* search at a time on a background thread so an
+ * interactive caller (the GUI frame loop) never waits for it:
+ *
+ * - The caller publishes its graph to a GraphStore (snapshot.h) after
+ *   edits. search_worker_post acquires the current snapshot and starts the
+ *   search; the search thread freezes it into a GraphCSR (once per
+ *   snapshot), so the caller neither waits for the freeze nor has to stop
+ *   editing. Snapshots keep node IDs, so the result applies to the graph
+ *   as long as its version has not moved on.
+ * - While it runs, the settle events written so far can be read with
+ *   search_worker_explored: the search publishes its trace count after
+ *   every event, so the frontier can be drawn as it grows.
+ * - The finished result sits in a single-producer/single-consumer slot:
+ *   the worker fills it and then publishes the phase with a release store,
+ *   and search_worker_poll loads the phase with acquire before reading it.
+ *   No locks are taken on either side.
+ *
+ * HEURISTIC_LANDMARKS searches use a landmark table the worker owns. It is
+ * checked against each new graph version and rebuilt on the worker thread
+ * when it no longer matches.
+ */
+
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include "graph.h"
+#include "astar.h"
+#include "landmarks.h"
+#include "snapshot.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SEARCH_PHASE_IDLE,
+    SEARCH_PHASE_LANDMARKS,  // Checking or rebuilding the landmark table
+    SEARCH_PHASE_SEARCHING,
+    SEARCH_PHASE_DONE        // Result waiting for search_worker_poll
+} SearchPhase;
+
+// A finished search, handed over by search_worker_poll
+typedef struct {
+    int startId;
+    int goalId;
+    unsigned int graphVersion;   // Version of the snapshot searched
+    AStarConfig config;          // Settings actually used (the trace is cleared)
+    PathResult path;             // Owned by the receiver (call path_result_free)
+    AStarStats stats;
+    int exploredCount;           // Settle events left in search_worker_explored
+} SearchResult;
+
+typedef struct SearchWorker SearchWorker;
+
+SearchWorker* search_worker_create(void);
+void search_worker_free(SearchWorker* worker);  // Waits for a running search
+
+/**
+ * Start a search in the background
+ *
+ * @param store    Its current snapshot is searched (held until the next post)
+ * @param config   Search settings (NULL for defaults). The trace and arena
+ *                 are replaced by the worker's own; HEURISTIC_LANDMARKS uses
+ *                 the worker's table and falls back to Euclidean if it
+ *                 cannot be built.
+ * @return         false if a search is running or its result has not been
+ *                 polled yet, nothing was published, or on allocation or
+ *                 thread failure
+ */
+bool search_worker_post(SearchWorker* worker, GraphStore* store, int startId, int goalId,
+                        const AStarConfig* config);
+
+SearchPhase search_worker_phase(const SearchWorker* worker);
+
+// Settle events of the current (or last) search that are final; count
+// grows while the search runs. Valid until the next search_worker_post.
+const AStarTraceEvent* search_worker_explored(const SearchWorker* worker, int* count);
+
+/**
+ * Take the result of a finished search (non-blocking)
+ *
+ * @return  true once per search, when it has finished; the worker is then
+ *          idle again
+ */
+bool search_worker_poll(SearchWorker* worker, SearchResult* result);
+
+// Block until the running search (if any) is finished; poll still returns it
+void search_worker_wait(SearchWorker* worker);
+
+/**
+ * The worker's landmark table, to load or save it (NULL while a search
+ * runs). Searches compare it with their snapshot whenever the graph
+ * version changes, so a table loaded for another map is rebuilt rather
+ * than used. It is also the table SearchResult.config points to, for
+ * HEURISTIC_LANDMARKS route cache keys.
+ */
+LandmarkTable* search_worker_landmarks(SearchWorker* worker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEARCHWORKER_H
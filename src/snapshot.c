@@ -0,0 +1,292 @@
+/**
+ * snapshot.c - Copy-on-write graph snapshots and their store
+ */
+
+#include "snapshot.h"
+#include "thread.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Rows and names of one block of nodes, shared between snapshots
+typedef struct {
+    atomic_int refs;    // Snapshots using the block
+    Edge* edges;        // Out rows of the block's nodes, back to back
+    EdgeRef* inEdges;   // Reverse rows, back to back
+    char* names;        // NUL-terminated names, back to back
+} SnapshotBlock;
+
+struct GraphSnapshot {
+    Graph graph;        // Read-only view; its arrays are owned by the snapshot
+    const Graph* source;        // Graph it was built from
+    unsigned int sourceInstance; // Its instanceId at the time
+    atomic_int refs;
+    int blockCount;
+    SnapshotBlock** blocks;
+};
+
+struct GraphStore {
+    _Atomic(GraphSnapshot*) current;  // Holds one reference; only publish writes it
+    atomic_uint version;              // Version of current
+    atomic_uint epoch;                // Bumped by every publish
+    atomic_int readers[2];            // Acquires in progress, by epoch parity
+};
+
+// ============================================================================
+// Blocks
+// ============================================================================
+
+static void snapshot_block_release(SnapshotBlock* block) {
+    if (!block || atomic_fetch_sub_explicit(&block->refs, 1, memory_order_acq_rel) != 1) return;
+    free(block->edges);
+    free(block->inEdges);
+    free(block->names);
+    free(block);
+}
+
+// Copy the rows and names of nodes first .. last - 1 into a new block and
+// point the snapshot's per-node arrays at them
+static SnapshotBlock* snapshot_block_build(GraphSnapshot* snapshot, const Graph* graph, int first, int last) {
+    size_t edgeCount = 0;
+    size_t inEdgeCount = 0;
+    size_t nameBytes = 0;
+    for (int v = first; v < last; v++) {
+        edgeCount += (size_t)graph->edgeCounts[v];
+        inEdgeCount += (size_t)graph->inEdgeCounts[v];
+        nameBytes += strlen(graph->nodes[v].name ? graph->nodes[v].name : "") + 1;
+    }
+    
+    SnapshotBlock* block = (SnapshotBlock*)calloc(1, sizeof(SnapshotBlock));
+    if (!block) return NULL;
+    atomic_init(&block->refs, 1);
+    block->edges = edgeCount > 0 ? (Edge*)malloc(edgeCount * sizeof(Edge)) : NULL;
+    block->inEdges = inEdgeCount > 0 ? (EdgeRef*)malloc(inEdgeCount * sizeof(EdgeRef)) : NULL;
+    block->names = (char*)malloc(nameBytes);
+    if ((edgeCount > 0 && !block->edges) || (inEdgeCount > 0 && !block->inEdges) || !block->names) {
+        snapshot_block_release(block);
+        return NULL;
+    }
+    
+    // Rows are copied verbatim, tombstones included, so edge slots (and
+    // with them EdgeRefs and the edge ID index) stay valid
+    Graph* view = &snapshot->graph;
+    size_t edgeAt = 0;
+    size_t inEdgeAt = 0;
+    size_t nameAt = 0;
+    for (int v = first; v < last; v++) {
+        int count = graph->edgeCounts[v];
+        view->edges[v] = count > 0 ? block->edges + edgeAt : NULL;
+        if (count > 0) memcpy(view->edges[v], graph->edges[v], count * sizeof(Edge));
+        edgeAt += (size_t)count;
+    
+        count = graph->inEdgeCounts[v];
+        view->inEdges[v] = count > 0 ? block->inEdges + inEdgeAt : NULL;
+        if (count > 0) memcpy(view->inEdges[v], graph->inEdges[v], count * sizeof(EdgeRef));
+        inEdgeAt += (size_t)count;
+    
+        const char* name = graph->nodes[v].name ? graph->nodes[v].name : "";
+        size_t length = strlen(name) + 1;
+        memcpy(block->names + nameAt, name, length);
+        view->nodes[v].name = block->names + nameAt;
+        nameAt += length;
+    }
+    return block;
+}
+
+// ============================================================================
+// Snapshots
+// ============================================================================
+
+static void snapshot_destroy(GraphSnapshot* snapshot) {
+    for (int b = 0; b < snapshot->blockCount; b++) {
+        if (snapshot->blocks) snapshot_block_release(snapshot->blocks[b]);
+    }
+    free(snapshot->blocks);
+    
+    Graph* view = &snapshot->graph;
+    free(view->nodes);
+    free(view->nodeX);
+    free(view->nodeY);
+    free(view->activeBits);
+    free(view->edges);
+    free(view->edgeCounts);
+    free(view->inEdges);
+    free(view->inEdgeCounts);
+    free(view->edgeIndex);
+    free(snapshot);
+}
+
+// Copy bytes into a new allocation (NULL for zero bytes)
+static bool snapshot_dup(void** out, const void* src, size_t bytes) {
+    *out = NULL;
+    if (bytes == 0) return true;
+    *out = malloc(bytes);
+    if (!*out) return false;
+    if (src) memcpy(*out, src, bytes);
+    return true;
+}
+
+// Whether the snapshot was built from this graph instance (versions are
+// only comparable between states of the same instance)
+static bool snapshot_same_source(const GraphSnapshot* snapshot, const Graph* graph) {
+    return snapshot->source == graph && snapshot->sourceInstance == graph->instanceId;
+}
+
+/**
+ * Freeze the graph's current version
+ *
+ * @param prev  Earlier snapshot, whose unchanged blocks are shared when it
+ *              came from an older version of the same graph instance
+ *              (NULL to copy everything)
+ */
+static GraphSnapshot* snapshot_build(const Graph* graph, const GraphSnapshot* prev) {
+    if (prev && (!snapshot_same_source(prev, graph) || graph->version <= prev->graph.version ||
+                 !graph->blockVersions)) {
+        prev = NULL;
+    }
+    
+    GraphSnapshot* snapshot = (GraphSnapshot*)calloc(1, sizeof(GraphSnapshot));
+    if (!snapshot) return NULL;
+    atomic_init(&snapshot->refs, 1);
+    
+    int n = graph->nodeCount;
+    int words = (n + 31) / 32;
+    Graph* view = &snapshot->graph;
+    bool ok = snapshot_dup((void**)&view->nodes, graph->nodes, n * sizeof(Node)) &&
+              snapshot_dup((void**)&view->nodeX, graph->nodeX, n * sizeof(float)) &&
+              snapshot_dup((void**)&view->nodeY, graph->nodeY, n * sizeof(float)) &&
+              snapshot_dup((void**)&view->activeBits, graph->activeBits, words * sizeof(unsigned int)) &&
+              snapshot_dup((void**)&view->edges, NULL, n * sizeof(Edge*)) &&
+              snapshot_dup((void**)&view->edgeCounts, graph->edgeCounts, n * sizeof(int)) &&
+              snapshot_dup((void**)&view->inEdges, NULL, n * sizeof(EdgeRef*)) &&
+              snapshot_dup((void**)&view->inEdgeCounts, graph->inEdgeCounts, n * sizeof(int)) &&
+              snapshot_dup((void**)&view->edgeIndex, graph->edgeIndex, graph->edgeIdCount * sizeof(EdgeRef));
+    
+    int blockCount = (n + GRAPH_BLOCK_NODES - 1) >> GRAPH_BLOCK_SHIFT;
+    if (ok && blockCount > 0) {
+        snapshot->blocks = (SnapshotBlock**)calloc(blockCount, sizeof(SnapshotBlock*));
+        ok = snapshot->blocks != NULL;
+    }
+    snapshot->blockCount = snapshot->blocks ? blockCount : 0;
+    
+    for (int b = 0; ok && b < blockCount; b++) {
+        int first = b << GRAPH_BLOCK_SHIFT;
+        int last = first + GRAPH_BLOCK_NODES < n ? first + GRAPH_BLOCK_NODES : n;
+    
+        // A block is shared when it held the same nodes in prev and none of
+        // them changed since
+        int prevLast = -1;
+        if (prev && b < prev->blockCount) {
+            int prevN = prev->graph.nodeCount;
+            prevLast = first + GRAPH_BLOCK_NODES < prevN ? first + GRAPH_BLOCK_NODES : prevN;
+        }
+        if (prevLast == last && graph->blockVersions[b] <= prev->graph.version) {
+            snapshot->blocks[b] = prev->blocks[b];
+            atomic_fetch_add_explicit(&prev->blocks[b]->refs, 1, memory_order_relaxed);
+            for (int v = first; v < last; v++) {
+                view->edges[v] = prev->graph.edges[v];
+                view->inEdges[v] = prev->graph.inEdges[v];
+                view->nodes[v].name = prev->graph.nodes[v].name;
+            }
+        } else {
+            snapshot->blocks[b] = snapshot_block_build(snapshot, graph, first, last);
+            ok = snapshot->blocks[b] != NULL;
+        }
+    }
+    if (!ok) {
+        snapshot_destroy(snapshot);
+        return NULL;
+    }
+    
+    // Rows are exactly as long as their counts
+    view->nodeCount = n;
+    view->nodeCapacity = n;
+    view->edgeCapacities = view->edgeCounts;
+    view->inEdgeCapacities = view->inEdgeCounts;
+    view->edgeIdCount = graph->edgeIdCount;
+    view->edgeIdCapacity = graph->edgeIdCount;
+    view->deadNodes = graph->deadNodes;
+    view->deadEdges = graph->deadEdges;
+    view->version = graph->version;
+    view->structureVersion = graph->structureVersion;
+    view->instanceId = graph->instanceId;
+    snapshot->source = graph;
+    snapshot->sourceInstance = graph->instanceId;
+    return snapshot;
+}
+
+const Graph* graph_snapshot_graph(const GraphSnapshot* snapshot) {
+    return snapshot ? &snapshot->graph : NULL;
+}
+
+GraphSnapshot* graph_snapshot_retain(GraphSnapshot* snapshot) {
+    if (snapshot) atomic_fetch_add_explicit(&snapshot->refs, 1, memory_order_relaxed);
+    return snapshot;
+}
+
+void graph_snapshot_release(GraphSnapshot* snapshot) {
+    if (!snapshot || atomic_fetch_sub_explicit(&snapshot->refs, 1, memory_order_acq_rel) != 1) return;
+    snapshot_destroy(snapshot);
+}
+
+// ============================================================================
+// Store
+// ============================================================================
+
+GraphStore* graph_store_create(void) {
+    GraphStore* store = (GraphStore*)malloc(sizeof(GraphStore));
+    if (!store) return NULL;
+    atomic_init(&store->current, NULL);
+    atomic_init(&store->version, 0);
+    atomic_init(&store->epoch, 0);
+    atomic_init(&store->readers[0], 0);
+    atomic_init(&store->readers[1], 0);
+    return store;
+}
+
+void graph_store_free(GraphStore* store) {
+    if (!store) return;
+    graph_snapshot_release(atomic_load(&store->current));
+    free(store);
+}
+
+bool graph_store_publish(GraphStore* store, const Graph* graph) {
+    if (!store || !graph) return false;
+    GraphSnapshot* prev = atomic_load_explicit(&store->current, memory_order_relaxed);
+    if (prev && snapshot_same_source(prev, graph) && prev->graph.version == graph->version) return true;
+    
+    GraphSnapshot* fresh = snapshot_build(graph, prev);
+    if (!fresh) return false;
+    GraphSnapshot* old = atomic_exchange(&store->current, fresh);
+    atomic_store(&store->version, fresh->graph.version);
+    
+    // New acquires register under the next epoch; the ones that may have
+    // loaded the old pointer are counted under this one
+    unsigned int epoch = atomic_fetch_add(&store->epoch, 1);
+    while (atomic_load(&store->readers[epoch & 1]) > 0) thread_yield();
+    graph_snapshot_release(old);
+    return true;
+}
+
+GraphSnapshot* graph_store_acquire(GraphStore* store) {
+    if (!store) return NULL;
+    for (;;) {
+        unsigned int epoch = atomic_load(&store->epoch);
+        atomic_int* readers = &store->readers[epoch & 1];
+        atomic_fetch_add(readers, 1);
+    
+        // Counted under an epoch a publish has already moved past: its
+        // wait may be over, so register again under the new one
+        if (atomic_load(&store->epoch) != epoch) {
+            atomic_fetch_sub(readers, 1);
+            continue;
+        }
+        GraphSnapshot* snapshot = graph_snapshot_retain(atomic_load(&store->current));
+        atomic_fetch_sub(readers, 1);
+        return snapshot;
+    }
+}
+
+unsigned int graph_store_version(GraphStore* store) {
+    return store ? atomic_load(&store->version) : 0;
+}
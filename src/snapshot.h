@@ -0,0 +1,80 @@
+/**
+ * snapshot.h - Versioned, immutable graph snapshots
+ *
+ * Lets readers (search threads, batch workers, request handlers) keep
+ * running on a consistent graph while one writer goes on editing it:
+ *
+ * - The writer edits its Graph as usual and calls graph_store_publish.
+ *   That builds a frozen copy of the current version and swaps it in with
+ *   a single atomic exchange; readers are never blocked.
+ * - Readers call graph_store_acquire for a reference-counted snapshot and
+ *   use graph_snapshot_graph with every engine that takes a const Graph*.
+ *   The snapshot never changes; graph_snapshot_release drops it, and the
+ *   last reference frees it.
+ * - Consecutive snapshots share structure. Nodes are grouped in blocks of
+ *   GRAPH_BLOCK_NODES IDs, and a block's out-edge rows, reverse rows and
+ *   names live in one reference-counted allocation. The graph records the
+ *   version of the last change to each block (Graph.blockVersions), so a
+ *   publish only rebuilds the blocks changed since the previous snapshot
+ *   and points at the others. The dense per-node arrays (Node records,
+ *   coordinates, row pointers and counts) and the edge ID index are still
+ *   copied on every publish, as the search loops index them directly.
+ *
+ * Reclaiming the old snapshot is safe without locks: acquire registers in
+ * one of two reader counters chosen by the store's epoch, and publish
+ * bumps the epoch after the exchange and waits for the counter of the old
+ * epoch to drain. Only readers already inside acquire (a few
+ * instructions) are waited for.
+ *
+ * Snapshot graphs keep the writer's node and edge IDs, including
+ * inactive ones, and have no name or spatial index (lookups scan).
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GraphSnapshot GraphSnapshot;
+typedef struct GraphStore GraphStore;
+
+GraphStore* graph_store_create(void);
+void graph_store_free(GraphStore* store);  // No acquire may be running; held snapshots stay valid
+
+/**
+ * Publish the graph's current version
+ *
+ * Only one thread may publish to a store, and it should always publish
+ * the same graph. Blocks are only shared with the previous snapshot when
+ * it came from the same Graph instance (same address and instanceId);
+ * another graph, or the same one after graph_load or graph_compact, is
+ * copied in full. Publishing an unchanged version of the same instance
+ * does nothing.
+ *
+ * @param graph  Read only during the call
+ * @return       false on allocation failure (the previous snapshot stays current)
+ */
+bool graph_store_publish(GraphStore* store, const Graph* graph);
+
+// Current snapshot with a new reference (NULL if nothing was published);
+// safe from any thread, alongside publish
+GraphSnapshot* graph_store_acquire(GraphStore* store);
+
+// Version of the current snapshot (0 if nothing was published)
+unsigned int graph_store_version(GraphStore* store);
+
+// The frozen graph (never modify it); valid until the snapshot is released
+const Graph* graph_snapshot_graph(const GraphSnapshot* snapshot);
+
+GraphSnapshot* graph_snapshot_retain(GraphSnapshot* snapshot);  // Another reference
+void graph_snapshot_release(GraphSnapshot* snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNAPSHOT_H
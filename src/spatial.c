@@ -0,0 +1,405 @@
+/**
+ * spatial.c - Hashed uniform grid over node positions
+ */
+
+#include "spatial.h"
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#define SPATIAL_INITIAL_CELLS 64
+#define SPATIAL_CELL_LIMIT (1 << 30)  // Cell coordinates are clamped to +-this
+
+static int cell_coord(float v, float cellSize) {
+    float c = floorf(v / cellSize);
+    if (!(c > -SPATIAL_CELL_LIMIT)) return -SPATIAL_CELL_LIMIT;  // Also catches NaN
+    if (c > SPATIAL_CELL_LIMIT) return SPATIAL_CELL_LIMIT;
+    return (int)c;
+}
+
+static unsigned long long cell_key(int cx, int cy) {
+    return ((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy;
+}
+
+static unsigned int cell_hash(unsigned long long key, int capacity) {
+    unsigned long long h = key * 0x9E3779B97F4A7C15ull;
+    return (unsigned int)(h >> 32) & (unsigned int)(capacity - 1);
+}
+
+static bool spatial_node_live(const Graph* graph, int nodeId) {
+    return nodeId >= 0 && nodeId < graph->nodeCount && graph->nodes[nodeId].active;
+}
+
+// ============================================================================
+// Lifecycle
+// ============================================================================
+
+SpatialIndex* spatial_index_create(float cellSize) {
+    SpatialIndex* index = (SpatialIndex*)calloc(1, sizeof(SpatialIndex));
+    if (!index) return NULL;
+    
+    index->cells = (SpatialCell*)calloc(SPATIAL_INITIAL_CELLS, sizeof(SpatialCell));
+    if (!index->cells) {
+        free(index);
+        return NULL;
+    }
+    index->cellCapacity = SPATIAL_INITIAL_CELLS;
+    index->cellSize = cellSize > 0.0f ? cellSize : SPATIAL_DEFAULT_CELL_SIZE;
+    return index;
+}
+
+static void cells_free(SpatialCell* cells, int capacity) {
+    for (int i = 0; i < capacity; i++) {
+        free(cells[i].entries);
+    }
+    free(cells);
+}
+
+void spatial_index_free(SpatialIndex* index) {
+    if (!index) return;
+    cells_free(index->cells, index->cellCapacity);
+    free(index);
+}
+
+// ============================================================================
+// Cell table
+// ============================================================================
+
+static const SpatialCell* cells_find(const SpatialIndex* index, int cx, int cy) {
+    unsigned long long key = cell_key(cx, cy);
+    unsigned int mask = (unsigned int)index->cellCapacity - 1;
+    unsigned int s = cell_hash(key, index->cellCapacity);
+    while (index->cells[s].used) {
+        if (index->cells[s].key == key) return &index->cells[s];
+        s = (s + 1) & mask;
+    }
+    return NULL;
+}
+
+static bool cells_grow(SpatialIndex* index) {
+    int capacity = index->cellCapacity * 2;
+    SpatialCell* cells = (SpatialCell*)calloc(capacity, sizeof(SpatialCell));
+    if (!cells) return false;
+    
+    unsigned int mask = (unsigned int)capacity - 1;
+    for (int i = 0; i < index->cellCapacity; i++) {
+        if (!index->cells[i].used) continue;
+        unsigned int s = cell_hash(index->cells[i].key, capacity);
+        while (cells[s].used) s = (s + 1) & mask;
+        cells[s] = index->cells[i];
+    }
+    
+    free(index->cells);
+    index->cells = cells;
+    index->cellCapacity = capacity;
+    return true;
+}
+
+// Find or create the cell at (cx, cy)
+static SpatialCell* cells_get(SpatialIndex* index, int cx, int cy) {
+    if ((index->cellCount + 1) * 2 > index->cellCapacity && !cells_grow(index)) return NULL;
+    
+    unsigned long long key = cell_key(cx, cy);
+    unsigned int mask = (unsigned int)index->cellCapacity - 1;
+    unsigned int s = cell_hash(key, index->cellCapacity);
+    while (index->cells[s].used && index->cells[s].key != key) s = (s + 1) & mask;
+    
+    SpatialCell* cell = &index->cells[s];
+    if (!cell->used) {
+        cell->used = true;
+        cell->key = key;
+        if (index->cellCount == 0) {
+            index->minCellX = index->maxCellX = cx;
+            index->minCellY = index->maxCellY = cy;
+        } else {
+            if (cx < index->minCellX) index->minCellX = cx;
+            if (cx > index->maxCellX) index->maxCellX = cx;
+            if (cy < index->minCellY) index->minCellY = cy;
+            if (cy > index->maxCellY) index->maxCellY = cy;
+        }
+        index->cellCount++;
+    }
+    return cell;
+}
+
+static bool cell_append(SpatialCell* cell, SpatialEntry entry) {
+    if (cell->count >= cell->capacity) {
+        int capacity = cell->capacity > 0 ? cell->capacity * 2 : SPATIAL_TARGET_PER_CELL;
+        SpatialEntry* entries = (SpatialEntry*)realloc(cell->entries, capacity * sizeof(SpatialEntry));
+        if (!entries) return false;
+        cell->entries = entries;
+        cell->capacity = capacity;
+    }
+    cell->entries[cell->count++] = entry;
+    return true;
+}
+
+static bool index_insert(SpatialIndex* index, SpatialEntry entry) {
+    SpatialCell* cell = cells_get(index, cell_coord(entry.x, index->cellSize),
+                                  cell_coord(entry.y, index->cellSize));
+    if (!cell || !cell_append(cell, entry)) return false;
+    index->count++;
+    return true;
+}
+
+/**
+ * Re-fit the cell size to the current points and rebucket them
+ *
+ * On failure the index is left as it was.
+ */
+static bool index_regrid(SpatialIndex* index) {
+    SpatialEntry* all = (SpatialEntry*)malloc(index->count * sizeof(SpatialEntry));
+    if (!all) return false;
+    
+    int n = 0;
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < index->cellCapacity; i++) {
+        const SpatialCell* cell = &index->cells[i];
+        for (int j = 0; j < cell->count; j++) {
+            SpatialEntry e = cell->entries[j];
+            all[n++] = e;
+            if (e.x < minX) minX = e.x;
+            if (e.x > maxX) maxX = e.x;
+            if (e.y < minY) minY = e.y;
+            if (e.y > maxY) maxY = e.y;
+        }
+    }
+    
+    // Side of a square holding SPATIAL_TARGET_PER_CELL points on average
+    // (points on a line spread over its length instead)
+    float cellSize = index->cellSize;
+    float w = maxX - minX;
+    float h = maxY - minY;
+    if (w > 0.0f && h > 0.0f) {
+        cellSize = sqrtf(w * h * SPATIAL_TARGET_PER_CELL / n);
+    } else if (w > 0.0f || h > 0.0f) {
+        cellSize = (w > h ? w : h) * SPATIAL_TARGET_PER_CELL / n;
+    }
+    if (!(cellSize > 0.0f) || !isfinite(cellSize)) cellSize = index->cellSize;
+    
+    SpatialIndex fresh = {0};
+    int capacity = SPATIAL_INITIAL_CELLS;
+    while (capacity < n / SPATIAL_TARGET_PER_CELL * 2) capacity *= 2;
+    fresh.cells = (SpatialCell*)calloc(capacity, sizeof(SpatialCell));
+    fresh.cellCapacity = capacity;
+    fresh.cellSize = cellSize;
+    
+    bool ok = fresh.cells != NULL;
+    for (int i = 0; i < n && ok; i++) {
+        ok = index_insert(&fresh, all[i]);
+    }
+    free(all);
+    if (!ok) {
+        if (fresh.cells) cells_free(fresh.cells, fresh.cellCapacity);
+        return false;
+    }
+    
+    cells_free(index->cells, index->cellCapacity);
+    fresh.regridCount = fresh.count;
+    *index = fresh;
+    return true;
+}
+
+// ============================================================================
+// Maintenance
+// ============================================================================
+
+bool spatial_index_add(SpatialIndex* index, int nodeId, float x, float y) {
+    if (!index || nodeId < 0) return false;
+    
+    // Doubling keeps re-fitting amortized O(1) per add; a failed re-fit
+    // just keeps the old cell size
+    if (index->count >= SPATIAL_REGRID_MIN_COUNT && index->count >= index->regridCount * 2) {
+        if (!index_regrid(index)) index->regridCount = index->count;
+    }
+    
+    SpatialEntry entry = { nodeId, x, y };
+    return index_insert(index, entry);
+}
+
+void spatial_index_remove(SpatialIndex* index, int nodeId, float x, float y) {
+    if (!index) return;
+    
+    // Cells found through a const lookup are owned by the index
+    SpatialCell* cell = (SpatialCell*)cells_find(index, cell_coord(x, index->cellSize),
+                                                 cell_coord(y, index->cellSize));
+    if (!cell) return;
+    for (int i = 0; i < cell->count; i++) {
+        if (cell->entries[i].nodeId == nodeId) {
+            cell->entries[i] = cell->entries[--cell->count];
+            index->count--;
+            return;
+        }
+    }
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+typedef struct {
+    float x, y;
+    float bestDistSq;
+    int best;
+} NearestSearch;
+
+static void nearest_visit(const SpatialIndex* index, const Graph* graph, long long cx, long long cy,
+                          NearestSearch* search) {
+    const SpatialCell* cell = cells_find(index, (int)cx, (int)cy);
+    if (!cell) return;
+    
+    for (int i = 0; i < cell->count; i++) {
+        const SpatialEntry* e = &cell->entries[i];
+        if (!spatial_node_live(graph, e->nodeId)) continue;
+    
+        float dx = e->x - search->x;
+        float dy = e->y - search->y;
+        float distSq = dx * dx + dy * dy;
+        if (distSq < search->bestDistSq ||
+            (search->best >= 0 && distSq == search->bestDistSq && e->nodeId < search->best)) {
+            search->bestDistSq = distSq;
+            search->best = e->nodeId;
+        }
+    }
+}
+
+static long long spatial_max(long long a, long long b) {
+    return a > b ? a : b;
+}
+
+static long long spatial_min(long long a, long long b) {
+    return a < b ? a : b;
+}
+
+int spatial_index_nearest(const SpatialIndex* index, const Graph* graph, float x, float y, float maxRadius) {
+    if (!graph) return -1;
+    
+    NearestSearch search = { x, y, maxRadius < 0.0f ? FLT_MAX : maxRadius * maxRadius, -1 };
+    if (!index) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            if (!graph->nodes[i].active) continue;
+            float dx = graph->nodes[i].x - x;
+            float dy = graph->nodes[i].y - y;
+            float distSq = dx * dx + dy * dy;
+            if (distSq < search.bestDistSq) {
+                search.bestDistSq = distSq;
+                search.best = i;
+            }
+        }
+        return search.best;
+    }
+    if (index->count == 0) return -1;
+    long long cx = cell_coord(x, index->cellSize);
+    long long cy = cell_coord(y, index->cellSize);
+    
+    // Rings of cells at Chebyshev distance r around (cx, cy); only the
+    // rings that reach the occupied bounds are walked
+    long long outside = spatial_max(spatial_max(index->minCellX - cx, cx - index->maxCellX),
+                                    spatial_max(index->minCellY - cy, cy - index->maxCellY));
+    long long first = spatial_max(0, outside);
+    long long last = spatial_max(spatial_max(cx - index->minCellX, index->maxCellX - cx),
+                                 spatial_max(cy - index->minCellY, index->maxCellY - cy));
+    
+    for (long long r = first; r <= last; r++) {
+        // Everything in ring r is at least (r - 1) cells away
+        if (r > 0) {
+            float gap = (float)(r - 1) * index->cellSize;
+            if (gap * gap > search.bestDistSq) break;
+        }
+    
+        long long y0 = spatial_max(cy - r, index->minCellY);
+        long long y1 = spatial_min(cy + r, index->maxCellY);
+        for (long long gy = y0; gy <= y1; gy++) {
+            if (gy == cy - r || gy == cy + r) {
+                long long x0 = spatial_max(cx - r, index->minCellX);
+                long long x1 = spatial_min(cx + r, index->maxCellX);
+                for (long long gx = x0; gx <= x1; gx++) {
+                    nearest_visit(index, graph, gx, gy, &search);
+                }
+            } else {
+                if (cx - r >= index->minCellX) nearest_visit(index, graph, cx - r, gy, &search);
+                if (cx + r <= index->maxCellX) nearest_visit(index, graph, cx + r, gy, &search);
+            }
+        }
+    }
+    return search.best;
+}
+
+typedef struct {
+    float minX, minY, maxX, maxY;
+    float x, y;
+    float radiusSq;          // Negative for rectangle-only queries
+    int* results;
+    int maxResults;
+    int found;
+} RegionQuery;
+
+static void region_test(const Graph* graph, int nodeId, float x, float y, RegionQuery* query) {
+    if (x < query->minX || x > query->maxX || y < query->minY || y > query->maxY) return;
+    if (query->radiusSq >= 0.0f) {
+        float dx = x - query->x;
+        float dy = y - query->y;
+        if (dx * dx + dy * dy > query->radiusSq) return;
+    }
+    if (!spatial_node_live(graph, nodeId)) return;
+    if (query->found < query->maxResults) query->results[query->found] = nodeId;
+    query->found++;
+}
+
+static void region_visit(const Graph* graph, const SpatialCell* cell, RegionQuery* query) {
+    for (int i = 0; i < cell->count; i++) {
+        const SpatialEntry* e = &cell->entries[i];
+        region_test(graph, e->nodeId, e->x, e->y, query);
+    }
+}
+
+static int region_run(const SpatialIndex* index, const Graph* graph, RegionQuery* query) {
+    if (!graph) return 0;
+    if (!(query->minX <= query->maxX) || !(query->minY <= query->maxY)) return 0;
+    
+    if (!index) {
+        for (int i = 0; i < graph->nodeCount; i++) {
+            region_test(graph, i, graph->nodes[i].x, graph->nodes[i].y, query);
+        }
+        return query->found;
+    }
+    if (index->count == 0) return 0;
+    
+    long long gx0 = spatial_max(cell_coord(query->minX, index->cellSize), index->minCellX);
+    long long gy0 = spatial_max(cell_coord(query->minY, index->cellSize), index->minCellY);
+    long long gx1 = spatial_min(cell_coord(query->maxX, index->cellSize), index->maxCellX);
+    long long gy1 = spatial_min(cell_coord(query->maxY, index->cellSize), index->maxCellY);
+    if (gx0 > gx1 || gy0 > gy1) return 0;
+    
+    // A region covering more cells than are occupied is cheaper to answer
+    // by walking the occupied cells
+    if ((gx1 - gx0 + 1) * (gy1 - gy0 + 1) > index->cellCount) {
+        for (int s = 0; s < index->cellCapacity; s++) {
+            if (index->cells[s].used) region_visit(graph, &index->cells[s], query);
+        }
+        return query->found;
+    }
+    
+    for (long long gy = gy0; gy <= gy1; gy++) {
+        for (long long gx = gx0; gx <= gx1; gx++) {
+            const SpatialCell* cell = cells_find(index, (int)gx, (int)gy);
+            if (cell) region_visit(graph, cell, query);
+        }
+    }
+    return query->found;
+}
+
+int spatial_index_query_radius(const SpatialIndex* index, const Graph* graph, float x, float y,
+                               float radius, int* results, int maxResults) {
+    if (!(radius >= 0.0f)) return 0;
+    RegionQuery query = { x - radius, y - radius, x + radius, y + radius, x, y,
+                          radius * radius, results, maxResults, 0 };
+    return region_run(index, graph, &query);
+}
+
+int spatial_index_query_rect(const SpatialIndex* index, const Graph* graph,
+                             float minX, float minY, float maxX, float maxY,
+                             int* results, int maxResults) {
+    RegionQuery query = { minX, minY, maxX, maxY, 0.0f, 0.0f, -1.0f, results, maxResults, 0 };
+    return region_run(index, graph, &query);
+}
@@ -0,0 +1,93 @@
+/**
+ * spatial.h - Uniform grid spatial index over node positions
+ *
+ * Nodes are bucketed into square cells; only occupied cells are stored,
+ * in a hash table keyed by cell coordinates, so the map can extend in any
+ * direction. Kept in sync by graph_add_node / graph_remove_node.
+ *
+ * The cell size starts at SPATIAL_DEFAULT_CELL_SIZE and is re-fitted to
+ * the point density (about SPATIAL_TARGET_PER_CELL nodes per cell) each
+ * time the number of indexed nodes doubles.
+ *
+ * Queries check the node's active flag, and ties on distance go to the
+ * lower node ID, so results match a linear scan over the graph. They
+ * accept a NULL index and then do exactly that scan.
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPATIAL_DEFAULT_CELL_SIZE 64.0f
+#define SPATIAL_TARGET_PER_CELL 4
+#define SPATIAL_REGRID_MIN_COUNT 64  // Below this the initial cell size is kept
+
+// A node position stored in a cell
+typedef struct {
+    int nodeId;
+    float x;
+    float y;
+} SpatialEntry;
+
+typedef struct {
+    unsigned long long key;  // Packed cell coordinates
+    bool used;
+    SpatialEntry* entries;
+    int count;
+    int capacity;
+} SpatialCell;
+
+struct SpatialIndex {
+    float cellSize;
+    
+    SpatialCell* cells;
+    int cellCapacity;        // Power of two
+    int cellCount;           // Cells ever occupied
+    
+    // Bounds of the occupied cells (never shrink)
+    int minCellX, minCellY;
+    int maxCellX, maxCellY;
+    
+    int count;               // Indexed nodes
+    int regridCount;         // count at the last re-fit of the cell size
+};
+
+// Lifecycle
+SpatialIndex* spatial_index_create(float cellSize);
+void spatial_index_free(SpatialIndex* index);
+
+// Maintenance (x/y must be the position the node was added with)
+bool spatial_index_add(SpatialIndex* index, int nodeId, float x, float y);
+void spatial_index_remove(SpatialIndex* index, int nodeId, float x, float y);
+
+/**
+ * Closest active node to (x, y) strictly within maxRadius
+ *
+ * @param maxRadius  Search radius, or a negative value for no limit
+ * @return           Node ID, or -1 if there is none
+ */
+int spatial_index_nearest(const SpatialIndex* index, const Graph* graph, float x, float y, float maxRadius);
+
+/**
+ * Active nodes within radius of (x, y), or inside [minX, maxX] x [minY, maxY]
+ *
+ * Results are in no particular order.
+ *
+ * @return  Number of matching nodes; only the first maxResults are written
+ */
+int spatial_index_query_radius(const SpatialIndex* index, const Graph* graph, float x, float y,
+                               float radius, int* results, int maxResults);
+int spatial_index_query_rect(const SpatialIndex* index, const Graph* graph,
+                             float minX, float minY, float maxX, float maxY,
+                             int* results, int maxResults);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPATIAL_H
@@ -0,0 +1,191 @@
+/**
+ * spt.c - One-to-all shortest path trees and isochrones
+ */
+
+#include "spt.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SPT_INITIAL_CAPACITY 64
+
+static bool spt_reserve(ShortestPathTree* tree, int capacity) {
+    if (capacity <= tree->capacity) return true;
+    
+    int* nodes = (int*)realloc(tree->nodes, capacity * sizeof(int));
+    if (!nodes) return false;
+    tree->nodes = nodes;
+    
+    float* dist = (float*)realloc(tree->dist, capacity * sizeof(float));
+    if (!dist) return false;
+    tree->dist = dist;
+    
+    int* parent = (int*)realloc(tree->parent, capacity * sizeof(int));
+    if (!parent) return false;
+    tree->parent = parent;
+    
+    tree->capacity = capacity;
+    return true;
+}
+
+// First entry with dist >= cost (count if none)
+static int spt_lower_bound(const ShortestPathTree* tree, float cost) {
+    int lo = 0;
+    int hi = tree->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (tree->dist[mid] < cost) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// First entry with dist > cost
+static int spt_upper_bound(const ShortestPathTree* tree, float cost) {
+    int lo = 0;
+    int hi = tree->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (tree->dist[mid] <= cost) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+bool graph_shortest_path_tree(
+    AStarContext* ctx,
+    const Graph* graph,
+    int source,
+    float maxCost,
+    bool reverse,
+    ShortestPathTree* tree
+) {
+    if (!tree) return false;
+    memset(tree, 0, sizeof(*tree));
+    tree->source = source;
+    tree->maxCost = maxCost;
+    tree->reverse = reverse;
+    if (!graph || source < 0 || source >= graph->nodeCount || !(maxCost >= 0.0f)) return false;
+    if (!GRAPH_NODE_ACTIVE(graph, source)) return false;
+    
+    AStarContext* owned = NULL;
+    if (!ctx) {
+        owned = astar_context_create(graph->nodeCount);
+        ctx = owned;
+    }
+    bool ok = ctx && astar_context_reset(ctx, graph->nodeCount, PQ_INDEXED_HEAP, false) &&
+              spt_reserve(tree, SPT_INITIAL_CAPACITY);
+    if (!ok) {
+        astar_context_free(owned);
+        spt_free(tree);
+        return false;
+    }
+    
+    // cameFrom holds the tree index of the predecessor, not its node ID
+    float* gScore = ctx->forward.gScore;
+    int* cameFrom = ctx->forward.cameFrom;
+    unsigned int* mark = ctx->forward.mark;
+    const unsigned int reached = ASTAR_MARK_REACHED(ctx);
+    const unsigned int settled = ASTAR_MARK_SETTLED(ctx);
+    PriorityQueue* openSet = &ctx->forward.openSet;
+    
+    gScore[source] = 0.0f;
+    cameFrom[source] = -1;
+    mark[source] = reached;
+    pq_push(openSet, source, 0.0f);
+    
+    while (!pq_empty(openSet)) {
+        int currentId;
+        float currentG;
+        pq_pop(openSet, &currentId, &currentG);
+    
+        // Only keys within the budget are pushed, so every pop joins the tree
+        if (tree->count == tree->capacity && !spt_reserve(tree, tree->capacity * 2)) {
+            ok = false;
+            break;
+        }
+        int index = tree->count++;
+        tree->nodes[index] = currentId;
+        tree->dist[index] = currentG;
+        tree->parent[index] = cameFrom[currentId];
+        mark[currentId] = settled;
+    
+        int count = reverse ? graph->inEdgeCounts[currentId] : graph->edgeCounts[currentId];
+        for (int i = 0; i < count; i++) {
+            const Edge* edge;
+            int neighborId;
+            if (reverse) {
+                const EdgeRef* ref = &graph->inEdges[currentId][i];
+                edge = &graph->edges[ref->from][ref->slot];
+                neighborId = ref->from;
+            } else {
+                edge = &graph->edges[currentId][i];
+                neighborId = edge->to;
+            }
+            if (!edge->active || !GRAPH_NODE_ACTIVE(graph, neighborId)) continue;
+    
+            unsigned int neighborMark = mark[neighborId];
+            if (neighborMark == settled) continue;
+    
+            float tentativeG = currentG + edge->weight;
+            if (tentativeG > maxCost) continue;
+            if (neighborMark == reached && tentativeG >= gScore[neighborId]) continue;
+    
+            gScore[neighborId] = tentativeG;
+            cameFrom[neighborId] = index;
+            mark[neighborId] = reached;
+            pq_update(openSet, neighborId, tentativeG);
+        }
+    }
+    
+    astar_context_free(owned);
+    if (!ok) spt_free(tree);
+    return ok;
+}
+
+void spt_free(ShortestPathTree* tree) {
+    if (!tree) return;
+    free(tree->nodes);
+    free(tree->dist);
+    free(tree->parent);
+    tree->nodes = NULL;
+    tree->dist = NULL;
+    tree->parent = NULL;
+    tree->count = 0;
+    tree->capacity = 0;
+}
+
+int spt_isochrone(const ShortestPathTree* tree, float minCost, float maxCost,
+                  int* nodes, int maxNodes) {
+    if (!tree || tree->count == 0 || !(minCost <= maxCost)) return 0;
+    
+    int first = spt_lower_bound(tree, minCost);
+    int last = spt_upper_bound(tree, maxCost);
+    int count = last > first ? last - first : 0;
+    if (nodes) {
+        int n = count < maxNodes ? count : maxNodes;
+        if (n > 0) memcpy(nodes, tree->nodes + first, n * sizeof(int));
+    }
+    return count;
+}
+
+PathResult spt_path(const ShortestPathTree* tree, int index) {
+    PathResult result = path_result_create();
+    if (!tree || index < 0 || index >= tree->count) return result;
+    
+    int length = 0;
+    for (int i = index; i >= 0; i = tree->parent[i]) length++;
+    
+    result.nodes = (int*)malloc(length * sizeof(int));
+    if (!result.nodes) return result;
+    result.length = length;
+    result.found = true;
+    result.totalCost = tree->dist[index];
+    
+    // Parents lead back to the source: fill from the end for a forward
+    // tree, from the front for a reverse one (whose route ends there)
+    int k = 0;
+    for (int i = index; i >= 0; i = tree->parent[i], k++) {
+        result.nodes[tree->reverse ? k : length - 1 - k] = tree->nodes[i];
+    }
+    return result;
+}
@@ -0,0 +1,90 @@
+/**
+ * spt.h - One-to-all shortest path trees and isochrones
+ *
+ * A single Dijkstra from one source, bounded by a cost budget, answers
+ * "everything reachable within cost C of X" for catchment analysis in
+ * one pass instead of one point query per candidate.
+ *
+ * The tree lists the settled nodes in settle order, which is also
+ * nondecreasing distance, so the nodes of any cost band form one
+ * contiguous run. Predecessors are stored as indices into the same lists;
+ * walking them back from an entry yields the route without a per-node
+ * lookup table.
+ */
+
+#ifndef SPT_H
+#define SPT_H
+
+#include "graph.h"
+#include "astar.h"
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPT_UNBOUNDED INFINITY   // maxCost for a full one-to-all search
+
+// Settled part of a shortest path tree
+typedef struct {
+    int* nodes;              // Node IDs by nondecreasing distance (nodes[0] is the source)
+    float* dist;             // dist[i]: cost between the source and nodes[i]
+    int* parent;             // parent[i]: index of the predecessor entry (-1 for the source)
+    int count;
+    int capacity;
+    
+    int source;
+    float maxCost;
+    bool reverse;            // Costs are towards the source instead of from it
+} ShortestPathTree;
+
+/**
+ * Build the shortest path tree of all nodes within maxCost of source
+ *
+ * With reverse set the search follows incoming edges, so dist is the
+ * cost of reaching the source (who can get to X within C) rather than
+ * of leaving it. Nodes at exactly maxCost are included.
+ *
+ * @param ctx       Search context to reuse (NULL to allocate one for the call)
+ * @param graph     The graph to search
+ * @param source    Root node ID
+ * @param maxCost   Cost budget (SPT_UNBOUNDED for every reachable node)
+ * @param reverse   Follow incoming instead of outgoing edges
+ * @param tree      Output (free with spt_free; empty on failure)
+ * @return          false on invalid arguments or allocation failure
+ */
+bool graph_shortest_path_tree(
+    AStarContext* ctx,
+    const Graph* graph,
+    int source,
+    float maxCost,
+    bool reverse,
+    ShortestPathTree* tree
+);
+
+void spt_free(ShortestPathTree* tree);
+
+/**
+ * List the nodes whose distance lies in [minCost, maxCost] (an isochrone
+ * band; use minCost 0 for the whole area inside maxCost)
+ *
+ * @param nodes     Output node IDs, by distance (can be NULL to just count)
+ * @param maxNodes  Capacity of nodes
+ * @return          Number of nodes in the band (may exceed maxNodes)
+ */
+int spt_isochrone(const ShortestPathTree* tree, float minCost, float maxCost,
+                  int* nodes, int maxNodes);
+
+/**
+ * Route between the source and tree entry `index`, in travel order (from
+ * the source for forward trees, towards it for reverse ones)
+ *
+ * @return  The path (call path_result_free when done); not found for a bad index
+ */
+PathResult spt_path(const ShortestPathTree* tree, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SPT_H
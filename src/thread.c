@@ -0,0 +1,78 @@
+/**
+ * thread.c - Portable thread implementation
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#endif
+
+#include "thread.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI thread_trampoline(LPVOID param) {
+    Thread* thread = (Thread*)param;
+    thread->func(thread->arg);
+    return 0;
+}
+#else
+static void* thread_trampoline(void* param) {
+    Thread* thread = (Thread*)param;
+    thread->func(thread->arg);
+    return NULL;
+}
+#endif
+
+bool thread_start(Thread* thread, ThreadFunc func, void* arg) {
+    if (!thread || !func) return false;
+    thread->func = func;
+    thread->arg = arg;
+    
+#ifdef _WIN32
+    thread->handle = (ThreadHandle)CreateThread(NULL, 0, thread_trampoline, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create(&thread->handle, NULL, thread_trampoline, thread) == 0;
+#endif
+}
+
+void thread_join(Thread* thread) {
+    if (!thread) return;
+#ifdef _WIN32
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+void thread_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+int thread_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? count : 1;
+}
+
+int thread_worker_count(int requested, int jobs) {
+    int count = requested > 0 ? requested : thread_cpu_count();
+    if (count > jobs) count = jobs;
+    return count > 0 ? count : 1;
+}
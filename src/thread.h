@@ -0,0 +1,51 @@
+/**
+ * thread.h - Minimal portable threads
+ *
+ * Just enough of a threading layer for the batch engines: start a worker,
+ * wait for it, and ask how many cores there are. Uses pthreads on
+ * Linux/macOS and Win32 threads on Windows.
+ */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#include <stdbool.h>
+
+#ifdef _WIN32
+typedef void* ThreadHandle;  // HANDLE, without pulling in windows.h
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*ThreadFunc)(void* arg);
+
+typedef struct {
+    ThreadHandle handle;
+    ThreadFunc func;
+    void* arg;
+} Thread;
+
+// Start func(arg) on a new thread. The Thread must stay alive until joined.
+bool thread_start(Thread* thread, ThreadFunc func, void* arg);
+void thread_join(Thread* thread);
+
+// Give up the rest of the time slice (for short spin waits)
+void thread_yield(void);
+
+// Number of online CPUs (at least 1)
+int thread_cpu_count(void);
+
+// Resolve a requested worker count: <= 0 means one per CPU, and there is
+// never more than one worker per job
+int thread_worker_count(int requested, int jobs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // THREAD_H
@@ -465,6 +465,12 @@ void ui_draw_arrow(float x1, float y1, float x2, float y2, float size, Color col
     DrawTriangle((Vector2){x2, y2}, p1, p2, color);
 }
 
+void ui_draw_spinner(float x, float y, float radius, float time, Color color) {
+    // A quarter-turn gap that sweeps around once a second
+    float start = fmodf(time * 360.0f, 360.0f);
+    DrawRing((Vector2){x, y}, radius - 3.0f, radius, start, start + 270.0f, 24, color);
+}
+
 // ============ Animation Helpers ============
 
 void ui_anim_update(AnimValue* anim, float deltaTime) {
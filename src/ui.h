@@ -140,6 +140,7 @@ void ui_draw_node(float x, float y, float radius, Color color, bool selected, bo
 void ui_draw_edge(float x1, float y1, float x2, float y2, float thickness, Color color);
 void ui_draw_path_segment(float x1, float y1, float x2, float y2, float thickness, Color color, float progress);
 void ui_draw_arrow(float x1, float y1, float x2, float y2, float size, Color color);
+void ui_draw_spinner(float x, float y, float radius, float time, Color color);  // Busy indicator
 
 // Animation helpers
 void ui_anim_update(AnimValue* anim, float deltaTime);
@@ -11,9 +11,33 @@
  *   gcc -O2 -I../src src/unity_build.c -o routecraft -lraylib [platform libs]
  */
 
+// POSIX APIs (clock_gettime, ...) must be visible before any system header
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 // Core modules
 #include "graph.c"
+#include "nameindex.c"
+#include "spatial.c"
+#include "graphfile.c"
+#include "import.c"
+#include "pqueue.c"
+#include "arena.c"
+#include "landmarks.c"
+#include "relax.c"
+#include "metrics.c"
 #include "astar.c"
+#include "dstar.c"
+#include "routecache.c"
+#include "spt.c"
+#include "ch.c"
+#include "crp.c"
+#include "thread.c"
+#include "matrix.c"
+#include "batch.c"
+#include "searchworker.c"
+#include "snapshot.c"
 
 // UI components  
 #include "ui.c"